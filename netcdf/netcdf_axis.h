@@ -0,0 +1,96 @@
+/**
+ * @file netcdf_axis.h
+ * Reads coordinate axes from netCDF files.
+ */
+#ifndef USML_NETCDF_AXIS_H
+#define USML_NETCDF_AXIS_H
+
+#include <netcdfcpp.h>
+#include <usml/ublas/ublas.h>
+#include <usml/types/types.h>
+
+namespace usml {
+namespace netcdf {
+
+using namespace usml::ublas ;
+using namespace usml::types ;
+
+/// @ingroup netcdf_files
+/// @{
+
+/**
+ * Reads coordinate axes from netCDF files.  The as_double(n) accessor
+ * of the netCDF C++ interface reads the whole variable from disk to
+ * extract a single value, so looping over it is quadratic in the size of
+ * the axis.  For high resolution products, like 15 arc-second bathymetry,
+ * that can dominate the load time.  These routines read each axis with
+ * a single get() call, and then work on the values in memory.
+ *
+ * Because all of the methods are declared static, the developer
+ * never actually creates a class of this type.
+ */
+class USML_DECLSPEC netcdf_axis {
+
+public:
+
+    /**
+     * Read all of the values of a one dimensional variable.
+     *
+     * @param  axis         NetCDF variable to read.
+     * @param  data         Values of the variable (output).
+     */
+    static void read( NcVar* axis, vector<double>& data ) {
+        const long N = axis->num_vals() ;
+        data.resize( N, false ) ;
+        if ( N > 0 ) axis->get( &data(0), N ) ;
+    }
+
+    /**
+     * Construct a seq_vector from the values of an axis.
+     * Inspects the data to see if seq_linear or seq_log can be
+     * used to optimize the performance of this axis.
+     *
+     * @param  data         Values of the axis.
+     * @return              Sequence vector equivalent.
+     */
+    static seq_vector* make( const vector<double>& data ) {
+        const size_t N = data.size() ;
+        if ( N < 2 ) return new seq_data( data ) ;
+
+        // single pass over the values, stop as soon as both
+        // the linear and logarithmic patterns have been ruled out
+
+        const double* p = &data(0) ;
+        bool isLinear = true ;
+        bool isLog = ( p[0] != 0.0 ) ;
+        for ( size_t n=2 ; n < N && ( isLinear || isLog ) ; ++n ) {
+            const double p1 = p[n-2] ;
+            const double p2 = p[n-1] ;
+            const double p3 = p[n] ;
+            if ( abs( ((p3-p2)-(p2-p1)) / p2 ) > 1E-4 ) {
+                isLinear = false ;
+            }
+            if ( p2 == 0.0 || abs( (p3/p2)-(p2/p1) ) > 1E-5 ) {
+                isLog = false ;
+            }
+        }
+
+        // build a new sequence for this axis
+
+        const double minValue = p[0] ;
+        const double maxValue = p[N-1] ;
+        if ( isLinear ) {
+            return new seq_linear( minValue, (maxValue-minValue)/(N-1), N ) ;
+        } else if ( isLog ) {
+            return new seq_log( minValue,
+                pow( maxValue/minValue, 1.0/(N-1) ), N ) ;
+        }
+        return new seq_data( data ) ;
+    }
+} ;
+
+/// @}
+}  // end of namespace netcdf
+}  // end of namespace usml
+
+#endif
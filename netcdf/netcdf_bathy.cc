@@ -3,6 +3,7 @@
  * Extracts bathymetry data from world-wide bathymetry databases.
  */
 #include <usml/netcdf/netcdf_bathy.h>
+#include <usml/netcdf/netcdf_axis.h>
 
 using namespace usml::netcdf ;
 
@@ -23,10 +24,16 @@ netcdf_bathy::netcdf_bathy(
     NcVar *longitude, *latitude, *altitude ;
     decode_filetype( file, &latitude, &longitude, &altitude ) ;
 
+    // read each axis in a single call
+
+    vector<double> latitudes, longitudes ;
+    netcdf_axis::read( latitude, latitudes ) ;
+    netcdf_axis::read( longitude, longitudes ) ;
+
     // manage wrap-around between eastern and western hemispheres
 
     double offset = 0.0 ;
-    if ( longitude->as_double(0) < 0.0 ) {
+    if ( longitudes(0) < 0.0 ) {
         // if database has a range (-180,180)
         // make western longitudes into negative numbers
         // unless they span the 180 latitude
@@ -44,9 +51,9 @@ netcdf_bathy::netcdf_bathy(
     // lat_first and lat_last are the integer offsets along this axis
     // _axis[0] is expressed as co-latitude in radians [0,PI]
 
-    double a = latitude->as_double(0) ;
-    int n = latitude->num_vals() - 1 ;
-    double inc = ( latitude->as_double(n) - a ) / n ;
+    double a = latitudes(0) ;
+    int n = (int) latitudes.size() - 1 ;
+    double inc = ( latitudes(n) - a ) / n ;
     const int lat_first = (int) floor( 1e-6 + (south-a) / inc ) ;
     const int lat_last = (int) floor( 0.5 + (north-a) / inc ) ;
     const int lat_num = lat_last - lat_first + 1 ;
@@ -59,9 +66,9 @@ netcdf_bathy::netcdf_bathy(
     // lng_first and lng_last are the integer offsets along this axis
     // _axis[1] is expressed as longtitude in radians [-PI,2*PI]
 
-    a = longitude->as_double(0) ;
-    n = longitude->num_vals() - 1 ;
-    inc = ( longitude->as_double(n) - a ) / n ;
+    a = longitudes(0) ;
+    n = (int) longitudes.size() - 1 ;
+    inc = ( longitudes(n) - a ) / n ;
     int lng_first = (int) floor( 1e-6 + (west-a) / inc ) ;
     if (lng_first < 0 ) {  // Prevent request for data outside
         lng_first = 0;     // of the data provided, on the left side.
@@ -79,7 +86,7 @@ netcdf_bathy::netcdf_bathy(
     // check to see if database has duplicate data at cut point
 
     int duplicate = 0 ;
-    if ( abs(longitude->as_double(0)+360-longitude->as_double(n)) < 1e-4 ) duplicate = 1 ;
+    if ( abs(longitudes(0)+360-longitudes(n)) < 1e-4 ) duplicate = 1 ;
 
     // load depth data out of NetCDF file
 
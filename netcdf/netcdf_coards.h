@@ -8,6 +8,7 @@
 #include <netcdfcpp.h>
 #include <usml/ublas/ublas.h>
 #include <usml/types/types.h>
+#include <usml/netcdf/netcdf_axis.h>
 
 namespace usml {
 namespace netcdf {
@@ -40,15 +41,17 @@ template< class DATA_TYPE, int NUM_DIMS > class netcdf_coards :
 
     /**
      * Construct a seq_vector from NetCDF dimension object.
-     * Inspects the data to see if seq_linear or seq_log can be
-     * used to optimize the performance of this dimension->
+     * Reads the axis in a single call, and inspects the data to see if
+     * seq_linear or seq_log can be used to optimize the performance
+     * of this dimension.
      *
      * @param  file         NetCDF file to process.
      * @param  dimension    NetCDF dimension. The COARDS spec assumes that
      *                      there is a NetCDF variable of the same name.
+     * @param  verbose      Print the size and range of the axis if true.
      * @return              Sequence vector equivalent.
      */
-    seq_vector* make_axis( NcFile& file, NcDim* dimension ) {
+    seq_vector* make_axis( NcFile& file, NcDim* dimension, bool verbose ) {
 
         // search for this axis in the NetCDF file
 
@@ -57,46 +60,20 @@ template< class DATA_TYPE, int NUM_DIMS > class netcdf_coards :
             throw std::invalid_argument("NetCDF variable not found");
         }
 
-        // search for linear or logrithmic pattern in this data
-
-        const int N = (int) axis->num_vals() ;
-        bool isLinear = true ;
-        bool isLog = true ;
-        boost::numeric::ublas::vector<double> data(N) ;
-
-        double p1 = axis->as_double(0) ; data(0) = p1 ;
-        double minValue = p1 ;
-        double maxValue = p1 ;
-
-        if ( N > 1 ) {
-            double p2 = axis->as_double(1) ; data(1) = p2 ;
-            for ( int n=2 ; n < N ; ++n ) {
-                double p3 = axis->as_double(n) ; data(n) = p3 ;
-                maxValue = p3 ;
-                // printf("diff[%d] = %f\n",n,p3-p2);
-                if ( abs( ((p3-p2)-(p2-p1)) / p2 ) > 1E-4 ) {
-                    isLinear = false ;
-                }
-                if ( p1 == 0.0 || p2 == 0.0 ||
-                    abs( (p3/p2)-(p2/p1) ) > 1E-5 )
-                {
-                    isLog = false ;
-                }
-                if ( ! ( isLinear || isLog ) ) break ;
-                p1 = p2 ;
-                p2 = p3 ;
-            }
-        }
-
         // build a new sequence for this axis
 
-        cout << axis->name() << " N=" << N << " minValue=" << minValue << " maxValue=" << maxValue << endl ;
-        if ( isLinear ) {
-            return new seq_linear( minValue, (maxValue-minValue)/(N-1), N ) ;
-        } else if ( isLog ) {
-            return new seq_log( minValue, (maxValue/minValue)/(N-1), N ) ;
+        vector<double> data ;
+        netcdf_axis::read( axis, data ) ;
+        seq_vector* result = netcdf_axis::make( data ) ;
+        if ( verbose ) {
+            cout << axis->name() << " N=" << data.size() ;
+            if ( data.size() > 0 ) {
+                cout << " minValue=" << data(0)
+                     << " maxValue=" << data(data.size()-1) ;
+            }
+            cout << endl ;
         }
-        return new seq_data( data ) ;
+        return result ;
     }
 
   public:
@@ -110,8 +87,11 @@ template< class DATA_TYPE, int NUM_DIMS > class netcdf_coards :
      * @param  name     	Name of the data grid to extract (case sensitive).
      * @param  read_fill	Read _FillValue from NetCDF file if true.
      * 						Use NAN as fill value if false.
+     * @param  verbose  	Print the size and range of each axis if true.
      */
-    netcdf_coards( NcFile& file, NcToken name, bool read_fill=false ) {
+    netcdf_coards( NcFile& file, NcToken name, bool read_fill=false,
+                   bool verbose=false )
+    {
 
         // search for this grid in the NetCDF file
 
@@ -124,7 +104,7 @@ template< class DATA_TYPE, int NUM_DIMS > class netcdf_coards :
 
         size_t N = 1 ;
         for ( int n=0 ; n < NUM_DIMS ; ++n ) {
-            seq_vector* ax = make_axis( file, variable->get_dim(n) ) ;
+            seq_vector* ax = make_axis( file, variable->get_dim(n), verbose ) ;
             this->_axis[n] = ax ;
             N *= this->_axis[n]->size() ;
         }
@@ -154,17 +134,17 @@ template< class DATA_TYPE, int NUM_DIMS > class netcdf_coards :
         // copy interpolant data from the NetCDF file into local memory.
         // replace missing data with fill value
 
-        NcValues* values = variable->values() ;
         this->_data = new DATA_TYPE[N] ;
-        for ( unsigned n=0 ; n < N ; ++n ) {
-            this->_data[n] = (DATA_TYPE) values->as_double(n) ;
-            if ( ! isnan(missing) ) {
-            	if ( this->_data[n] == missing ) {
-            		this->_data[n] = filling ;
-            	}
+        long* edges = variable->edges() ;
+        variable->get( this->_data, edges ) ;
+        delete[] edges ;
+        if ( ! isnan(missing) ) {
+            for ( size_t n=0 ; n < N ; ++n ) {
+                if ( this->_data[n] == missing ) {
+                    this->_data[n] = filling ;
+                }
             }
         }
-        delete values ;
     }
 } ;
 
@@ -13,6 +13,7 @@
 #ifndef USML_NETCDF_FILES_H
 #define USML_NETCDF_FILES_H
 
+#include <usml/netcdf/netcdf_axis.h>
 #include <usml/netcdf/netcdf_coards.h>
 #include <usml/netcdf/netcdf_bathy.h>
 #include <usml/netcdf/netcdf_profile.h>
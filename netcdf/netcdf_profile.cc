@@ -3,9 +3,176 @@
  * Extracts ocean profile data from world-wide databases.
  */
 #include <usml/netcdf/netcdf_profile.h>
+#include <usml/netcdf/netcdf_axis.h>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <limits>
 
 using namespace usml::netcdf ;
 
+namespace {
+
+/**
+ * Computes the average at each depth in a block of depths,
+ * or replaces the missing values in that block with the average.
+ */
+struct level_block {
+    double* data ;
+    size_t plane ;
+    int first ;
+    int last ;
+    double* average ;
+    bool fill ;
+
+    void operator()() {
+        for ( int alt = first ; alt < last ; ++alt ) {
+            double* ptr = data + alt * plane ;
+            double* end = ptr + plane ;
+            if ( fill ) {
+                const double value = average[alt] ;
+                for ( ; ptr < end ; ++ptr ) {
+                    if ( isnan( *ptr ) ) *ptr = value ;
+                }
+            } else {
+                double sum = 0.0 ;
+                size_t number = 0 ;
+                for ( ; ptr < end ; ++ptr ) {
+                    if ( ! isnan( *ptr ) ) {
+                        sum += *ptr ;
+                        ++number ;
+                    }
+                }
+                average[alt] = ( number ) ? sum / number : NAN ;
+            }
+        }
+    }
+} ;
+
+/**
+ * Replaces the missing values in a block of depths with the nearest
+ * valid value at the same depth.  Uses a two pass distance transform
+ * on the latitude/longitude grid.  The first pass finds the nearest
+ * valid longitude in each row.  The second pass uses the lower envelope
+ * of parabolas, centered on each row, to find the closest of these
+ * candidates in each column.  Depths without any valid values are
+ * flagged, so that they can be copied from the depth above.
+ */
+struct nearest_block {
+    double* data ;
+    size_t num_lat ;
+    size_t num_lng ;
+    const double* lat_pos ;     // distance along latitude axis
+    const double* lng_scale ;   // longitude spacing in each row
+    int first ;
+    int last ;
+    char* empty ;
+
+    void operator()() {
+        const size_t plane = num_lat * num_lng ;
+        const double inf = std::numeric_limits<double>::infinity() ;
+        std::vector<double> row_dist( plane ) ;
+        std::vector<size_t> row_index( plane ) ;
+        std::vector<double> column( num_lat ) ;
+        std::vector<size_t> hull( num_lat ) ;
+        std::vector<double> bound( num_lat + 1 ) ;
+        std::vector<size_t> source( plane ) ;
+
+        for ( int alt = first ; alt < last ; ++alt ) {
+            double* level = data + alt * plane ;
+
+            // distance to nearest valid longitude in each row
+
+            bool valid = false ;
+            for ( size_t i=0 ; i < num_lat ; ++i ) {
+                const double* row = level + i * num_lng ;
+                double* dist = &row_dist[ i * num_lng ] ;
+                size_t* index = &row_index[ i * num_lng ] ;
+                size_t prev = num_lng ;
+                for ( size_t j=0 ; j < num_lng ; ++j ) {
+                    if ( ! isnan( row[j] ) ) prev = j ;
+                    index[j] = prev ;
+                }
+                size_t next = num_lng ;
+                for ( size_t j=num_lng ; j-- > 0 ; ) {
+                    if ( ! isnan( row[j] ) ) next = j ;
+                    if ( next < num_lng &&
+                         ( index[j] == num_lng || next - j < j - index[j] ) )
+                    {
+                        index[j] = next ;
+                    }
+                    if ( index[j] == num_lng ) {
+                        dist[j] = inf ;
+                    } else {
+                        const double d = lng_scale[i]
+                                       * ( (double) j - (double) index[j] ) ;
+                        dist[j] = d * d ;
+                        valid = true ;
+                    }
+                }
+            }
+            empty[alt] = ! valid ;
+            if ( ! valid ) continue ;
+
+            // lower envelope of parabolas down each column
+
+            for ( size_t j=0 ; j < num_lng ; ++j ) {
+                for ( size_t i=0 ; i < num_lat ; ++i ) {
+                    column[i] = row_dist[ i * num_lng + j ] ;
+                }
+                int k = -1 ;
+                for ( size_t i=0 ; i < num_lat ; ++i ) {
+                    if ( column[i] == inf ) continue ;
+                    const double fi = column[i] + lat_pos[i] * lat_pos[i] ;
+                    double edge = -inf ;
+                    while ( k >= 0 ) {
+                        const size_t h = hull[k] ;
+                        edge = ( fi - column[h] - lat_pos[h] * lat_pos[h] )
+                             / ( 2.0 * ( lat_pos[i] - lat_pos[h] ) ) ;
+                        if ( edge > bound[k] ) break ;
+                        --k ;
+                    }
+                    ++k ;
+                    hull[k] = i ;
+                    bound[k] = ( k == 0 ) ? -inf : edge ;
+                }
+                bound[k+1] = inf ;
+                int h = 0 ;
+                for ( size_t i=0 ; i < num_lat ; ++i ) {
+                    while ( bound[h+1] < lat_pos[i] ) ++h ;
+                    const size_t r = hull[h] ;
+                    source[ i * num_lng + j ] = r * num_lng
+                                              + row_index[ r * num_lng + j ] ;
+                }
+            }
+
+            // copy nearest value into each missing point
+
+            for ( size_t n=0 ; n < plane ; ++n ) {
+                if ( isnan( level[n] ) ) level[n] = level[ source[n] ] ;
+            }
+        }
+    }
+} ;
+
+/**
+ * Run each block in its own thread, or in the calling thread
+ * if there is only one block.
+ */
+template < class BLOCK >
+void run_blocks( std::vector<BLOCK>& blocks ) {
+    if ( blocks.size() < 2 ) {
+        blocks[0]() ;
+        return ;
+    }
+    boost::thread_group workers ;
+    for ( size_t b=0 ; b < blocks.size() ; ++b ) {
+        workers.create_thread( blocks[b] ) ;
+    }
+    workers.join_all() ;
+}
+
+}
+
 /**
  * Load ocean profile from disk.
  */
@@ -13,6 +180,32 @@ netcdf_profile::netcdf_profile(
     const char* profile, double date,
     double south, double north, double west, double east,
     double earth_radius )
+{
+    load( profile, date, south, north, west, east, earth_radius ) ;
+}
+
+/**
+ * Number of depth levels in a profile file.
+ */
+int netcdf_profile::num_levels( const char* profile ) {
+    double missing = NAN ;
+    NcVar *time, *altitude, *latitude, *longitude, *value ;
+    NcFile pfile( profile ) ;
+    if (pfile.is_valid() == 0) {
+        throw std::invalid_argument("file not found") ;
+    }
+    decode_filetype( pfile, &missing, &time, &altitude,
+                     &latitude, &longitude, &value ) ;
+    return (int) altitude->num_vals() ;
+}
+
+/**
+ * Load a range of depth levels from disk.
+ */
+int netcdf_profile::load(
+    const char* profile, double date,
+    double south, double north, double west, double east,
+    double earth_radius, int first, int last )
 {
     // initialize access to NetCDF file.
 
@@ -25,12 +218,20 @@ netcdf_profile::netcdf_profile(
     decode_filetype( pfile, &missing, &time, &altitude,
                      &latitude, &longitude, &value ) ;
 
+    // read each axis in a single call
+
+    vector<double> times, altitudes, latitudes, longitudes ;
+    netcdf_axis::read( time, times ) ;
+    netcdf_axis::read( altitude, altitudes ) ;
+    netcdf_axis::read( latitude, latitudes ) ;
+    netcdf_axis::read( longitude, longitudes ) ;
+
     // find the time closest to the specified value
 
     int time_index = 0 ;
-    double old_diff = abs( date - time->as_double(0) ) ;
-    for ( int t=1 ; t < time->num_vals() ; ++t ) {
-        double diff = abs( date - time->as_double(t) ) ;
+    double old_diff = abs( date - times(0) ) ;
+    for ( int t=1 ; t < (int) times.size() ; ++t ) {
+        double diff = abs( date - times(t) ) ;
         if ( old_diff > diff ) {
             old_diff = diff ;
             time_index = t ;
@@ -39,17 +240,24 @@ netcdf_profile::netcdf_profile(
 
     // read altitude axis data from NetCDF variable
 
-    const int alt_num = (int) altitude->num_vals() ;
-    vector<double> vect(alt_num) ;
-    for ( int d=0 ; d < alt_num ; ++d ) {
-        vect[d] = earth_radius - abs( altitude->as_double(d) ) ;
+    const int alt_num = (int) altitudes.size() ;
+    const bool define_axes = ( this->_axis[0] == NULL ) ;
+    if ( define_axes ) {
+        vector<double> vect(alt_num) ;
+        for ( int d=0 ; d < alt_num ; ++d ) {
+            vect[d] = earth_radius - abs( altitudes(d) ) ;
+        }
+        this->_axis[0] = new seq_data( vect ) ;
+    }
+    last = std::min( last, alt_num ) ;
+    if ( last > (int) this->_axis[0]->size() ) {
+        throw std::invalid_argument("more depths than the existing grid") ;
     }
-    this->_axis[0] = new seq_data( vect ) ;
 
     // manage wrap-around between eastern and western hemispheres
 
     double offset = 0.0 ;
-    if ( longitude->as_double(0) < 0.0 ) {
+    if ( longitudes(0) < 0.0 ) {
         // if database has a range (-180,180)
         // make western longitudes into negative numbers
         // unless they span the 180 latitude
@@ -67,34 +275,42 @@ netcdf_profile::netcdf_profile(
     // lat_first and lat_last are the integer offsets along this axis
     // _axis[1] is expressed as co-latitude in radians [0,PI]
 
-    double a = latitude->as_double(0) ;
-    int n = latitude->num_vals() - 1 ;
-    double inc = ( latitude->as_double(n) - a ) / n ;
+    double a = latitudes(0) ;
+    int n = (int) latitudes.size() - 1 ;
+    double inc = ( latitudes(n) - a ) / n ;
     const int lat_first = (int) floor( 1e-6 + (south-a) / inc ) ;
     const int lat_last = (int) floor( 0.5 + (north-a) / inc ) ;
     const int lat_num = lat_last - lat_first + 1 ;
-    this->_axis[1] = new seq_linear(
-        to_colatitude(lat_first*inc+a),
-        to_radians(-inc),
-        lat_num );
+    if ( define_axes ) {
+        this->_axis[1] = new seq_linear(
+            to_colatitude(lat_first*inc+a),
+            to_radians(-inc),
+            lat_num );
+    }
 
     // read longitude axis data from NetCDF variable
     // lng_first and lng_last are the integer offsets along this axis
     // _axis[2] is expressed as longtitude in radians [-PI,2*PI]
 
-    a = longitude->as_double(0) ;
-    n = (int) longitude->num_vals() - 1 ;
-    inc = ( longitude->as_double(n) - a ) / n ;
+    a = longitudes(0) ;
+    n = (int) longitudes.size() - 1 ;
+    inc = ( longitudes(n) - a ) / n ;
     int lng_first = (int) floor( 1e-6 + (west-a) / inc ) ;
     if (lng_first < 0) {  // Prevent request for data outside
         lng_first = 0;    // of the data provided, on the left side.
     }
     const int lng_last = (int) floor( 0.5 + (east-a) / inc ) ;
     const int lng_num = lng_last - lng_first + 1 ;
-    this->_axis[2] = new seq_linear(
-        to_radians(lng_first*inc+a-offset),
-        to_radians(inc),
-        lng_num ) ;
+    if ( define_axes ) {
+        this->_axis[2] = new seq_linear(
+            to_radians(lng_first*inc+a-offset),
+            to_radians(inc),
+            lng_num ) ;
+    } else if ( lat_num != (int) this->_axis[1]->size()
+             || lng_num != (int) this->_axis[2]->size() )
+    {
+        throw std::invalid_argument("latitudes and longitudes do not match") ;
+    }
 
     // cout << " a=" << a << " n=" << n << " inc=" << inc << endl ;
     // cout << " lng_first=" << lng_first << " lng_last=" << lng_last << " lng_num=" << lng_num << endl ;
@@ -102,14 +318,20 @@ netcdf_profile::netcdf_profile(
     // check to see if database has duplicate data at cut point
 
     int duplicate = 0 ;
-    if ( abs(longitude->as_double(0)+360-longitude->as_double(n)) < 1e-4 ) duplicate = 1 ;
+    if ( abs(longitudes(0)+360-longitudes(n)) < 1e-4 ) duplicate = 1 ;
 
     // load profile data out of NetCDF variable
+    // directly into its place in the data grid
 
-    this->_data = new double[ alt_num * lat_num * lng_num ] ;
+    const int plane = lat_num * lng_num ;
+    if ( define_axes ) {
+        this->_data = new double[ alt_num * plane ] ;
+    }
+    if ( first >= last ) return alt_num ;
     if ( longitude->num_vals() > lng_last ) {
-        value->set_cur( time_index, 0, lat_first, lng_first ) ;
-        value->get( this->_data, 1, alt_num, lat_num, lng_num ) ;
+        value->set_cur( time_index, first, lat_first, lng_first ) ;
+        value->get( this->_data + first * plane,
+                    1, last - first, lat_num, lng_num ) ;
 
     // support datasets that cross the unwrapping longitude
     // assumes that bathy data is NOT repeated on both sides of cut point
@@ -117,9 +339,9 @@ netcdf_profile::netcdf_profile(
     } else {
         int M = lng_last - longitude->num_vals() + 1 ;  // # pts on east side
         int N = lng_num - M ;                           // # pts on west side
-        double* ptr = this->_data ;
+        double* ptr = this->_data + first * plane ;
         // cout << " N=" << N << " M=" << M << endl ;
-        for ( int alt = 0 ; alt < alt_num ; ++alt ) {
+        for ( int alt = first ; alt < last ; ++alt ) {
             for ( int lat = lat_first ; lat <= lat_last ; ++lat ) {
 
                 // the west side of the block is the portion from
@@ -142,80 +364,175 @@ netcdf_profile::netcdf_profile(
     // don't execute if netCDF file didn't specify a "missing" value
 
     if ( ! isnan(missing) ) {
-        const int N = alt_num * lat_num * lng_num ;
-        double* ptr = this->_data ;
-        while ( ptr < this->_data + N ) {
+        double* ptr = this->_data + first * plane ;
+        double* end = this->_data + last * plane ;
+        while ( ptr < end ) {
             if ( *ptr == missing ) *ptr = NAN ;
             ++ptr ;
         }
     }
+    return alt_num ;
 }
 
 /**
  * Fill missing values with average data at each depth.
  */
-void netcdf_profile::fill_missing() {
+void netcdf_profile::fill_missing( unsigned num_threads ) {
 
     const int alt_num = this->_axis[0]->size() ;
-    const int lat_num = this->_axis[1]->size() ;
-    const int lng_num = this->_axis[2]->size() ;
-    unsigned index[3] ;
+    const size_t plane = this->_axis[1]->size() * this->_axis[2]->size() ;
+
+    // split depths into blocks, one per thread
+
+    if ( num_threads == 0 ) {
+        num_threads = ( alt_num * plane < MIN_THREAD_SIZE ) ? 1u
+            : std::max( 1u, boost::thread::hardware_concurrency() ) ;
+    }
+    num_threads = std::min( num_threads, (unsigned) std::max( 1, alt_num ) ) ;
+
+    std::vector<level_block> blocks( num_threads ) ;
+    std::vector<double> average( alt_num ) ;
+    for ( unsigned b=0 ; b < num_threads ; ++b ) {
+        level_block& task = blocks[b] ;
+        task.data = this->_data ;
+        task.plane = plane ;
+        task.first = b * alt_num / num_threads ;
+        task.last = ( b + 1 ) * alt_num / num_threads ;
+        task.average = &average[0] ;
+        task.fill = false ;
+    }
 
     // compute average value at each depth
 
-    data_grid<double,1> average( this->_axis ) ;
-    data_grid<double,1> number( this->_axis ) ;
+    run_blocks( blocks ) ;
 
-    for ( int alt = 0 ; alt < alt_num ; ++alt ) {
-        index[0] = alt ;
+    // use value from previous depth if all lat/longs are NAN
 
-        // sum non-NAN data from all lat/longs
+    for ( int alt = 1 ; alt < alt_num ; ++alt ) {
+        if ( isnan( average[alt] ) ) average[alt] = average[alt-1] ;
+    }
 
-        for ( int lat = 0 ; lat < lat_num ; ++lat ) {
-            index[1] = lat ;
-            for ( int lng = 0 ; lng < lng_num ; ++lng ) {
-                index[2] = lng ;
-                double value = data(index) ;
-                if ( ! isnan( value ) ) {
-                    average.data( index, average.data(index)+value ) ;
-                    number.data( index, number.data(index)+1.0 ) ;
-                }
-            }
-        }
+    // fill in missing values with average values
 
-        // divide data sum by number of observations
-        // use value from previous depth if all lat/longs are NAN
+    for ( unsigned b=0 ; b < num_threads ; ++b ) {
+        blocks[b].fill = true ;
+    }
+    run_blocks( blocks ) ;
+}
 
-        if ( number.data(index) == 0.0 ) {
-            if ( index[0] <= 0 ) {
-                average.data( index, NAN ) ;
-            } else {
-                unsigned prev_index[1] ;
-                prev_index[0] = index[0] - 1 ;
-                average.data( index, average.data(prev_index) ) ;
-            }
-        } else {
-            average.data( index, average.data(index) / number.data(index) ) ;
-        }
+/**
+ * Fill missing values with the nearest valid value at each depth.
+ */
+void netcdf_profile::fill_nearest( unsigned num_threads ) {
+
+    const int alt_num = this->_axis[0]->size() ;
+    const seq_vector& theta = *this->_axis[1] ;
+    const seq_vector& phi = *this->_axis[2] ;
+    const size_t plane = theta.size() * phi.size() ;
+
+    // position along latitude axis, and longitude spacing in each row,
+    // both in radians of arc
+
+    std::vector<double> lat_pos( theta.size() ) ;
+    std::vector<double> lng_scale( theta.size() ) ;
+    const double lng_inc = ( phi.size() > 1 ) ? abs( phi[1] - phi[0] ) : 0.0 ;
+    for ( unsigned i=0 ; i < theta.size() ; ++i ) {
+        lat_pos[i] = abs( theta[i] - theta[0] ) ;
+        lng_scale[i] = lng_inc * sin( theta[i] ) ;
     }
 
-    // fill in missing values with average values
+    // split depths into blocks, one per thread
 
-    for ( int alt = 0 ; alt < alt_num ; ++alt ) {
-        index[0] = alt ;
-        for ( int lat = 0 ; lat < lat_num ; ++lat ) {
-            index[1] = lat ;
-            for ( int lng = 0 ; lng < lng_num ; ++lng ) {
-                index[2] = lng ;
-                double value = data(index) ;
-                if ( isnan( value ) ) {
-                    data( index, average.data(index) ) ;
-                }
-            }
+    if ( num_threads == 0 ) {
+        num_threads = ( alt_num * plane < MIN_THREAD_SIZE ) ? 1u
+            : std::max( 1u, boost::thread::hardware_concurrency() ) ;
+    }
+    num_threads = std::min( num_threads, (unsigned) std::max( 1, alt_num ) ) ;
+
+    std::vector<nearest_block> blocks( num_threads ) ;
+    std::vector<char> empty( alt_num ) ;
+    for ( unsigned b=0 ; b < num_threads ; ++b ) {
+        nearest_block& task = blocks[b] ;
+        task.data = this->_data ;
+        task.num_lat = theta.size() ;
+        task.num_lng = phi.size() ;
+        task.lat_pos = &lat_pos[0] ;
+        task.lng_scale = &lng_scale[0] ;
+        task.first = b * alt_num / num_threads ;
+        task.last = ( b + 1 ) * alt_num / num_threads ;
+        task.empty = &empty[0] ;
+    }
+    run_blocks( blocks ) ;
+
+    // use values from previous depth if all lat/longs are NAN
+
+    for ( int alt = 1 ; alt < alt_num ; ++alt ) {
+        if ( empty[alt] ) {
+            memcpy( this->_data + alt * plane, this->_data + (alt-1) * plane,
+                    plane * sizeof(double) ) ;
         }
     }
 }
 
+/**
+ * Write profile to a netCDF file.
+ */
+void netcdf_profile::write_netcdf(
+    const char* filename, double earth_radius ) const
+{
+    const seq_vector& rho = *this->_axis[0] ;
+    const seq_vector& theta = *this->_axis[1] ;
+    const seq_vector& phi = *this->_axis[2] ;
+
+    NcFile* nc_file = new NcFile(filename, NcFile::Replace);
+    nc_file->add_att("Conventions", "COARDS");
+
+    // dimensions and coordinates
+
+    NcDim *time_dim = nc_file->add_dim("time", 1);
+    NcDim *depth_dim = nc_file->add_dim("depth", rho.size());
+    NcDim *lat_dim = nc_file->add_dim("lat", theta.size());
+    NcDim *lng_dim = nc_file->add_dim("lon", phi.size());
+
+    NcVar *time_var = nc_file->add_var("time", ncDouble, time_dim);
+    NcVar *depth_var = nc_file->add_var("depth", ncDouble, depth_dim);
+    NcVar *lat_var = nc_file->add_var("lat", ncDouble, lat_dim);
+    NcVar *lng_var = nc_file->add_var("lon", ncDouble, lng_dim);
+    NcVar *value_var = nc_file->add_var("value", ncDouble,
+            time_dim, depth_dim, lat_dim, lng_dim);
+
+    depth_var->add_att("units", "meters");
+    depth_var->add_att("positive", "down");
+    lat_var->add_att("units", "degrees_north");
+    lng_var->add_att("units", "degrees_east");
+
+    // write each variable with a single put()
+    // latitudes and longitudes are rounded to remove the noise added by
+    // the conversion to radians, which would otherwise change the
+    // window selected when this file is read back in
+
+    double v = 0.0 ;
+    time_var->put(&v, 1);
+    std::vector<double> values( rho.size() ) ;
+    for ( unsigned n=0 ; n < rho.size() ; ++n ) {
+        values[n] = earth_radius - rho[n] ;
+    }
+    depth_var->put(&values[0], rho.size());
+    values.resize( theta.size() ) ;
+    for ( unsigned n=0 ; n < theta.size() ; ++n ) {
+        values[n] = round( 1e9 * to_latitude( theta[n] ) ) / 1e9 ;
+    }
+    lat_var->put(&values[0], theta.size());
+    values.resize( phi.size() ) ;
+    for ( unsigned n=0 ; n < phi.size() ; ++n ) {
+        values[n] = round( 1e9 * to_degrees( phi[n] ) ) / 1e9 ;
+    }
+    lng_var->put(&values[0], phi.size());
+    value_var->put(this->_data, 1, rho.size(), theta.size(), phi.size());
+
+    delete nc_file; // destructor frees all netCDF temp variables
+}
+
 /**
  * Deduces the variables to be loaded based on their dimensionality.
  */
@@ -8,6 +8,7 @@
 #include <netcdfcpp.h>
 #include <usml/ublas/ublas.h>
 #include <usml/types/types.h>
+#include <climits>
 
 namespace usml {
 namespace netcdf {
@@ -93,12 +94,97 @@ class USML_DECLSPEC netcdf_profile : public data_grid<double,3> {
      * Fill missing values with average data at each depth.
      * This is designed to smooth out sharp changes in the
      * near-bottom profile that do not correspond to
-     * physical phenomena.
+     * physical phenomena.  Each depth is independent, so large grids
+     * are split into blocks of depths that are processed in parallel.
+     *
+     * @param  num_threads  Number of threads to use. If zero, uses the
+     *                      number of hardware threads, or a single thread
+     *                      for grids too small to justify threading.
+     */
+    void fill_missing( unsigned num_threads = 0 ) ;
+
+    /**
+     * Fill missing values with the nearest valid value at each depth.
+     * Distances are measured along the surface of the earth, within the
+     * latitude/longitude window of this grid.  This preserves horizontal
+     * gradients near coastlines, where the average at each depth may be
+     * dominated by water far from the missing points.  The nearest
+     * valid point is found with a two pass distance transform, whose cost
+     * is proportional to the number of points at each depth, no matter how
+     * far the missing values are from valid data.  Each depth is
+     * independent, so large grids are split into blocks of depths that are
+     * processed in parallel.  Depths without any valid values are copied
+     * from the depth above.
+     *
+     * @param  num_threads  Number of threads to use. If zero, uses the
+     *                      number of hardware threads, or a single thread
+     *                      for grids too small to justify threading.
+     */
+    void fill_nearest( unsigned num_threads = 0 ) ;
+
+    /**
+     * Write profile to a netCDF file.  Uses a COARDS format that can
+     * be read back into a netcdf_profile.  Saving a profile after
+     * fill_missing() or fill_nearest(), and loading that file
+     * in later runs, avoids repeating the merge and fill processes.
+     *
+     * @param  filename     Name of the NetCDF file to write.
+     * @param  earth_radius Depth correction term used to load
+     *                      this profile (meters).
+     */
+    void write_netcdf( const char* filename,
+        double earth_radius=wposition::earth_radius ) const ;
+
+  protected:
+
+    /**
+     * Default constructor for sub-classes that control the loading
+     * process by calling load() themselves.
+     */
+    netcdf_profile() {}
+
+    /**
+     * Load a range of depths from disk, directly into the data grid.
+     * The first call defines the axes and allocates memory for every
+     * depth in the file.  Later calls read more depths into the same
+     * memory, from files that must have the same depths, latitudes,
+     * and longitudes.  Depths outside of the range are left untouched.
+     * Missing values are replaced by NAN.
+     *
+     * @param  profile      Name of the NetCDF file to load.
+     * @param  date         Extract data for the time closest to
+     *                      the specified date.
+     * @param  south        Lower limit for the latitude axis (degrees).
+     * @param  north        Upper limit for the latitude axis (degrees).
+     * @param  west         Lower limit for the longitude axis (degrees).
+     * @param  east         Upper limit for the longitude axis (degrees).
+     * @param  earth_radius Depth correction term (meters).
+     * @param  first        Index of the first depth to read.
+     * @param  last         One past the index of the last depth to read.
+     *                      Limited to the number of depths in the file.
+     * @return              Number of depths in the file.
+     * @throws std::invalid_argument if the file can not be read, or if it
+     *                      does not match the axes of an existing grid.
      */
-    void fill_missing() ;
+    int load(
+        const char* profile, double date,
+        double south, double north, double west, double east,
+        double earth_radius, int first=0, int last=INT_MAX ) ;
+
+    /**
+     * Number of depths in a profile file.
+     *
+     * @param  profile      Name of the NetCDF file to inspect.
+     * @return              Size of the depth axis.
+     * @throws std::invalid_argument if the file can not be read.
+     */
+    int num_levels( const char* profile ) ;
 
   private:
 
+    /** Minimum number of grid points needed to justify threading. */
+    static const size_t MIN_THREAD_SIZE = 1 << 16 ;
+
     /**
      * Deduces the variables to be loaded based on their dimensionality.
      * The first variable to have 4 dimensions is assumed to be the
@@ -13,20 +13,17 @@ netcdf_woa::netcdf_woa(
     const char* deep, const char* shallow, int month,
     double south, double north, double west, double east,
     double earth_radius )
-    : netcdf_profile(deep,(int)round(30.5*(month-0.5)),south,north,west,east,earth_radius)
 {
-    // replace beginning of deep data with shallow values
+    const double date = round( 30.5 * ( month - 0.5 ) ) ;
 
+    // read deep values below the depths covered by the shallow file,
+    // then read shallow values into the beginning of the same grid
+
+    const int num_shallow = ( shallow ) ? num_levels( shallow ) : 0 ;
+    load( deep, date, south, north, west, east, earth_radius, num_shallow ) ;
     if ( shallow ) {
-        netcdf_woa replace( shallow, NULL, month,
-            south, north, west, east, earth_radius ) ;
-            // work around protected nature of _data and _axis by using
-            // netcdf_woa for "replace" instead of netcdf_profile.
-        memcpy( this->_data, replace._data,
-                sizeof(double) *
-                replace.axis(0)->size() *
-                replace.axis(1)->size() *
-                replace.axis(2)->size() ) ;
+        load( shallow, date, south, north, west, east, earth_radius,
+              0, num_shallow ) ;
         fill_missing() ;
         interp_type(0,GRID_INTERP_PCHIP);// increase smoothness of depth interp
     }
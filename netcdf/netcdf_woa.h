@@ -82,6 +82,9 @@ class USML_DECLSPEC netcdf_woa : public netcdf_profile {
 
     /**
      * Load deep and shallow parts of WOA ocean profile from disk.
+     * The axes are defined by the deep file.  Only the depths below
+     * the bottom of the shallow file are read from the deep file, and the
+     * shallow depths are read directly into the beginning of the same grid.
      * Uses netcdf_profile.fill_missing() to automatically replace
      * missing (NaN) values with average data at each depth.  The
      * interpolation features of the data_grid superclass are setup to use
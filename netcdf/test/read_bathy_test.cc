@@ -248,6 +248,36 @@ BOOST_AUTO_TEST_CASE( read_coards ) {
 	}
 }
 
+/**
+ * Tests the spacing detection used by netcdf_coards to convert
+ * axis values into seq_linear, seq_log, or seq_data sequences.
+ */
+BOOST_AUTO_TEST_CASE( axis_spacing ) {
+    cout << "=== bathy_test: axis_spacing ===" << endl;
+    const int N = 1001 ;
+    vector<double> linear(N), log(N), other(N) ;
+    for ( int n=0 ; n < N ; ++n ) {
+        linear(n) = -160.0 + n / 240.0 ;
+        log(n) = 10.0 * pow( 1.02, n ) ;
+        other(n) = n * n + 1.0 ;
+    }
+
+    seq_vector* axis = netcdf_axis::make( linear ) ;
+    BOOST_CHECK( dynamic_cast<seq_linear*>(axis) != NULL ) ;
+    BOOST_CHECK_CLOSE( (*axis)(N-1), linear(N-1), 1e-10 ) ;
+    delete axis ;
+
+    axis = netcdf_axis::make( log ) ;
+    BOOST_CHECK( dynamic_cast<seq_log*>(axis) != NULL ) ;
+    BOOST_CHECK_CLOSE( (*axis)(N-1), log(N-1), 1e-8 ) ;
+    delete axis ;
+
+    axis = netcdf_axis::make( other ) ;
+    BOOST_CHECK( dynamic_cast<seq_data*>(axis) != NULL ) ;
+    BOOST_CHECK_EQUAL( (*axis)(N-1), other(N-1) ) ;
+    delete axis ;
+}
+
 /**
  * Tests the ability of the netcdf_bathy class to span a longitude
  * cut point in the database.  To test this, it reads data from ETOPO1
@@ -117,6 +117,73 @@ BOOST_AUTO_TEST_CASE( read_woa ) {
     }
 }
 
+/**
+ * Tests the splice of monthly (shallow) and seasonal (deep) data by
+ * netcdf_woa.  Compares the combined Hawaii temperatures to profiles
+ * loaded separately from each file.  Depths down to the bottom of the
+ * monthly file, including the 1500 meter seam, must match the monthly
+ * profile, and all deeper depths must match the seasonal profile,
+ * wherever the separate profiles are not missing.  Also checks that
+ * fill_missing() replaces every missing value, and that the
+ * multi-threaded fill gives the same answer as the single threaded one.
+ */
+BOOST_AUTO_TEST_CASE( splice_woa ) {
+    cout << "=== profile_test: splice_woa ===" << endl;
+    const int month = 6 ;
+    const double date = round( 30.5 * ( month - 0.5 ) ) ;
+    const double earth_radius = 6378137.0 ;
+    const char* deep = USML_DATA_DIR "/woa09/temperature_seasonal_1deg.nc" ;
+    const char* shallow = USML_DATA_DIR "/woa09/temperature_monthly_1deg.nc" ;
+    netcdf_woa profile( deep, shallow, month,
+        18.5, 22.5, 200.5, 205.5, earth_radius ) ;
+    netcdf_profile monthly( shallow, date,
+        18.5, 22.5, 200.5, 205.5, earth_radius ) ;
+    netcdf_profile seasonal( deep, date,
+        18.5, 22.5, 200.5, 205.5, earth_radius ) ;
+
+    // the seam is at the bottom of the monthly file
+
+    const unsigned num_alt = profile.axis(0)->size() ;
+    const unsigned num_shallow = monthly.axis(0)->size() ;
+    BOOST_REQUIRE_EQUAL( num_alt, seasonal.axis(0)->size() ) ;
+    BOOST_REQUIRE( num_shallow < num_alt ) ;
+    BOOST_CHECK_CLOSE( (*monthly.axis(0))(num_shallow-1) - earth_radius,
+                       -1500.0, 1e-6 ) ;
+    for ( unsigned n=0 ; n < num_alt ; ++n ) {
+        BOOST_CHECK_EQUAL( (*profile.axis(0))(n), (*seasonal.axis(0))(n) ) ;
+    }
+
+    unsigned index[3] ;
+    for ( index[0]=0 ; index[0] < num_alt ; ++index[0] ) {
+        const netcdf_profile& source =
+            ( index[0] < num_shallow ) ? monthly : seasonal ;
+        for ( index[1]=0 ; index[1] < profile.axis(1)->size() ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < profile.axis(2)->size() ; ++index[2] ) {
+                const double value = profile.data(index) ;
+                BOOST_CHECK( ! isnan(value) ) ;
+                if ( ! isnan( source.data(index) ) ) {
+                    BOOST_CHECK_EQUAL( value, source.data(index) ) ;
+                }
+            }
+        }
+    }
+
+    // fill the separate monthly profile with 1 and 4 threads
+
+    netcdf_profile threaded( shallow, date,
+        18.5, 22.5, 200.5, 205.5, earth_radius ) ;
+    monthly.fill_missing( 1 ) ;
+    threaded.fill_missing( 4 ) ;
+    for ( index[0]=0 ; index[0] < num_shallow ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < monthly.axis(1)->size() ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < monthly.axis(2)->size() ; ++index[2] ) {
+                BOOST_CHECK( ! isnan( monthly.data(index) ) ) ;
+                BOOST_CHECK_EQUAL( monthly.data(index), threaded.data(index) ) ;
+            }
+        }
+    }
+}
+
 /**
  * Tests the ability of the netcdf_profile class to span a longitude
  * cut point in the database.  To test this, it reads data from WOA09
@@ -210,6 +277,47 @@ BOOST_AUTO_TEST_CASE( span_profile ) {
     }
 }
 
+/**
+ * Tests the ability of the netcdf_profile class to replace missing
+ * values with the nearest valid value at each depth, and to save the
+ * result in a file that can be read back in.  Reads WOA09 temperatures
+ * around the Hawaiian islands, where the deeper levels have a large number
+ * of missing values.  Checks that every missing value is filled, that
+ * valid values are unchanged, and that the multi-threaded fill gives
+ * the same answer as the single threaded one.  This window is too small
+ * to be threaded automatically, so the threaded fill asks for 4 threads
+ * explicitly.  Generates BOOST errors if
+ * the profile read back from the fill_nearest.nc file is not identical.
+ */
+BOOST_AUTO_TEST_CASE( fill_nearest_profile ) {
+    cout << "=== profile_test: fill_nearest_profile ===" << endl;
+    const char* woa = USML_DATA_DIR "/woa09/temperature_monthly_1deg.nc" ;
+    netcdf_profile original( woa, 15.0, 18.5, 22.5, 200.5, 205.5 ) ;
+    netcdf_profile profile( woa, 15.0, 18.5, 22.5, 200.5, 205.5 ) ;
+    netcdf_profile threaded( woa, 15.0, 18.5, 22.5, 200.5, 205.5 ) ;
+    profile.fill_nearest( 1 ) ;
+    threaded.fill_nearest( 4 ) ;
+
+    const char* name = USML_TEST_DIR "/netcdf/test/fill_nearest.nc" ;
+    profile.write_netcdf( name ) ;
+    netcdf_profile cache( name, 0.0, 18.5, 22.5, 200.5, 205.5 ) ;
+
+    unsigned index[3] ;
+    for ( index[0]=0 ; index[0] < profile.axis(0)->size() ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < profile.axis(1)->size() ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < profile.axis(2)->size() ; ++index[2] ) {
+                const double value = profile.data(index) ;
+                BOOST_CHECK( ! isnan(value) ) ;
+                if ( ! isnan( original.data(index) ) ) {
+                    BOOST_CHECK_EQUAL( value, original.data(index) ) ;
+                }
+                BOOST_CHECK_EQUAL( value, threaded.data(index) ) ;
+                BOOST_CHECK_EQUAL( value, cache.data(index) ) ;
+            }
+        }
+    }
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
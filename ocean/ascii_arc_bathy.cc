@@ -2,33 +2,55 @@
  * @file ascii_arc_bathy.cc
  * Extracts bathymetry data from from ASCII files with an ARC header.
  */
-#include <iostream>
-#include <fstream>
+#include <algorithm>
+#include <stdexcept>
 #include <usml/ocean/ascii_arc_bathy.h>
+#include <usml/ocean/ascii_parser.h>
+
+#ifdef USML_DEBUG
+    #include <fstream>
+#endif
 
 using namespace usml::ocean ;
 
+namespace {
+
+/**
+ * Read one label and value from the file header.
+ *
+ * @throws std::invalid_argument if the header ends early.
+ */
+double read_header( ascii_parser& fi ) {
+    std::string label ;
+    double value ;
+    if ( ! fi.next( label ) || ! fi.next( value ) ) {
+        throw std::invalid_argument("ARC header is incomplete") ;
+    }
+    return value ;
+}
+
+}
+
 /**
  * Load bathymetry from disk.
  */
-ascii_arc_bathy::ascii_arc_bathy( const char* filename )
+ascii_arc_bathy::ascii_arc_bathy( const char* filename, double fill )
 {
-    int ncols, nrows ;
-    double xllcorner, yllcorner, cellsize, nodata_value ;
-    static char label[80] ;
     const double R = (double) wposition::earth_radius ;
 
-    std::ifstream fi(filename);
-    fi >> std::skipws ;
+    ascii_parser fi( filename ) ;
 
     // read the file header
 
-    fi >> label >> ncols ;
-    fi >> label >> nrows ;
-    fi >> label >> xllcorner ;
-    fi >> label >> yllcorner ;
-    fi >> label >> cellsize ;
-    fi >> label >> nodata_value ;
+    const int ncols = (int) read_header( fi ) ;
+    const int nrows = (int) read_header( fi ) ;
+    const double xllcorner = read_header( fi ) ;
+    const double yllcorner = read_header( fi ) ;
+    const double cellsize = read_header( fi ) ;
+    const double nodata_value = read_header( fi ) ;
+    if ( ncols < 1 || nrows < 1 ) {
+        throw std::invalid_argument("ARC header has no rows or columns") ;
+    }
 
     // construct latitude and longitude axes in spherical coordinates
     // note that axis[0] starts in the south and moves north
@@ -44,14 +66,15 @@ ascii_arc_bathy::ascii_arc_bathy( const char* filename )
 
     // read depths and convert to rho coordinate of spherical earth system
     // flip latitude direction upside down during the read.
+    // replace missing depths with the fill value.
 
-    this->_data = new double[ ncols * nrows ] ;
-    for ( int r=0 ; r < nrows ; ++r ) {
-        double* ptr = &( this->_data[r*ncols] ) ;
-        for ( int c=0 ; c < ncols ; ++c ) {
-            fi >> *ptr ;
-            *(ptr++) += R ;
-        }
+    const size_t N = (size_t) ncols * nrows ;
+    this->_data = new double[ N ] ;
+    const size_t count = fi.read( this->_data, N ) ;
+    std::fill( this->_data + count, this->_data + N, nodata_value ) ;
+    for ( size_t n=0 ; n < N ; ++n ) {
+        if ( this->_data[n] == nodata_value ) this->_data[n] = fill ;
+        this->_data[n] += R ;
     }
 
     #ifdef USML_DEBUG
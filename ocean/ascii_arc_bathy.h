@@ -43,6 +43,11 @@ using namespace usml::types ;
  *      etc.
  * </pre>
  *
+ * Cells that are equal to NODATA_VALUE, and cells that are missing
+ * from the end of the file, are replaced by a fill value.  The file is
+ * converted with the ascii_parser, which is much faster than stream
+ * extraction for large grids.
+ *
  * This format is one of the options used by the Geophysical Data System
  * (GEODAS) Search and Data Retrieval web site to distribute custom
  * bathymetry grids. The link is provided below:
@@ -58,9 +63,13 @@ class USML_DECLSPEC ascii_arc_bathy : public data_grid<double,2> {
      * The entire data file is loaded.
      *
      * @param  filename     Name of the ASCII ARC file to load.
-     *
+     * @param  fill         Height used in place of NODATA_VALUE
+     *                      (meters, default is sea level).
+     * @throws std::invalid_argument if the file can not be read,
+     *                      if the header is incomplete, or if the
+     *                      file contains text that is not a number.
      */
-    ascii_arc_bathy( const char* filename ) ;
+    ascii_arc_bathy( const char* filename, double fill = 0.0 ) ;
 
 } ;
 
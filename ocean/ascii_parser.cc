@@ -0,0 +1,289 @@
+/**
+ * @file ascii_parser.cc
+ * Fast extraction of numbers from ASCII files.
+ */
+#include <usml/ocean/ascii_parser.h>
+#include <boost/thread/thread.hpp>
+#include <boost/cstdint.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+using namespace usml::ocean ;
+
+namespace {
+
+/** Powers of ten that are exactly representable as doubles. */
+const double POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+} ;
+
+/** Whitespace and commas separate numbers. */
+inline bool is_delimiter( char c ) {
+    return c == ' ' || c == ',' || c == '\n' || c == '\r'
+        || c == '\t' || c == '\f' || c == '\v' ;
+}
+
+inline bool is_digit( char c ) {
+    return c >= '0' && c <= '9' ;
+}
+
+/**
+ * Count the numbers in one block of text.  Blocks start and end
+ * on delimiter boundaries.
+ */
+struct block_counter {
+    const char* first ;
+    const char* last ;
+    size_t* count ;
+
+    void operator()() {
+        size_t n = 0 ;
+        bool inside = false ;
+        for ( const char* p = first ; p < last ; ++p ) {
+            const bool word = ! is_delimiter( *p ) ;
+            if ( word && ! inside ) ++n ;
+            inside = word ;
+        }
+        *count = n ;
+    }
+} ;
+
+/**
+ * Convert up to count numbers from one block of text.  Records the
+ * position after the last number converted, and any error message.
+ */
+struct block_parser {
+    const char* first ;
+    const char* last ;
+    double* data ;
+    size_t count ;
+    const char** stop ;
+    std::string* error ;
+
+    void operator()() {
+        const char* p = first ;
+        try {
+            for ( size_t n=0 ; n < count ; ++n ) {
+                while ( p < last && is_delimiter(*p) ) ++p ;
+                data[n] = ascii_parser::parse( p, last ) ;
+            }
+        } catch ( const std::invalid_argument& ex ) {
+            *error = ex.what() ;
+        }
+        *stop = p ;
+    }
+} ;
+
+}
+
+/**
+ * Load an ASCII file into memory.
+ */
+ascii_parser::ascii_parser( const char* filename ) {
+    std::ifstream file( filename, std::ios::in | std::ios::binary ) ;
+    if ( ! file ) {
+        throw std::invalid_argument("file not found") ;
+    }
+    file.seekg( 0, std::ios::end ) ;
+    const std::streamoff size = file.tellg() ;
+    file.seekg( 0, std::ios::beg ) ;
+    _buffer.resize( (size_t) size + 1 ) ;
+    if ( size > 0 ) file.read( &_buffer[0], size ) ;
+    _buffer[ (size_t) size ] = '\0' ;     // keeps strtod() inside the buffer
+    _pos = &_buffer[0] ;
+    _end = _pos + size ;
+}
+
+/**
+ * Advance current position past delimiters.
+ */
+void ascii_parser::skip() {
+    while ( _pos < _end && is_delimiter(*_pos) ) ++_pos ;
+}
+
+/**
+ * Extract the next word.
+ */
+bool ascii_parser::next( std::string& word ) {
+    skip() ;
+    if ( _pos >= _end ) return false ;
+    const char* first = _pos ;
+    while ( _pos < _end && ! is_delimiter(*_pos) ) ++_pos ;
+    word.assign( first, _pos ) ;
+    return true ;
+}
+
+/**
+ * Extract the next number.
+ */
+bool ascii_parser::next( double& value ) {
+    skip() ;
+    if ( _pos >= _end ) return false ;
+    value = parse( _pos, _end ) ;
+    return true ;
+}
+
+/**
+ * Convert a single number, and advance past it.
+ */
+double ascii_parser::parse( const char*& ptr, const char* end ) {
+    const char* p = ptr ;
+    bool negative = false ;
+    if ( p < end && ( *p == '-' || *p == '+' ) ) {
+        negative = ( *p == '-' ) ;
+        ++p ;
+    }
+
+    // accumulate up to 19 significant digits in an integer
+
+    boost::uint64_t mantissa = 0 ;
+    int digits = 0 ;
+    int exponent = 0 ;
+    bool valid = false ;
+    for ( ; p < end && is_digit(*p) ; ++p ) {
+        valid = true ;
+        if ( digits < 19 ) {
+            mantissa = mantissa * 10 + ( *p - '0' ) ;
+            if ( mantissa ) ++digits ;
+        } else {
+            ++exponent ;
+        }
+    }
+    if ( p < end && *p == '.' ) {
+        for ( ++p ; p < end && is_digit(*p) ; ++p ) {
+            valid = true ;
+            if ( digits < 19 ) {
+                mantissa = mantissa * 10 + ( *p - '0' ) ;
+                if ( mantissa ) ++digits ;
+                --exponent ;
+            }
+        }
+    }
+    if ( valid && p < end && ( *p == 'e' || *p == 'E' ) ) {
+        const char* q = p + 1 ;
+        bool neg_exp = false ;
+        if ( q < end && ( *q == '-' || *q == '+' ) ) {
+            neg_exp = ( *q == '-' ) ;
+            ++q ;
+        }
+        if ( q < end && is_digit(*q) ) {
+            int e = 0 ;
+            for ( ; q < end && is_digit(*q) ; ++q ) {
+                if ( e < 10000 ) e = e * 10 + ( *q - '0' ) ;
+            }
+            exponent += neg_exp ? -e : e ;
+            p = q ;
+        }
+    }
+
+    // fast path: exact mantissa and exact power of ten
+
+    if ( valid && ( p >= end || is_delimiter(*p) )
+         && digits <= 15 && exponent >= -22 && exponent <= 22 )
+    {
+        double value = (double) mantissa ;
+        value = ( exponent < 0 ) ? value / POW10[-exponent]
+                                 : value * POW10[exponent] ;
+        ptr = p ;
+        return negative ? -value : value ;
+    }
+
+    // slow path: let strtod() handle everything else
+
+    const char* last = ptr ;
+    while ( last < end && ! is_delimiter(*last) ) ++last ;
+    char word[64] ;
+    const size_t length = last - ptr ;
+    if ( length >= sizeof(word) ) {
+        throw std::invalid_argument( "number is too long: "
+            + std::string( ptr, last ) ) ;
+    }
+    memcpy( word, ptr, length ) ;
+    word[length] = '\0' ;
+    char* stop ;
+    const double value = strtod( word, &stop ) ;
+    if ( stop == word || (size_t) ( stop - word ) != length ) {
+        throw std::invalid_argument( std::string("invalid number: ") + word ) ;
+    }
+    ptr = last ;
+    return value ;
+}
+
+/**
+ * Extract a block of numbers.
+ */
+size_t ascii_parser::read( double* data, size_t count, unsigned num_threads,
+                           size_t min_block )
+{
+    skip() ;
+    const size_t length = _end - _pos ;
+    if ( num_threads == 0 ) {
+        num_threads = std::max( 1u, boost::thread::hardware_concurrency() ) ;
+    }
+    const size_t num_blocks = std::min( (size_t) num_threads,
+                                        length / std::max( min_block, (size_t) 1 ) ) ;
+
+    // small files are converted in the calling thread
+
+    if ( num_blocks < 2 ) {
+        size_t n = 0 ;
+        while ( n < count && _pos < _end ) {
+            data[n++] = parse( _pos, _end ) ;
+            skip() ;
+        }
+        return n ;
+    }
+
+    // split text into blocks that start and end on delimiters
+
+    std::vector<const char*> bounds( num_blocks + 1 ) ;
+    bounds[0] = _pos ;
+    bounds[num_blocks] = _end ;
+    for ( size_t b=1 ; b < num_blocks ; ++b ) {
+        const char* p = std::max( bounds[b-1], _pos + b * length / num_blocks ) ;
+        while ( p < _end && ! is_delimiter(*p) ) ++p ;
+        bounds[b] = p ;
+    }
+
+    // count the numbers in each block
+
+    std::vector<size_t> counts( num_blocks ) ;
+    boost::thread_group counters ;
+    for ( size_t b=0 ; b < num_blocks ; ++b ) {
+        block_counter task = { bounds[b], bounds[b+1], &counts[b] } ;
+        counters.create_thread( task ) ;
+    }
+    counters.join_all() ;
+
+    // convert each block directly into its place in the output
+
+    std::vector<const char*> stops( num_blocks, _end ) ;
+    std::vector<std::string> errors( num_blocks ) ;
+    boost::thread_group parsers ;
+    size_t offset = 0 ;
+    size_t last_block = num_blocks - 1 ;
+    for ( size_t b=0 ; b < num_blocks ; ++b ) {
+        const size_t n = std::min( counts[b], count - offset ) ;
+        block_parser task = { bounds[b], bounds[b+1], data + offset, n,
+                              &stops[b], &errors[b] } ;
+        parsers.create_thread( task ) ;
+        offset += n ;
+        if ( offset >= count ) {
+            last_block = b ;
+            break ;
+        }
+    }
+    parsers.join_all() ;
+    for ( size_t b=0 ; b <= last_block ; ++b ) {
+        if ( ! errors[b].empty() ) {
+            throw std::invalid_argument( errors[b] ) ;
+        }
+    }
+    _pos = stops[last_block] ;
+    skip() ;
+    return offset ;
+}
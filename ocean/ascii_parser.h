@@ -0,0 +1,120 @@
+/**
+ * @file ascii_parser.h
+ * Fast extraction of numbers from ASCII files.
+ */
+#ifndef USML_OCEAN_ASCII_PARSER_H
+#define USML_OCEAN_ASCII_PARSER_H
+
+#include <usml/usml_config.h>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace usml {
+namespace ocean {
+
+/// @ingroup ascii_arc_files
+/// @{
+
+/**
+ * Fast extraction of numbers from ASCII files.  Stream extraction
+ * with std::ifstream is locale aware, and very slow for files with
+ * millions of values, like large ARC ASCII bathymetry exports.
+ * This parser loads the whole file into memory with a single read,
+ * and then converts each number by hand.
+ *
+ * Numbers with 15 or fewer significant digits, and decimal exponents
+ * of 22 or less, are converted with a single multiply or divide of
+ * exactly representable values, which gives the same correctly rounded
+ * result as strtod().  Other numbers, including "nan" and "inf",
+ * fall back to strtod().  Whitespace and commas are both treated as
+ * delimiters, so the same parser can be used for CSV files.
+ *
+ * Large blocks of numbers can be converted in parallel.  The remaining
+ * text is split into blocks at delimiter boundaries, the values in each
+ * block are counted in parallel, and then each block is converted
+ * directly into its place in the output array.
+ */
+class USML_DECLSPEC ascii_parser {
+
+public:
+
+    /**
+     * Load an ASCII file into memory.
+     *
+     * @param   filename    Name of the file to load.
+     * @throws  std::invalid_argument if the file can not be read.
+     */
+    ascii_parser( const char* filename ) ;
+
+    /**
+     * Extract the next word, such as a header label.
+     *
+     * @param   word        Characters up to the next delimiter (output).
+     * @return              False if the end of file has been reached.
+     */
+    bool next( std::string& word ) ;
+
+    /**
+     * Extract the next number.
+     *
+     * @param   value       Value of the number (output).
+     * @return              False if the end of file has been reached.
+     * @throws  std::invalid_argument if the next word is not a number.
+     */
+    bool next( double& value ) ;
+
+    /** Default minimum number of characters in each parallel block. */
+    static const size_t MIN_BLOCK = 1 << 20 ;
+
+    /**
+     * Extract a block of numbers.  Uses multiple threads if the
+     * remaining text is large enough to make this worthwhile.
+     *
+     * @param   data        Array to fill with values (output).
+     * @param   count       Maximum number of values to extract.
+     * @param   num_threads Number of threads to use. Defaults to the
+     *                      number of hardware threads if zero.
+     * @param   min_block   Minimum number of characters in each parallel
+     *                      block.  The text is only split into as many
+     *                      blocks as it has multiples of this size.
+     * @return              Number of values extracted, which is less
+     *                      than count if the end of file is reached.
+     * @throws  std::invalid_argument if a word is not a number.
+     */
+    size_t read( double* data, size_t count, unsigned num_threads = 0,
+                 size_t min_block = MIN_BLOCK ) ;
+
+    /**
+     * Convert a single number, and advance past it.
+     *
+     * @param   ptr         First character of the number.  Updated
+     *                      to point to the character after the number.
+     * @param   end         End of the text buffer.
+     * @return              Value of the number.
+     * @throws  std::invalid_argument if the word is not a number, or
+     *                      if it needs strtod() and is longer than
+     *                      63 characters.
+     */
+    static double parse( const char*& ptr, const char* end ) ;
+
+private:
+
+    /** Contents of the file. */
+    std::vector<char> _buffer ;
+
+    /** Current position in the buffer. */
+    const char* _pos ;
+
+    /** End of the buffer. */
+    const char* _end ;
+
+    /** Advance current position past delimiters. */
+    void skip() ;
+} ;
+
+/// @}
+}  // end of namespace ocean
+}  // end of namespace usml
+
+#endif
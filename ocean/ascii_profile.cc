@@ -3,11 +3,9 @@
  * Read a 1-D profile from a text file.
  */
  
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <ctype.h>
+#include <vector>
 #include <usml/ocean/ascii_profile.h>
+#include <usml/ocean/ascii_parser.h>
 
 using namespace usml::ocean ;
 
@@ -16,36 +14,23 @@ using namespace usml::ocean ;
  */
 ascii_profile::ascii_profile( const char* filename ) {
 
-    // count the number of lines in the input file
+    // read depth and speed pairs from input file in a single pass
 
-    std::ifstream infile(filename);
-    unsigned size = 0 ;
-    std::string line ;
-    while ( getline(infile,line) ) ++size ;
-    infile.clear() ;
-    infile.seekg(0) ;
+    ascii_parser infile( filename ) ;
+    std::vector<double> values ;
+    double value ;
+    while ( infile.next(value) ) values.push_back( value ) ;
+    const unsigned size = values.size() / 2 ;
 
-    // read data from input file
+    // load into data_grid variables
 
-    double depth ;
     double *height = new double[size] ;
     double *speed = new double[size] ;
-    char c ;
     for ( unsigned n=0 ; n < size ; ++n ) {
-        infile >> depth ;
-        while ( true ) {    // skip comma and space delimiters
-            c = infile.peek() ;
-            if ( c != ',' && ! isspace(c) ) break ;
-            infile.get() ;
-        }
-        infile >> speed[n] ;
-        height[n] = wposition::earth_radius - depth ;
+        height[n] = wposition::earth_radius - values[2*n] ;
+        speed[n] = values[2*n+1] ;
     }
-
-    // load into data_grid variables
-
     this->_axis[0] = new seq_data( height, size ) ;
     this->_data = speed ;
     delete[] height ;
 }
-
@@ -15,7 +15,9 @@ namespace ocean {
 
 /**
  * Read a 1-D profile from a text file.  The is often used to read
- * tables and CSV files from other applications.
+ * tables and CSV files from other applications.  Each line contains
+ * a depth and a value, separated by commas or spaces.  The file is
+ * converted in a single pass with the ascii_parser.
  */
 class USML_DECLSPEC ascii_profile : public data_grid<double,1> {
 
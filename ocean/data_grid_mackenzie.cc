@@ -0,0 +1,246 @@
+/**
+ * @file data_grid_mackenzie.cc
+ * Mackenzie model for the speed of sound vs. temperature and salinity.
+ */
+#include <usml/ocean/data_grid_mackenzie.h>
+#include <boost/thread/thread.hpp>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cmath>
+
+using namespace usml::ocean ;
+
+namespace {
+
+/** Conversion from MPa to kg/cm^2, used by Del Grosso. */
+const double MPA_TO_KG_CM2 = 10.197162 ;
+
+/** Conversion from MPa to bar, used by Chen and Millero. */
+const double MPA_TO_BAR = 10.0 ;
+
+/**
+ * Compute sound speed for a block of rows.  Each row is one latitude
+ * at one depth, and all of its longitudes are contiguous in memory.
+ */
+struct block_speed {
+    data_grid_mackenzie::equation_type equation ;
+    const double* depth ;
+    const double* latitude ;
+    unsigned num_lat ;
+    size_t num_lng ;
+    const double* temperature ;
+    const double* salinity ;
+    double* speed ;
+    size_t first ;
+    size_t last ;
+
+    void operator()() {
+        for ( size_t row = first ; row < last ; ++row ) {
+            const size_t offset = row * num_lng ;
+            data_grid_mackenzie::compute( equation,
+                depth[ row / num_lat ], latitude[ row % num_lat ],
+                temperature + offset, salinity + offset, speed + offset,
+                num_lng ) ;
+        }
+    }
+} ;
+
+}
+
+/**
+ * Define sound speed profile using temperature and salinity.
+ */
+data_grid<double,3>* data_grid_mackenzie::construct(
+    data_grid<double,3>* temperature,
+    data_grid<double,3>* salinity,
+    bool in_place, equation_type equation, unsigned num_threads )
+{
+    // delete both grids on the way out, even if an exception is thrown
+
+    std::auto_ptr< data_grid<double,3> > temperature_owner( temperature ) ;
+    std::auto_ptr< data_grid<double,3> > salinity_owner( salinity ) ;
+    for ( unsigned n=0 ; n < 3 ; ++n ) {
+        if ( temperature->axis(n)->size() != salinity->axis(n)->size() ) {
+            throw std::invalid_argument(
+                "temperature and salinity axes must be the same size") ;
+        }
+    }
+    if ( temperature->data() == NULL || salinity->data() == NULL ) {
+        throw std::invalid_argument(
+            "temperature and salinity must be double precision grids") ;
+    }
+
+    std::auto_ptr< data_grid<double,3> > speed_owner( ( in_place ) ? NULL
+        : new data_grid<double,3>( *temperature, false ) ) ;
+    data_grid<double,3>* ssp = ( in_place ) ? temperature : speed_owner.get() ;
+    ssp->interp_type(0,GRID_INTERP_PCHIP) ;
+    ssp->interp_type(1,GRID_INTERP_LINEAR) ;
+    ssp->interp_type(2,GRID_INTERP_LINEAR) ;
+
+    // depth and latitude of each row
+
+    const seq_vector& rho = *temperature->axis(0) ;
+    const seq_vector& theta = *temperature->axis(1) ;
+    std::vector<double> depth( rho.size() ) ;
+    for ( unsigned n=0 ; n < rho.size() ; ++n ) {
+        depth[n] = wposition::earth_radius - rho[n] ;
+    }
+    std::vector<double> latitude( theta.size() ) ;
+    for ( unsigned n=0 ; n < theta.size() ; ++n ) {
+        latitude[n] = 90.0 - to_degrees( theta[n] ) ;
+    }
+
+    // split the rows into blocks, one per thread
+
+    const size_t num_rows = rho.size() * theta.size() ;
+    const size_t num_lng = temperature->axis(2)->size() ;
+    if ( num_threads == 0 ) {
+        num_threads = ( num_rows * num_lng < MIN_THREAD_SIZE ) ? 1u
+            : std::max( 1u, boost::thread::hardware_concurrency() ) ;
+    }
+    num_threads = (unsigned) std::min( (size_t) num_threads, num_rows ) ;
+
+    std::vector<block_speed> blocks( std::max( 1u, num_threads ) ) ;
+    for ( size_t b=0 ; b < blocks.size() ; ++b ) {
+        block_speed& task = blocks[b] ;
+        task.equation = equation ;
+        task.depth = &depth[0] ;
+        task.latitude = &latitude[0] ;
+        task.num_lat = theta.size() ;
+        task.num_lng = num_lng ;
+        task.temperature = temperature->data() ;
+        task.salinity = salinity->data() ;
+        task.speed = ssp->data() ;
+        task.first = b * num_rows / blocks.size() ;
+        task.last = ( b + 1 ) * num_rows / blocks.size() ;
+    }
+    if ( blocks.size() < 2 ) {
+        blocks[0]() ;
+    } else {
+        boost::thread_group workers ;
+        for ( size_t b=0 ; b < blocks.size() ; ++b ) {
+            workers.create_thread( blocks[b] ) ;
+        }
+        workers.join_all() ;
+    }
+
+    return ( in_place ) ? temperature_owner.release()
+                        : speed_owner.release() ;
+}
+
+/**
+ * Compute sound speed for a row of temperature and salinity values.
+ * The depth and pressure terms of each equation are collapsed into
+ * polynomial coefficients of temperature and salinity, so that the
+ * inner loops are simple enough for the compiler to vectorize.
+ */
+void data_grid_mackenzie::compute(
+    equation_type equation, double depth, double latitude,
+    const double* temperature, const double* salinity,
+    double* speed, size_t N )
+{
+    const double D = depth ;
+    switch ( equation ) {
+
+    //**************************************************
+    // Mackenzie (1981)
+
+    case MACKENZIE :
+    default :
+        {
+            const double c0 = 1448.96 + 1.630e-2 * D + 1.675e-7 * D*D ;
+            const double c1 = 4.591 - 7.139e-13 * D*D*D ;
+            for ( size_t n=0 ; n < N ; ++n ) {
+                const double T = temperature[n] ;
+                const double S = salinity[n] - 35.0 ;
+                speed[n] = c0 + T * ( c1 + T * ( -5.304e-2 + 2.374e-4 * T ) )
+                         + ( 1.340 - 1.025e-2 * T ) * S ;
+            }
+        }
+        break ;
+
+    //**************************************************
+    // Del Grosso (1974), pressure in kg/cm^2
+
+    case DEL_GROSSO :
+        {
+            const double P = pressure( D, latitude ) * MPA_TO_KG_CM2 ;
+            const double P2 = P * P ;
+            const double c0 = 1402.392
+                + P * ( 0.1560592 + P * ( 0.2449993e-4 - 0.8833959e-8 * P ) ) ;
+            const double cT = 0.5012285e1 + 0.6353509e-2 * P
+                - 0.1593895e-5 * P2 + 0.5222483e-9 * P2 * P ;
+            const double cT2 = -0.551184e-1 + 0.2656174e-7 * P2 ;
+            const double cT3 = 0.221649e-3 - 0.4383615e-6 * P ;
+            const double cS = 0.1329530e1 ;
+            const double cS2 = 0.1288598e-3 - 0.1616745e-8 * P2 ;
+            const double cST = -0.1275936e-1 - 0.3406824e-3 * P ;
+            const double cST2 = 0.9688441e-4 ;
+            const double cS2T = 0.4857614e-5 * P ;
+            for ( size_t n=0 ; n < N ; ++n ) {
+                const double T = temperature[n] ;
+                const double S = salinity[n] ;
+                speed[n] = c0 + T * ( cT + T * ( cT2 + T * cT3 ) )
+                         + S * ( cS + S * cS2 )
+                         + S * T * ( cST + T * cST2 + S * cS2T ) ;
+            }
+        }
+        break ;
+
+    //**************************************************
+    // UNESCO, Chen and Millero (1977), pressure in bar
+
+    case CHEN_MILLERO :
+        {
+            const double P = pressure( D, latitude ) * MPA_TO_BAR ;
+            const double P2 = P * P ;
+            const double P3 = P2 * P ;
+            const double w0 = 1402.388 + 0.153563 * P
+                + 3.1260e-5 * P2 - 9.7729e-9 * P3 ;
+            const double w1 = 5.03711 + 6.8982e-4 * P
+                - 1.7107e-6 * P2 + 3.8504e-10 * P3 ;
+            const double w2 = -5.80852e-2 - 8.1788e-6 * P
+                + 2.5974e-8 * P2 - 2.3643e-12 * P3 ;
+            const double w3 = 3.3420e-4 + 1.3621e-7 * P - 2.5335e-10 * P2 ;
+            const double w4 = -1.47800e-6 - 6.1185e-10 * P + 1.0405e-12 * P2 ;
+            const double w5 = 3.1464e-9 ;
+            const double a0 = 1.389 + 9.4742e-5 * P
+                - 3.9064e-7 * P2 + 1.100e-10 * P3 ;
+            const double a1 = -1.262e-2 - 1.2580e-5 * P
+                + 9.1041e-9 * P2 + 6.649e-12 * P3 ;
+            const double a2 = 7.164e-5 - 6.4885e-8 * P
+                - 1.6002e-10 * P2 - 3.389e-13 * P3 ;
+            const double a3 = 2.006e-6 + 1.0507e-8 * P + 7.988e-12 * P2 ;
+            const double a4 = -3.21e-8 - 2.0122e-10 * P ;
+            const double b0 = -1.922e-2 + 7.3637e-5 * P ;
+            const double b1 = -4.42e-5 + 1.7945e-7 * P ;
+            const double d0 = 1.727e-3 - 7.9836e-6 * P ;
+            for ( size_t n=0 ; n < N ; ++n ) {
+                const double T = temperature[n] ;
+                const double S = salinity[n] ;
+                const double cw = w0 + T * ( w1 + T * ( w2 + T * ( w3
+                                + T * ( w4 + T * w5 ) ) ) ) ;
+                const double A = a0 + T * ( a1 + T * ( a2 + T * ( a3
+                               + T * a4 ) ) ) ;
+                const double B = b0 + b1 * T ;
+                speed[n] = cw + S * ( A + B * std::sqrt( S ) + d0 * S ) ;
+            }
+        }
+        break ;
+    }
+}
+
+/**
+ * Gauge pressure as a function of depth and latitude.
+ */
+double data_grid_mackenzie::pressure( double depth, double latitude ) {
+    const double Z = depth ;
+    const double s = std::sin( to_radians( latitude ) ) ;
+    const double g = 9.7803 * ( 1.0 + 5.3e-3 * s * s ) ;
+    const double k = ( g - 2e-5 * Z ) / ( 9.80612 - 2e-5 * Z ) ;
+    const double h45 = Z * ( 1.00818e-2 + Z * ( 2.465e-8
+                     + Z * ( -1.25e-13 + Z * 2.8e-19 ) ) ) ;
+    return h45 * k ;
+}
@@ -5,11 +5,15 @@
 #ifndef USML_OCEAN_DATA_GRID_MACKENZIE_H
 #define USML_OCEAN_DATA_GRID_MACKENZIE_H
 
-#include <usml/types/data_grid.h>
+#include <usml/ublas/ublas.h>
+#include <usml/types/types.h>
 
 namespace usml {
 namespace ocean {
 
+using namespace usml::ublas ;
+using namespace usml::types ;
+
 /// @ingroup profiles
 /// @{
 
@@ -42,8 +46,18 @@ namespace ocean {
  * TRUE for any dimensional axis that uses the PCHIP interpolation. This is
  * because of PCHIP allowing for extreme values when extrapolating data.
  *
+ * The Del Grosso and UNESCO (Chen and Millero) equations are also
+ * supported.  They are defined in terms of pressure, which is computed
+ * from depth and latitude using the Leroy and Parthiot equation.
+ * Chen and Millero is the international standard, and is valid over a
+ * wider range of conditions, but Del Grosso is thought to be more accurate
+ * for deep water.  Mackenzie is the cheapest of the three.
+ *
  * NOTE: data_grid_mackenzie takes control of the two data_grids that are
- * passed in and then deletes them before the sound speed data_grid is returned.
+ * passed in and then deletes them before the sound speed data_grid is
+ * returned, or before an exception is thrown.  If the sound speed is
+ * computed in place, the temperature grid is returned instead of being
+ * deleted.
  *
  * @xref R.J. Urick, Principles of Underwater Sound, 3rd Edition,
  *       (1983), p. 113.
@@ -51,61 +65,95 @@ namespace ocean {
  * @xref K.V. Mackenzie, "Nine-term Equation for Sound Speed
  *       in the Oceans," J. Acoust. Soc. Am. 70:807 (1981).
  *
+ * @xref V.A. Del Grosso, "New equation for the speed of sound in natural
+ *       waters (with comparisons to other equations)," J. Acoust. Soc. Am
+ *       56:1084-1091 (1974).
+ *
+ * @xref C. Chen and F.J. Millero, "Speed of sound in seawater at high
+ *       pressures," J. Acoust. Soc. Am. 62:1129-1135 (1977).
+ *
+ * @xref C.C. Leroy and F. Parthiot, "Depth-pressure relationship in the
+ *       oceans and seas," J. Acoust. Soc. Am. 103:1346-1352 (1998).
+ *
  * @xref UK National Physical Laboratory, "Technical Guides -
  *       Speed of Sound in Sea-Water," interactive website at
  *       http://resource.npl.co.uk/acoustics/techguides/soundseawater/
  */
-class data_grid_mackenzie {
+class USML_DECLSPEC data_grid_mackenzie {
 
   public:
 
+    /** Equations available for computing sound speed. */
+    enum equation_type {
+        MACKENZIE,      ///< Mackenzie (1981) nine term equation
+        DEL_GROSSO,     ///< Del Grosso (1974) equation
+        CHEN_MILLERO    ///< UNESCO (Chen and Millero 1977) equation
+    } ;
+
     //**************************************************
     // initialization
 
     /**
      * Define sound speed profile using temperature and salinity.
+     * Works directly on the data arrays of both grids, and splits
+     * large grids into blocks of rows that are computed in parallel.
+     * Both grids must have the same axes, and they must store their
+     * data in double precision.
      *
      * @param temperature   Ocean temperature profile (degrees C).
+     *                      Overwritten with sound speed if in_place is true.
      * @param salinity      Ocean salinity profile (ppt).
-     *
+     * @param in_place      Overwrite the temperature grid with sound speed
+     *                      and return it, instead of allocating a new grid.
+     * @param equation      Equation used to compute sound speed.
+     * @param num_threads   Number of threads to use. If zero, uses the
+     *                      number of hardware threads, or a single thread
+     *                      for grids too small to justify threading.
+     * @return              Sound speed profile (m/s).
+     * @throws std::invalid_argument if the grids are not compatible.
+     *                      Both grids are deleted before it is thrown.
      */
     static data_grid<double,3>* construct(
-        const data_grid<double,3>* temperature,
-        const data_grid<double,3>* salinity )
-    {
-        data_grid<double,3>* ssp = new data_grid<double,3>(*temperature,false) ;
-        ssp->interp_type(0,GRID_INTERP_PCHIP) ;
-        ssp->interp_type(1,GRID_INTERP_LINEAR) ;
-        ssp->interp_type(2,GRID_INTERP_LINEAR) ;
-
-        unsigned index[3] ;
-        for ( index[0]=0 ; index[0] < temperature->axis(0)->size() ; ++index[0] ) {
-            for ( index[1]=0 ; index[1] < temperature->axis(1)->size() ; ++index[1] ) {
-                for ( index[2]=0 ; index[2] < temperature->axis(2)->size() ; ++index[2] ) {
-
-                    // extract depth, temperature, and salinity at this point
-
-                    double D = wposition::earth_radius -
-                               (*temperature->axis(0))[ index[0] ] ;
-                    double T = temperature->data( index ) ;
-                    double S = salinity->data( index ) ;
-
-                    // compute sound speed
-
-                    double c =  1448.96 + 4.591 * T - 5.304e-2 * T*T
-                             + 2.374e-4 * T*T*T
-                             + ( 1.340 - 1.025e-2 * T ) * ( S - 35.0 )
-                             + 1.630e-2 * D + 1.675e-7 * D*D
-                             - 7.139e-13 * T * D*D*D ;
-
-                    ssp->data( index, c ) ;
-                }
-            }
-        }
-        delete temperature ;
-        delete salinity ;
-        return ssp ;
-    }
+        data_grid<double,3>* temperature,
+        data_grid<double,3>* salinity,
+        bool in_place = false,
+        equation_type equation = MACKENZIE,
+        unsigned num_threads = 0 ) ;
+
+    /**
+     * Compute sound speed for a row of temperature and salinity values
+     * that share the same depth and latitude.  All of the terms that
+     * only depend on depth or pressure are computed once for the row.
+     * The speed array can be the same as the temperature array.
+     *
+     * @param equation      Equation used to compute sound speed.
+     * @param depth         Depth of this row (meters).
+     * @param latitude      Latitude of this row (degrees), used to convert
+     *                      depth into pressure.
+     * @param temperature   Ocean temperature (degrees C).
+     * @param salinity      Ocean salinity (ppt).
+     * @param speed         Sound speed (m/s, output).
+     * @param N             Number of values in the row.
+     */
+    static void compute(
+        equation_type equation, double depth, double latitude,
+        const double* temperature, const double* salinity,
+        double* speed, size_t N ) ;
+
+    /**
+     * Gauge pressure as a function of depth and latitude,
+     * using the equation of Leroy and Parthiot (1998).
+     *
+     * @param depth         Depth (meters).
+     * @param latitude      Latitude (degrees).
+     * @return              Pressure relative to the surface (MPa).
+     */
+    static double pressure( double depth, double latitude ) ;
+
+  private:
+
+    /** Minimum number of grid points needed to justify threading. */
+    static const size_t MIN_THREAD_SIZE = 1 << 16 ;
 
 };
 
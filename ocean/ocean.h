@@ -40,6 +40,7 @@
  * Combines the effects of surface, bottom, and profile into a single model.
  *
  *      - ocean_model.h
+ *      - ocean_snapshot.h
  *
  * @defgroup ocean_test Regression Tests
  * @ingroup ocean
@@ -61,6 +62,7 @@
 #include <usml/ocean/profile_catenary.h>
 #include <usml/ocean/profile_grid.h>
 #include <usml/ocean/profile_grid_fast.h>
+#include <usml/ocean/profile_epochs.h>
 #include <usml/ocean/ascii_profile.h>
 #include <usml/ocean/data_grid_mackenzie.h>
 
@@ -74,9 +76,11 @@
 #include <usml/ocean/boundary_slope.h>
 #include <usml/ocean/boundary_grid.h>
 #include <usml/ocean/boundary_grid_fast.h>
+#include <usml/ocean/ascii_parser.h>
 #include <usml/ocean/ascii_arc_bathy.h>
 
 #include <usml/ocean/ocean_model.h>
+#include <usml/ocean/ocean_snapshot.h>
 
 #endif
 
@@ -0,0 +1,303 @@
+/**
+ * @file ocean_snapshot.cc
+ * Shares one fully built set of ocean grids between processes.
+ */
+#include <usml/ocean/ocean_snapshot.h>
+#include <usml/types/seq_linear.h>
+#include <usml/types/seq_data.h>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+using namespace usml::ocean ;
+using boost::uint64_t ;
+using boost::uint32_t ;
+
+static const char SNAPSHOT_MAGIC[8] = { 'U','S','M','L','O','C','E','N' } ;
+static const uint32_t SNAPSHOT_VERSION = 1 ;
+
+/**
+ * Round a byte count up to the next 8 byte boundary.
+ */
+static inline uint64_t align8( uint64_t n ) {
+    return ( n + 7 ) & ~((uint64_t) 7) ;
+}
+
+/**
+ * True if a block of count doubles, starting at offset, is aligned
+ * and fits inside a file of the given size.
+ */
+static inline bool in_file( uint64_t offset, uint64_t count, uint64_t size ) {
+    return offset % sizeof(double) == 0 && offset <= size
+        && count <= ( size - offset ) / sizeof(double) ;
+}
+
+/**
+ * Write a block of values and pad it to the next 8 byte boundary.
+ */
+static void write_block(
+    std::ofstream& os, const void* block, uint64_t bytes )
+{
+    static const char pad[8] = { 0 } ;
+    if ( bytes ) {
+        os.write( (const char*) block, bytes ) ;
+    }
+    os.write( pad, align8(bytes) - bytes ) ;
+}
+
+/**
+ * Write the axes, data, and derivatives of one grid.
+ */
+template<unsigned NUM_DIMS> static void write_grid(
+    std::ofstream& os, const data_grid<double,NUM_DIMS>& grid,
+    const double* derivatives, uint64_t num_derv )
+{
+    uint64_t N = 1 ;
+    for ( unsigned n=0 ; n < NUM_DIMS ; ++n ) {
+        const seq_vector& axis = *grid.axis(n) ;
+        std::vector<double> values( axis.size() ) ;
+        for ( unsigned k=0 ; k < axis.size() ; ++k ) {
+            values[k] = axis(k) ;
+        }
+        write_block( os, &values[0], values.size() * sizeof(double) ) ;
+        N *= axis.size() ;
+    }
+    write_block( os, grid.data(), N * sizeof(double) ) ;
+    write_block( os, derivatives, num_derv * sizeof(double) ) ;
+}
+
+/**
+ * Describe the axes and interpolation options of one grid.
+ */
+template<unsigned NUM_DIMS> void ocean_snapshot::describe(
+    const data_grid<double,NUM_DIMS>& grid, uint64_t num_derv,
+    grid_header& desc, uint64_t& offset )
+{
+    desc.present = 1 ;
+    desc.dims = NUM_DIMS ;
+    uint64_t N = 1 ;
+    for ( unsigned n=0 ; n < NUM_DIMS ; ++n ) {
+        const seq_vector* axis = grid.axis(n) ;
+        desc.size[n] = axis->size() ;
+        desc.interp_type[n] = grid.interp_type(n) ;
+        desc.edge_limit[n] = grid.edge_limit(n) ? 1 : 0 ;
+        desc.linear[n] = dynamic_cast<const seq_linear*>(axis) ? 1 : 0 ;
+        desc.first[n] = (*axis)(0) ;
+        desc.increment[n] = axis->increment(0) ;
+        desc.axis[n] = offset ;
+        offset += align8( desc.size[n] * sizeof(double) ) ;
+        N *= desc.size[n] ;
+    }
+    desc.data = offset ;
+    offset += align8( N * sizeof(double) ) ;
+    desc.derivatives = offset ;
+    offset += align8( num_derv * sizeof(double) ) ;
+}
+
+/**
+ * Write grids, and their derivative tables, to a snapshot file.
+ */
+void ocean_snapshot::write( const char* filename,
+    const data_grid_bathy* bathymetry, const data_grid_svp* sound_speed )
+{
+    if ( ( bathymetry && bathymetry->data() == NULL )
+         || ( sound_speed && sound_speed->data() == NULL ) )
+    {
+        throw std::invalid_argument("snapshot grids must have data") ;
+    }
+
+    // compute the location of each block
+
+    header_type header ;
+    std::memset( &header, 0, sizeof(header) ) ;
+    std::memcpy( header.magic, SNAPSHOT_MAGIC, sizeof(header.magic) ) ;
+    header.version = SNAPSHOT_VERSION ;
+
+    uint64_t offset = align8( sizeof(header) ) ;
+    uint64_t bathy_derv = 0 ;
+    if ( bathymetry ) {
+        bathy_derv = 3 * bathymetry->axis(0)->size()
+                       * bathymetry->axis(1)->size() ;
+        describe( *bathymetry, bathy_derv, header.grid[BATHYMETRY], offset ) ;
+    }
+    uint64_t speed_derv = 0 ;
+    if ( sound_speed ) {
+        speed_derv = sound_speed->axis(0)->size()
+                   * sound_speed->axis(1)->size()
+                   * sound_speed->axis(2)->size() ;
+        describe( *sound_speed, speed_derv, header.grid[SOUND_SPEED], offset ) ;
+    }
+
+    // write header followed by each grid
+
+    std::ofstream os( filename, std::ios::out | std::ios::binary ) ;
+    if ( !os ) {
+        throw std::invalid_argument("can not create ocean snapshot") ;
+    }
+    write_block( os, &header, sizeof(header) ) ;
+    if ( bathymetry ) {
+        write_grid( os, *bathymetry, bathymetry->derivatives(), bathy_derv ) ;
+    }
+    if ( sound_speed ) {
+        write_grid( os, *sound_speed, sound_speed->derivatives(), speed_derv ) ;
+    }
+    if ( !os ) {
+        throw std::invalid_argument("can not write ocean snapshot") ;
+    }
+}
+
+/**
+ * Map an existing snapshot file into memory, read-only.
+ */
+ocean_snapshot::ocean_snapshot( const char* filename ) :
+    _data( NULL ), _size( 0 ), _header( NULL )
+{
+    #ifdef _WIN32
+        std::ifstream is( filename, std::ios::in | std::ios::binary ) ;
+        if ( !is ) {
+            throw std::invalid_argument("file not found") ;
+        }
+        is.seekg( 0, std::ios::end ) ;
+        _size = is.tellg() ;
+        is.seekg( 0, std::ios::beg ) ;
+        char* buffer = new char[ _size ] ;
+        is.read( buffer, _size ) ;
+        _data = buffer ;
+    #else
+        const int fd = open( filename, O_RDONLY ) ;
+        if ( fd < 0 ) {
+            throw std::invalid_argument("file not found") ;
+        }
+        struct stat info ;
+        if ( fstat( fd, &info ) != 0 ) {
+            close( fd ) ;
+            throw std::invalid_argument("can not read ocean snapshot") ;
+        }
+        _size = info.st_size ;
+        void* map = ( _size > 0 )
+            ? mmap( NULL, _size, PROT_READ, MAP_SHARED, fd, 0 )
+            : MAP_FAILED ;
+        close( fd ) ;
+        if ( map == MAP_FAILED ) {
+            throw std::invalid_argument("can not map ocean snapshot") ;
+        }
+        _data = (const char*) map ;
+    #endif
+
+    // validate header and the extent of each grid
+
+    _header = (const header_type*) _data ;
+    if ( _size < sizeof(header_type)
+         || std::memcmp( _header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) )
+         || _header->version != SNAPSHOT_VERSION )
+    {
+        unmap() ;
+        throw std::invalid_argument("unrecognized file type") ;
+    }
+    for ( unsigned g=0 ; g < NUM_GRIDS ; ++g ) {
+        const grid_header& desc = _header->grid[g] ;
+        if ( ! desc.present ) continue ;
+        bool valid = ( desc.dims == g + 2 ) ;
+        uint64_t N = 1 ;
+        for ( unsigned n=0 ; valid && n < desc.dims ; ++n ) {
+            valid = desc.size[n] > 0
+                 && N <= _size / sizeof(double) / desc.size[n]
+                 && in_file( desc.axis[n], desc.size[n], _size )
+                 && desc.interp_type[n] >= GRID_INTERP_NEAREST
+                 && desc.interp_type[n] <= GRID_INTERP_PCHIP ;
+            N *= desc.size[n] ;
+        }
+        const uint64_t num_derv = ( g == BATHYMETRY ) ? 3 * N : N ;
+        if ( ! valid
+             || ! in_file( desc.data, N, _size )
+             || ! in_file( desc.derivatives, num_derv, _size ) )
+        {
+            unmap() ;
+            throw std::invalid_argument("truncated ocean snapshot") ;
+        }
+    }
+}
+
+/**
+ * Release the memory mapped file.
+ */
+ocean_snapshot::~ocean_snapshot() {
+    unmap() ;
+}
+
+/**
+ * Release the memory used to store the file contents.
+ */
+void ocean_snapshot::unmap() {
+    #ifdef _WIN32
+        delete[] _data ;
+    #else
+        if ( _data ) munmap( (void*) _data, _size ) ;
+    #endif
+    _data = NULL ;
+}
+
+/**
+ * Re-create the axes of one grid from the snapshot.
+ */
+void ocean_snapshot::axes( const grid_header& desc, seq_vector* axis[] ) const {
+    for ( unsigned n=0 ; n < desc.dims ; ++n ) {
+        if ( desc.linear[n] ) {
+            axis[n] = new seq_linear( desc.first[n], desc.increment[n],
+                                      (int) desc.size[n] ) ;
+        } else {
+            axis[n] = new seq_data( (const double*) ( _data + desc.axis[n] ),
+                                    (unsigned) desc.size[n] ) ;
+        }
+    }
+}
+
+/**
+ * Create a bathymetry grid attached to this snapshot.
+ */
+data_grid_bathy* ocean_snapshot::bathymetry() const {
+    const grid_header& desc = _header->grid[BATHYMETRY] ;
+    if ( ! desc.present ) {
+        throw std::invalid_argument("snapshot does not contain bathymetry") ;
+    }
+    seq_vector* axis[2] ;
+    axes( desc, axis ) ;
+    data_grid_bathy* grid = new data_grid_bathy(
+        axis,
+        (const double*) ( _data + desc.data ),
+        (const double*) ( _data + desc.derivatives ) ) ;
+    for ( unsigned n=0 ; n < 2 ; ++n ) {
+        grid->interp_type( n, (enum GRID_INTERP_TYPE) desc.interp_type[n] ) ;
+        grid->edge_limit( n, desc.edge_limit[n] != 0 ) ;
+        delete axis[n] ;
+    }
+    return grid ;
+}
+
+/**
+ * Create a sound speed grid attached to this snapshot.
+ */
+data_grid_svp* ocean_snapshot::sound_speed() const {
+    const grid_header& desc = _header->grid[SOUND_SPEED] ;
+    if ( ! desc.present ) {
+        throw std::invalid_argument("snapshot does not contain sound speed") ;
+    }
+    seq_vector* axis[3] ;
+    axes( desc, axis ) ;
+    data_grid_svp* grid = new data_grid_svp(
+        axis,
+        (const double*) ( _data + desc.data ),
+        (const double*) ( _data + desc.derivatives ) ) ;
+    for ( unsigned n=0 ; n < 3 ; ++n ) {
+        grid->edge_limit( n, desc.edge_limit[n] != 0 ) ;
+        delete axis[n] ;
+    }
+    return grid ;
+}
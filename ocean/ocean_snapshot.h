@@ -0,0 +1,191 @@
+/**
+ * @file ocean_snapshot.h
+ * Shares one fully built set of ocean grids between processes.
+ */
+#ifndef USML_OCEAN_OCEAN_SNAPSHOT_H
+#define USML_OCEAN_OCEAN_SNAPSHOT_H
+
+#include <usml/types/data_grid_bathy.h>
+#include <usml/types/data_grid_svp.h>
+#include <boost/cstdint.hpp>
+
+namespace usml {
+namespace ocean {
+
+using namespace usml::types ;
+
+/// @ingroup ocean_model
+/// @{
+
+/**
+ * Shares one fully built set of ocean grids between processes.
+ * Loading bathymetry and sound speed from NetCDF files, and computing
+ * the interpolation derivatives for data_grid_bathy and data_grid_svp,
+ * is slow and uses a lot of memory.  When many worker processes model
+ * the same ocean, one process can build the grids once and write()
+ * them into a snapshot file.  Each worker then maps that file into
+ * memory, read-only, and attaches new grids directly to the mapped
+ * data and derivative tables.  The operating system shares the pages
+ * of the mapped file, so N workers use one copy of the ocean.
+ *
+ * A snapshot written to a RAM backed file system, like /dev/shm on
+ * Linux, acts as a POSIX shared memory segment that outlives the
+ * process that built it.  A snapshot on disk can also be used as a
+ * cache between runs.
+ *
+ * The file layout, in native byte order, is:
+ *
+ * - header
+ *   - magic number "USMLOCEN" (8 bytes)
+ *   - format version (uint32) and flags (uint32)
+ *   - one grid description for each of the bathymetry and sound speed
+ * - for each grid that is present, each block starting on an 8 byte
+ *   boundary:
+ *   - the values of each axis (double)
+ *   - the data values (double)
+ *   - the derivative tables (double)
+ *
+ * Axes created as seq_linear are re-created as seq_linear, so that
+ * find_index() keeps its speed.  All other axes are re-created
+ * as seq_data.  Snapshots can only be read on machines with
+ * the same byte order as the machine that wrote them.
+ *
+ * Reflection loss models are not stored.  They are small, and
+ * workers should create them in the normal way.
+ *
+ * The grids returned by bathymetry() and sound_speed() point into
+ * the memory map.  This snapshot must not be destroyed until all of
+ * those grids, and any ocean_model built from them, have been destroyed.
+ */
+class USML_DECLSPEC ocean_snapshot {
+
+public:
+
+    /** Grids stored in the snapshot, in the order of their descriptions. */
+    typedef enum {
+        BATHYMETRY, SOUND_SPEED, NUM_GRIDS
+    } grid_type ;
+
+    /**
+     * Write grids, and their derivative tables, to a snapshot file.
+     * Either grid may be NULL if it is not needed.  To share the
+     * snapshot in memory, write it to a RAM backed file system.
+     *
+     * @param   filename    Name of the file to write.
+     * @param   bathymetry  Depth of the ocean bottom (or NULL).
+     * @param   sound_speed Speed of sound in the water column (or NULL).
+     * @throws  std::invalid_argument if file can not be written.
+     */
+    static void write( const char* filename,
+                       const data_grid_bathy* bathymetry,
+                       const data_grid_svp* sound_speed ) ;
+
+    /**
+     * Map an existing snapshot file into memory, read-only.
+     *
+     * @param   filename    Name of the snapshot file to read.
+     * @throws  std::invalid_argument if file is not a valid snapshot.
+     */
+    ocean_snapshot( const char* filename ) ;
+
+    /** Release the memory mapped file. */
+    ~ocean_snapshot() ;
+
+    /** True if the snapshot contains the requested grid. */
+    inline bool contains( grid_type grid ) const {
+        return _header->grid[grid].present != 0 ;
+    }
+
+    /**
+     * Create a bathymetry grid that uses the data and derivatives
+     * in this snapshot.  The caller takes ownership of the new grid.
+     *
+     * @return              Grid attached to the memory map.
+     * @throws  std::invalid_argument if bathymetry was not stored.
+     */
+    data_grid_bathy* bathymetry() const ;
+
+    /**
+     * Create a sound speed grid that uses the data and derivatives
+     * in this snapshot.  The caller takes ownership of the new grid.
+     *
+     * @return              Grid attached to the memory map.
+     * @throws  std::invalid_argument if sound speed was not stored.
+     */
+    data_grid_svp* sound_speed() const ;
+
+private:
+
+    /** Maximum number of dimensions in any grid. */
+    static const unsigned MAX_DIMS = 3 ;
+
+    /** Description of one grid in the snapshot. */
+    struct grid_header {
+        boost::uint32_t present ;
+        boost::uint32_t dims ;
+        boost::uint64_t size[MAX_DIMS] ;
+        boost::int32_t interp_type[MAX_DIMS] ;
+        boost::uint32_t edge_limit[MAX_DIMS] ;
+        boost::uint32_t linear[MAX_DIMS] ;
+        boost::uint32_t padding ;
+        double first[MAX_DIMS] ;
+        double increment[MAX_DIMS] ;
+        boost::uint64_t axis[MAX_DIMS] ;
+        boost::uint64_t data ;
+        boost::uint64_t derivatives ;
+    } ;
+
+    /** Fixed size header at the start of each snapshot file. */
+    struct header_type {
+        char magic[8] ;
+        boost::uint32_t version ;
+        boost::uint32_t flags ;
+        grid_header grid[NUM_GRIDS] ;
+    } ;
+
+    /** Start of the file contents in memory. */
+    const char* _data ;
+
+    /** Size of the file in bytes. */
+    boost::uint64_t _size ;
+
+    /** Header at the start of the file. */
+    const header_type* _header ;
+
+    /**
+     * Describe the axes and interpolation options of one grid, and
+     * reserve space for its blocks.
+     *
+     * @param   grid        Grid to describe.
+     * @param   num_derv    Number of derivative values.
+     * @param   desc        Description of the grid (output).
+     * @param   offset      Location of the first block.  Updated to
+     *                      the location after the last block (output).
+     */
+    template<unsigned NUM_DIMS> static void describe(
+        const data_grid<double,NUM_DIMS>& grid, boost::uint64_t num_derv,
+        grid_header& desc, boost::uint64_t& offset ) ;
+
+    /**
+     * Re-create the axes of one grid from the snapshot.
+     * The caller is responsible for deleting them.
+     *
+     * @param   desc        Description of the grid.
+     * @param   axis        New axes (output).
+     */
+    void axes( const grid_header& desc, seq_vector* axis[] ) const ;
+
+    /** Release the memory used to store the file contents. */
+    void unmap() ;
+
+    // prevent copies of the memory map
+
+    ocean_snapshot( const ocean_snapshot& ) ;
+    ocean_snapshot& operator=( const ocean_snapshot& ) ;
+} ;
+
+/// @}
+}  // end of namespace ocean
+}  // end of namespace usml
+
+#endif
@@ -15,13 +15,29 @@ void profile_catenary::sound_speed( const wposition& location,
     matrix<double>* speed, wvector* gradient
 ) {
     if (gradient) gradient->clear() ;
-    
-    *speed = _soundspeed1 * cosh( 
-        ( location.altitude() + _depth1 ) / (-_gradient1) ) ;
-    if ( gradient ) {
-        gradient->rho( - sinh( ( location.altitude() + _depth1 ) 
-            / (-_gradient1) ) * (_soundspeed1/_gradient1) ) ;
+    if ( speed->size1() != location.size1()
+         || speed->size2() != location.size2() )
+    {
+        speed->resize( location.size1(), location.size2(), false ) ;
+    }
+
+    // compute speed and gradient together, one location at a time,
+    // so that the argument of cosh() and sinh() is only computed once,
+    // and the flat earth correction is applied in the same pass
+
+    const double scale = -1.0 / _gradient1 ;
+    const double grad_scale = -_soundspeed1 / _gradient1 ;
+    const bool flat = _flat_earth ;
+    for ( unsigned r=0 ; r < location.size1() ; ++r ) {
+        for ( unsigned c=0 ; c < location.size2() ; ++c ) {
+            const double x = ( location.altitude(r,c) + _depth1 ) * scale ;
+            double s = _soundspeed1 * std::cosh(x) ;
+            if (flat || gradient) {
+                double g = std::sinh(x) * grad_scale ;
+                if (flat) adjust_speed( location.rho(r,c), &s, &g ) ;
+                if (gradient) gradient->rho( r, c, g ) ;
+            }
+            (*speed)(r,c) = s ;
+        }
     }
-    
-    adjust_speed( location, speed, gradient ) ;
 }
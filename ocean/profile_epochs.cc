@@ -0,0 +1,172 @@
+/**
+ * @file profile_epochs.cc
+ * Sound speed profiles for a series of forecast epochs.
+ */
+#include <usml/ocean/profile_epochs.h>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+
+using namespace usml::ocean ;
+
+/**
+ * Define the epochs and the source of their data.
+ */
+profile_epochs::profile_epochs( const seq_vector& times,
+    epoch_loader* loader, unsigned max_slabs )
+    : _times( times.clone() ), _loader( loader ),
+      _max_slabs( std::max( 1u, max_slabs ) )
+{
+    _axis[0] = _axis[1] = _axis[2] = NULL ;
+}
+
+/**
+ * Release the loader and any cached slabs.
+ */
+profile_epochs::~profile_epochs() {
+    _cache.clear() ;
+    for ( unsigned n=0 ; n < 3 ; ++n ) {
+        delete _axis[n] ;
+    }
+    delete _loader ;
+    delete _times ;
+}
+
+/**
+ * Index of the epoch closest to a specific time.
+ */
+unsigned profile_epochs::epoch( double time ) const {
+    const unsigned N = size() ;
+    if ( N < 2 ) return 0 ;
+    const unsigned n = (unsigned) _times->find_index( time ) ;
+    if ( time <= (*_times)(n) ) return n ;
+    if ( n + 1 >= N ) return N - 1 ;
+    return ( time - (*_times)(n) < (*_times)(n+1) - time ) ? n : n + 1 ;
+}
+
+/**
+ * Create a sound speed model for a single epoch.
+ */
+profile_model* profile_epochs::profile( unsigned epoch,
+                                        attenuation_model* attmodel )
+{
+    return new profile_epoch( epoch, slab(epoch), attmodel ) ;
+}
+
+/**
+ * Number of slabs currently cached by the store.
+ */
+unsigned profile_epochs::num_cached() const {
+    boost::mutex::scoped_lock lock( _mutex ) ;
+    return (unsigned) _cache.size() ;
+}
+
+/**
+ * Find the grid for a single epoch, loading it if needed.
+ */
+profile_epochs::slab_type profile_epochs::slab( unsigned epoch ) {
+    if ( epoch >= size() ) {
+        throw std::invalid_argument("epoch is outside of time axis") ;
+    }
+
+    // wait for any other thread that is already loading this epoch
+
+    {
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        while ( _loading.count( epoch ) ) {
+            _loaded.wait( lock ) ;
+        }
+        slab_type result = cached( epoch ) ;
+        if ( result ) return result ;
+        _loading.insert( epoch ) ;
+    }
+
+    // load new slabs without blocking the cache
+
+    slab_type result ;
+    try {
+        std::auto_ptr< data_grid<double,3> > grid ;
+        {
+            boost::mutex::scoped_lock load_lock( _load_mutex ) ;
+            grid.reset( _loader->load( epoch ) ) ;
+            check_axes( *grid ) ;
+        }
+        result.reset( new data_grid_svp( *grid, true ) ) ;
+    } catch ( ... ) {
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        _loading.erase( epoch ) ;
+        _loaded.notify_all() ;
+        throw ;
+    }
+
+    // add the new slab, evict the least recently used slabs,
+    // and wake up the threads waiting for this epoch
+
+    boost::mutex::scoped_lock lock( _mutex ) ;
+    _loading.erase( epoch ) ;
+    _cache.push_front( std::make_pair( epoch, result ) ) ;
+    while ( _cache.size() > _max_slabs ) {
+        _cache.pop_back() ;
+    }
+    _loaded.notify_all() ;
+    return result ;
+}
+
+/**
+ * Find a cached slab, and make it the most recently used slab.
+ */
+profile_epochs::slab_type profile_epochs::cached( unsigned epoch ) {
+    for ( cache_type::iterator iter = _cache.begin() ;
+          iter != _cache.end() ; ++iter )
+    {
+        if ( iter->first == epoch ) {
+            _cache.splice( _cache.begin(), _cache, iter ) ;
+            return _cache.front().second ;
+        }
+    }
+    return slab_type() ;
+}
+
+/**
+ * Check that a new grid uses the same axes as the first epoch loaded.
+ */
+void profile_epochs::check_axes( const data_grid<double,3>& grid ) {
+    if ( _axis[0] == NULL ) {
+        for ( unsigned n=0 ; n < 3 ; ++n ) {
+            _axis[n] = grid.axis(n)->clone() ;
+        }
+        return ;
+    }
+    for ( unsigned n=0 ; n < 3 ; ++n ) {
+        const seq_vector& axis = *grid.axis(n) ;
+        bool same = axis.size() == _axis[n]->size() ;
+        for ( size_t i=0 ; same && i < axis.size() ; ++i ) {
+            same = axis(i) == (*_axis[n])(i) ;
+        }
+        if ( ! same ) {
+            throw std::invalid_argument(
+                "all epochs must use the same axes") ;
+        }
+    }
+}
+
+/**
+ * Attach to the slab for a single epoch.
+ */
+profile_epoch::profile_epoch( unsigned epoch,
+    boost::shared_ptr<data_grid_svp> slab, attenuation_model* attmodel )
+    : profile_grid_fast( attach(*slab), attmodel ),
+      _epoch( epoch ), _slab( slab )
+{
+}
+
+/**
+ * Create a grid attached to the data and derivatives of a slab.
+ */
+data_grid_svp* profile_epoch::attach( const data_grid_svp& slab ) {
+    seq_vector* axis[3] ;
+    for ( unsigned n=0 ; n < 3 ; ++n ) {
+        axis[n] = const_cast<seq_vector*>( slab.axis(n) ) ;
+    }
+    return new data_grid_svp( axis, slab.data(), slab.derivatives() ) ;
+}
@@ -0,0 +1,243 @@
+/**
+ * @file profile_epochs.h
+ * Sound speed profiles for a series of forecast epochs.
+ */
+#ifndef USML_OCEAN_PROFILE_EPOCHS_H
+#define USML_OCEAN_PROFILE_EPOCHS_H
+
+#include <usml/ocean/profile_grid_fast.h>
+#include <usml/types/data_grid_svp.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <list>
+#include <set>
+#include <utility>
+
+namespace usml {
+namespace ocean {
+
+/// @ingroup profiles
+/// @{
+
+/**
+ * Creates the 3-D sound speed grid for a single epoch on demand.
+ * Implementations typically read one netcdf_profile for each forecast
+ * time, and convert it to sound speed with data_grid_mackenzie.
+ * Every epoch must use the same (altitude, latitude, longitude) axes.
+ * The profile_epochs store only calls load() from one thread at a time.
+ */
+class USML_DECLSPEC epoch_loader {
+public:
+
+    /** Virtual destructor. */
+    virtual ~epoch_loader() {}
+
+    /**
+     * Create the sound speed grid for a single epoch.
+     *
+     * @param epoch     Index of the epoch in the time axis.
+     * @return          Sound speed for this epoch (m/s).  The
+     *                  profile_epochs store takes ownership of this
+     *                  grid, and deletes it after copying its data.
+     */
+    virtual data_grid<double,3>* load( unsigned epoch ) = 0 ;
+} ;
+
+/**
+ * Sound speed profiles for a series of forecast epochs, where time is
+ * an extra axis in front of (altitude, latitude, longitude).  A batch
+ * run that sweeps over many hourly forecasts would otherwise build a
+ * new netcdf_profile, data_grid_svp, and ocean_model for every epoch.
+ *
+ * This store loads the grid for each epoch the first time it is
+ * needed, and computes its PCHIP depth derivatives once.  Slabs are
+ * loaded without blocking other threads that use the cache, and threads
+ * that need an epoch that is already being loaded wait for it, instead
+ * of loading it a second time.  Only the most
+ * recently used slabs are kept in memory; the least recently used slab
+ * is evicted when a new epoch is loaded.  The profile() method hands
+ * out a light weight profile_model for a single epoch.  Each view
+ * shares the data and derivatives of its slab, but has its own
+ * interpolation work space, so that views for the same epoch can be
+ * used in different threads.  A slab that is evicted while views are
+ * still using it stays in memory until the last of those views is
+ * destroyed.  The store itself is safe for concurrent use.
+ *
+ * The store must not be destroyed before the views it created.
+ */
+class USML_DECLSPEC profile_epochs {
+
+public:
+
+    /**
+     * Define the epochs and the source of their data.
+     *
+     * @param times         Time of each epoch, in any units, in
+     *                      increasing order.  Copied with clone().
+     * @param loader        Creates the sound speed for each epoch.
+     *                      The store takes over ownership of this
+     *                      reference and deletes it in its destructor.
+     * @param max_slabs     Maximum number of epochs to keep in memory.
+     */
+    profile_epochs( const seq_vector& times, epoch_loader* loader,
+                    unsigned max_slabs = 2 ) ;
+
+    /** Release the loader and any cached slabs. */
+    ~profile_epochs() ;
+
+    /** Time of each epoch. */
+    inline const seq_vector* times() const {
+        return _times ;
+    }
+
+    /** Number of epochs in the time axis. */
+    inline unsigned size() const {
+        return (unsigned) _times->size() ;
+    }
+
+    /**
+     * Index of the epoch closest to a specific time.
+     * Times outside of the axis use the first or last epoch.
+     *
+     * @param time          Time in the same units as times().
+     */
+    unsigned epoch( double time ) const ;
+
+    /**
+     * Create a sound speed model for a single epoch.  Loads the
+     * data for that epoch if it is not already in memory.
+     *
+     * @param epoch         Index of the epoch in the time axis.
+     * @param attmodel      In-water attenuation model.  Defaults to Thorp.
+     *                      The new profile takes over ownership of this
+     *                      reference and deletes it as part of its
+     *                      destructor.
+     * @return              Profile for this epoch.  The caller takes
+     *                      ownership of this model, and usually passes
+     *                      it to an ocean_model.
+     * @throws std::invalid_argument if the epoch is out of range, or if
+     *                      its axes don't match the first epoch loaded.
+     */
+    profile_model* profile( unsigned epoch,
+                            attenuation_model* attmodel = NULL ) ;
+
+    /** Number of slabs currently cached by the store. */
+    unsigned num_cached() const ;
+
+private:
+
+    /** Shared ownership of the grid for a single epoch. */
+    typedef boost::shared_ptr<data_grid_svp> slab_type ;
+
+    /** Cached slabs, most recently used at the front. */
+    typedef std::list< std::pair<unsigned,slab_type> > cache_type ;
+
+    /** Time of each epoch. */
+    seq_vector* _times ;
+
+    /** Creates the sound speed for each epoch. */
+    epoch_loader* _loader ;
+
+    /** Maximum number of epochs to keep in memory. */
+    const unsigned _max_slabs ;
+
+    /** Axes of the first epoch loaded, used to check the other epochs. */
+    seq_vector* _axis[3] ;
+
+    /** Cached slabs, most recently used at the front. */
+    cache_type _cache ;
+
+    /** Protects the cache from concurrent updates. */
+    mutable boost::mutex _mutex ;
+
+    /** Serializes calls to the loader, and checks of their axes. */
+    boost::mutex _load_mutex ;
+
+    /** Epochs that are being loaded, protected by the cache lock. */
+    std::set<unsigned> _loading ;
+
+    /** Signals that an epoch is no longer being loaded. */
+    boost::condition_variable _loaded ;
+
+    /**
+     * Find the grid for a single epoch, and make it the most recently
+     * used slab.  Loads the grid if it is not in the cache, or waits for
+     * another thread that is already loading it.  The loader and the
+     * derivative calculation run without holding the cache lock.
+     *
+     * @param epoch         Index of the epoch in the time axis.
+     */
+    slab_type slab( unsigned epoch ) ;
+
+    /**
+     * Find a cached slab, and make it the most recently used slab.
+     * The caller must hold the cache lock.
+     *
+     * @param epoch         Index of the epoch in the time axis.
+     * @return              Cached slab, or an empty pointer if not found.
+     */
+    slab_type cached( unsigned epoch ) ;
+
+    /**
+     * Check that a new grid uses the same axes as the first epoch loaded.
+     * The caller must hold the loader lock.
+     *
+     * @param grid          Grid created by the loader.
+     * @throws std::invalid_argument if the axes don't match.
+     */
+    void check_axes( const data_grid<double,3>& grid ) ;
+
+    // prevent copies of the cache
+
+    profile_epochs( const profile_epochs& ) ;
+    profile_epochs& operator=( const profile_epochs& ) ;
+} ;
+
+/**
+ * Light weight sound speed model for a single epoch of a
+ * profile_epochs store.  A profile_grid_fast whose grid is attached to
+ * the data and derivatives of a shared slab.  Keeps that slab alive
+ * until this model is destroyed.
+ */
+class USML_DECLSPEC profile_epoch : public profile_grid_fast {
+
+public:
+
+    /**
+     * Attach to the slab for a single epoch.
+     *
+     * @param epoch         Index of the epoch in the time axis.
+     * @param slab          Shared grid for this epoch.
+     * @param attmodel      In-water attenuation model.  Defaults to Thorp.
+     */
+    profile_epoch( unsigned epoch, boost::shared_ptr<data_grid_svp> slab,
+                   attenuation_model* attmodel = NULL ) ;
+
+    /** Index of the epoch in the time axis. */
+    inline unsigned epoch() const {
+        return _epoch ;
+    }
+
+private:
+
+    /** Index of the epoch in the time axis. */
+    const unsigned _epoch ;
+
+    /** Shared grid, kept alive while this view exists. */
+    boost::shared_ptr<data_grid_svp> _slab ;
+
+    /**
+     * Create a grid attached to the data and derivatives of a slab.
+     *
+     * @param slab          Shared grid for this epoch.
+     * @return              New interpolator for the slab.
+     */
+    static data_grid_svp* attach( const data_grid_svp& slab ) ;
+} ;
+
+/// @}
+}  // end of namespace ocean
+}  // end of namespace usml
+
+#endif
@@ -16,21 +16,24 @@ void profile_linear::sound_speed( const wposition& location,
 ) {
     if (gradient) gradient->clear() ;
     
+    const double speed1 = _soundspeed0 + _gradient0 * _depth1 ;
+    const bool flat = _flat_earth ;
     for ( unsigned r=0 ; r < location.size1() ; ++r ) {
         for ( unsigned c=0 ; c < location.size2() ; ++c ) {
-            double z = -location.altitude(r,c) ;
+            const double z = -location.altitude(r,c) ;
+            double s, g ;
             if ( z < _depth1 ) {
-                (*speed)(r,c) = _soundspeed0 
-                              + _gradient0 * z ;
-                if (gradient) gradient->rho(r,c,-_gradient0) ;
+                s = _soundspeed0 
+                  + _gradient0 * z ;
+                g = -_gradient0 ;
             } else {
-                (*speed)(r,c) = _soundspeed0 
-                              + _gradient0 * _depth1 
-                              + _gradient1 * (z-_depth1);
-                if (gradient) gradient->rho(r,c,-_gradient1) ;
+                s = speed1
+                  + _gradient1 * (z-_depth1);
+                g = -_gradient1 ;
             }
+            if (flat) adjust_speed( location.rho(r,c), &s, &g ) ;
+            (*speed)(r,c) = s ;
+            if (gradient) gradient->rho(r,c,g) ;
         }
     }
-    
-    adjust_speed( location, speed, gradient ) ;
 }
@@ -14,14 +14,23 @@ using namespace usml::ocean ;
 void profile_model::adjust_speed( const wposition& location, 
     matrix<double>* speed, wvector* gradient )
 {
-    if ( _flat_earth ) {
-        if ( gradient ) {
-            gradient->rho( 
-                ( element_prod( gradient->rho(), location.rho() ) + *speed )
-                / wposition::earth_radius ,
-                false ) ;
+    if ( ! _flat_earth ) return ;
+
+    // correct speed and gradient together, one location at a time,
+    // to avoid building temporary matrices for the whole wavefront
+
+    for ( unsigned r=0 ; r < location.size1() ; ++r ) {
+        for ( unsigned c=0 ; c < location.size2() ; ++c ) {
+            const double rho = location.rho(r,c) ;
+            double s = (*speed)(r,c) ;
+            if ( gradient ) {
+                double g = gradient->rho(r,c) ;
+                adjust_speed( rho, &s, &g ) ;
+                gradient->rho( r, c, g ) ;
+            } else {
+                s *= rho / wposition::earth_radius ;
+            }
+            (*speed)(r,c) = s ;
         }
-        *speed = element_prod( *speed, location.rho() ) 
-               / wposition::earth_radius ;
     }
 }
@@ -139,6 +139,26 @@ public:
     virtual void adjust_speed( const wposition& location,
         matrix<double>* speed, wvector* gradient=NULL ) ;
 
+    /**
+     * Applies the flat earth anti-correction at a single location.
+     * Used by profiles that compute speed and gradient one location at
+     * a time, so that the correction is applied in the same pass,
+     * instead of making extra passes over the whole wavefront in
+     * adjust_speed().  The caller is responsible for only calling this
+     * when the flat earth option is enabled.
+     *
+     * @param rho           Radial component of the location.
+     * @param speed         Speed of sound (m/s) at the location (in/out).
+     * @param gradient      Radial component of the sound speed gradient
+     *                      at the location (in/out).
+     */
+    static inline void adjust_speed( double rho,
+        double* speed, double* gradient )
+    {
+        *gradient = ( *gradient * rho + *speed ) / wposition::earth_radius ;
+        *speed = *speed * rho / wposition::earth_radius ;
+    }
+
     /** Anti-correction term to make the earth seem flat. */
     bool _flat_earth ;
 
@@ -15,13 +15,30 @@ void profile_munk::sound_speed( const wposition& location,
     matrix<double>* speed, wvector* gradient
 ) {
     if (gradient) gradient->clear() ;
-    
-    matrix<double> z = 2 * ( -location.altitude() - _axis_depth ) / _scale ;
-    *speed = ( ( (z-1.0) + exp(-z) ) * _epsilon + 1.0 ) * _axis_speed ;
-    if ( gradient ) {
-        gradient->rho( (1.0-exp(-z)) * (-_epsilon*_axis_speed*2/_scale) ) ;
+    if ( speed->size1() != location.size1()
+         || speed->size2() != location.size2() )
+    {
+        speed->resize( location.size1(), location.size2(), false ) ;
+    }
+
+    // compute speed and gradient together, one location at a time,
+    // so that exp() is only computed once for each location,
+    // and the flat earth correction is applied in the same pass
+
+    const double scale = 2.0 / _scale ;
+    const double slope = _epsilon * _axis_speed ;
+    const double grad_scale = -slope * scale ;
+    const bool flat = _flat_earth ;
+    for ( unsigned r=0 ; r < location.size1() ; ++r ) {
+        for ( unsigned c=0 ; c < location.size2() ; ++c ) {
+            const double z = ( -location.altitude(r,c) - _axis_depth ) * scale ;
+            const double e = std::exp(-z) ;
+            double s = _axis_speed + slope * ( (z-1.0) + e ) ;
+            double g = (1.0-e) * grad_scale ;
+            if (flat) adjust_speed( location.rho(r,c), &s, &g ) ;
+            (*speed)(r,c) = s ;
+            if (gradient) gradient->rho( r, c, g ) ;
+        }
     }
-    
-    adjust_speed( location, speed, gradient ) ;
 }
 
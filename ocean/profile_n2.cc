@@ -14,12 +14,27 @@ using namespace usml::ocean ;
 void profile_n2::sound_speed( const wposition& location, 
     matrix<double>* speed, wvector* gradient
 ) {
-    *speed = _soundspeed0 / sqrt( 1.0 - location.altitude() * _factor ) ;
-    if ( gradient ) {
-        gradient->clear() ;
-        gradient->rho( pow(*speed,3.0) 
-                     * _factor / (2.0*_soundspeed0*_soundspeed0) ) ;
+    if (gradient) gradient->clear() ;
+    if ( speed->size1() != location.size1()
+         || speed->size2() != location.size2() )
+    {
+        speed->resize( location.size1(), location.size2(), false ) ;
+    }
+
+    // compute speed and gradient together, one location at a time,
+    // reusing the speed to compute the cube in the gradient,
+    // and applying the flat earth correction in the same pass
+
+    const double grad_scale = _factor / (2.0*_soundspeed0*_soundspeed0) ;
+    const bool flat = _flat_earth ;
+    for ( unsigned r=0 ; r < location.size1() ; ++r ) {
+        for ( unsigned c=0 ; c < location.size2() ; ++c ) {
+            double s = _soundspeed0
+                / std::sqrt( 1.0 - location.altitude(r,c) * _factor ) ;
+            double g = s * s * s * grad_scale ;
+            if (flat) adjust_speed( location.rho(r,c), &s, &g ) ;
+            (*speed)(r,c) = s ;
+            if (gradient) gradient->rho( r, c, g ) ;
+        }
     }
-    
-    adjust_speed( location, speed, gradient ) ;
 }
@@ -4,7 +4,10 @@
 #include <boost/test/unit_test.hpp>
 #include <usml/netcdf/netcdf_files.h>
 #include <usml/ocean/ocean.h>
+#include <usml/types/data_grid_unrolled.h>
 #include <fstream>
+#include <iterator>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(boundary_test)
 
@@ -94,6 +97,61 @@ BOOST_AUTO_TEST_CASE( sloped_boundary_test ) {
     BOOST_CHECK_CLOSE(normal.rho(), sqrt(1.0 - sin(alpha) * sin(alpha)), 1e-6);
 }
 
+/**
+ * Test a boundary_grid built on a data_grid_unrolled with PCHIP
+ * interpolation.  The heights and normals must match those of a
+ * boundary_grid built on a normal data_grid, with quick_interp both
+ * on and off.  Turning quick_interp on must switch both grids to
+ * linear interpolation, even though the unrolled grid was compiled
+ * for PCHIP.  Locations stay away from the edges of the grid, so that
+ * every PCHIP interval has a neighbor on each side.
+ */
+BOOST_AUTO_TEST_CASE( unrolled_boundary_test ) {
+    cout << "=== boundary_test: unrolled_boundary_test ===" << endl;
+
+    seq_vector* axis[2] ;
+    axis[0] = new seq_linear( to_colatitude(36.0), to_radians(0.1), 8 ) ;
+    axis[1] = new seq_linear( to_radians(15.0), to_radians(0.1), 8 ) ;
+    data_grid<double,2> grid( axis ) ;
+    delete axis[0] ;
+    delete axis[1] ;
+    unsigned index[2] ;
+    for ( index[0]=0 ; index[0] < 8 ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < 8 ; ++index[1] ) {
+            grid.data( index, wposition::earth_radius - 1000.0
+                - 50.0 * index[0] * index[0] + 20.0 * index[1] ) ;
+        }
+    }
+    boundary_grid<double,2> normal_model(
+        new data_grid<double,2>( grid, true ) ) ;
+    boundary_grid<double,2> fast_model( new data_grid_unrolled<double,2,
+        GRID_INTERP_PCHIP,GRID_INTERP_PCHIP>( grid, true ) ) ;
+
+    for ( int quick=0 ; quick < 2 ; ++quick ) {
+        double change = 0.0 ;
+        for ( unsigned n=0 ; n < 10 ; ++n ) {
+            wposition1 location( 35.85 - 0.04 * n, 15.15 + 0.04 * n ) ;
+            double depth, fast_depth, pchip_depth ;
+            wvector1 normal, fast_normal ;
+            normal_model.height( location, &depth, &normal, quick != 0 ) ;
+            fast_model.height( location, &fast_depth, &fast_normal,
+                               quick != 0 ) ;
+            BOOST_CHECK_CLOSE( fast_depth, depth, 1e-10 ) ;
+            BOOST_CHECK_CLOSE( fast_normal.rho(), normal.rho(), 1e-10 ) ;
+            BOOST_CHECK_SMALL( fast_normal.theta() - normal.theta(), 1e-12 ) ;
+            BOOST_CHECK_SMALL( fast_normal.phi() - normal.phi(), 1e-12 ) ;
+
+            fast_model.height( location, &pchip_depth, NULL, false ) ;
+            change = max( change, abs( fast_depth - pchip_depth ) ) ;
+        }
+        if ( quick ) {
+            BOOST_CHECK( change > 1e-3 ) ;
+        } else {
+            BOOST_CHECK_EQUAL( change, 0.0 ) ;
+        }
+    }
+}
+
 /**
  * Extract Malta Escarpment bathymetry from March 2010 version of ETOPO1.
  * Compare results to data extracted from this database by hand.
@@ -280,6 +338,220 @@ BOOST_AUTO_TEST_CASE( ascii_arc_test ) {
     BOOST_CHECK_CLOSE(wposition::earth_radius - depth, 681.0, 0.3);
 }
 
+/**
+ * Test the replacement of missing depths in ASCII files with an ARC header.
+ * The test file has 3 latitudes and 4 longitudes, and the north-east and
+ * south-west corners are set to the NODATA_VALUE.  These cells must be
+ * replaced by the fill value, and all other depths must be unchanged.
+ * A file whose header ends early must be rejected.
+ */
+BOOST_AUTO_TEST_CASE( ascii_arc_nodata ) {
+    cout << "=== boundary_test: ascii_arc_nodata ===" << endl;
+    ascii_arc_bathy grid( USML_TEST_DIR "/ocean/test/ascii_arc_nodata.asc",
+                          -1500.0 ) ;
+
+    BOOST_CHECK_EQUAL( grid.axis(0)->size(), 3 );              //rows
+    BOOST_CHECK_EQUAL( grid.axis(1)->size(), 4 );              //columns
+
+    unsigned index[2] ;
+    index[0]=0; index[1]=0; BOOST_CHECK_CLOSE(wposition::earth_radius - grid.data(index), 1000.0, 1e-6);
+    index[0]=0; index[1]=3; BOOST_CHECK_CLOSE(wposition::earth_radius - grid.data(index), 1500.0, 1e-6);
+    index[0]=1; index[1]=3; BOOST_CHECK_CLOSE(wposition::earth_radius - grid.data(index), 1310.0, 1e-6);
+    index[0]=2; index[1]=0; BOOST_CHECK_CLOSE(wposition::earth_radius - grid.data(index), 1500.0, 1e-6);
+    index[0]=2; index[1]=3; BOOST_CHECK_CLOSE(wposition::earth_radius - grid.data(index), 1320.0, 1e-6);
+
+    const char* truncated = USML_TEST_DIR "/ocean/test/ascii_arc_truncated.asc" ;
+    {
+        std::ofstream os( truncated ) ;
+        os << "NCOLS   4\nNROWS  3\nXLLCORNER  -80.25000\nYLLCORNER\n" ;
+    }
+    BOOST_CHECK_THROW( ascii_arc_bathy bad( truncated ), std::invalid_argument ) ;
+}
+
+/**
+ * Test the conversion of numbers by the ascii_parser.  A small file of
+ * integers, decimals, exponents, values with too many digits for the
+ * fast path, and "nan" and "inf" is read in a single thread, and then
+ * again in four threads, using a tiny block size to force the text to
+ * be split into several blocks.  Both must match strtod() exactly, and
+ * a partial read must stop at the right place.  Malformed numbers must
+ * be rejected in both modes, as must numbers too long for strtod().
+ */
+BOOST_AUTO_TEST_CASE( ascii_parser_test ) {
+    cout << "=== boundary_test: ascii_parser_test ===" << endl;
+    const char* filename = USML_TEST_DIR "/ocean/test/ascii_parser_test.txt";
+    const char* badname = USML_TEST_DIR "/ocean/test/ascii_parser_bad.txt";
+    const char* words[] = {
+        "0", "-17", "+42", "3.25", "-0.001", ".5", "7.", "1e3", "-2.25E-2",
+        "6.02214076e23", "1.7976931348623157e308", "4.9e-324",
+        "3.14159265358979323846", "123456789012345678901234", "1e-30",
+        "nan", "inf", "-inf"
+    } ;
+    const size_t num_words = sizeof(words) / sizeof(words[0]) ;
+    const size_t N = 40 * num_words ;
+
+    std::vector<double> expected( N ) ;
+    {
+        std::ofstream os( filename ) ;
+        for ( size_t n=0 ; n < N ; ++n ) {
+            const char* word = words[ n % num_words ] ;
+            expected[n] = strtod( word, NULL ) ;
+            os << word << ( ( n % 7 == 6 ) ? "\n" : ( n % 3 ) ? ", " : "\t" ) ;
+        }
+    }
+
+    // serial and parallel reads of the whole file
+
+    std::vector<double> serial( N + 1 ), parallel( N + 1 ) ;
+    ascii_parser one( filename ) ;
+    BOOST_CHECK_EQUAL( one.read( &serial[0], N + 1, 1 ), N ) ;
+    ascii_parser four( filename ) ;
+    BOOST_CHECK_EQUAL( four.read( &parallel[0], N + 1, 4, 64 ), N ) ;
+    for ( size_t n=0 ; n < N ; ++n ) {
+        if ( expected[n] != expected[n] ) {
+            BOOST_CHECK( serial[n] != serial[n] ) ;
+            BOOST_CHECK( parallel[n] != parallel[n] ) ;
+        } else {
+            BOOST_CHECK_EQUAL( serial[n], expected[n] ) ;
+            BOOST_CHECK_EQUAL( parallel[n], expected[n] ) ;
+        }
+    }
+
+    // parallel read that stops in the middle of the file
+
+    ascii_parser part( filename ) ;
+    const size_t half = N / 2 + 3 ;
+    BOOST_CHECK_EQUAL( part.read( &parallel[0], half, 4, 64 ), half ) ;
+    double value ;
+    BOOST_CHECK( part.next( value ) ) ;
+    BOOST_CHECK_EQUAL( value, expected[half] ) ;
+
+    // malformed numbers, in a later block of the parallel read
+
+    {
+        std::ofstream os( badname ) ;
+        for ( size_t n=0 ; n < N ; ++n ) {
+            os << ( ( n == N - 10 ) ? "1.5x" : words[1] ) << " " ;
+        }
+    }
+    ascii_parser bad_one( badname ) ;
+    BOOST_CHECK_THROW( bad_one.read( &serial[0], N, 1 ),
+                       std::invalid_argument ) ;
+    ascii_parser bad_four( badname ) ;
+    BOOST_CHECK_THROW( bad_four.read( &parallel[0], N, 4, 64 ),
+                       std::invalid_argument ) ;
+
+    const char* texts[] = { "abc", "1.2.3", "--5", "1e", "0x",
+        "1.0000000000000000000000000000000000000000000000000000000000000001" } ;
+    for ( size_t n=0 ; n < sizeof(texts) / sizeof(texts[0]) ; ++n ) {
+        const char* ptr = texts[n] ;
+        BOOST_CHECK_THROW( ascii_parser::parse( ptr, ptr + strlen(ptr) ),
+                           std::invalid_argument ) ;
+    }
+}
+
+/**
+ * Test the ability to share bathymetry and sound speed grids through
+ * a memory mapped ocean_snapshot.  Grids attached to the snapshot must
+ * interpolate exactly the same values and derivatives as the grids
+ * that were written to it.  The depth axis of the sound speed grid
+ * is not evenly spaced, so that both kinds of axes are tested.
+ */
+BOOST_AUTO_TEST_CASE( ocean_snapshot_test ) {
+    cout << "=== boundary_test: ocean_snapshot_test ===" << endl;
+    const char* name = USML_TEST_DIR "/ocean/test/ocean_snapshot_test.bin" ;
+
+    // build bathymetry and sound speed grids
+
+    seq_vector* axis[3] ;
+    axis[0] = new seq_linear( to_colatitude(36.0), to_radians(0.1), 8 ) ;
+    axis[1] = new seq_linear( to_radians(15.0), to_radians(0.1), 9 ) ;
+    data_grid<double,2> depth( axis ) ;
+    unsigned index[3] ;
+    for ( index[0]=0 ; index[0] < 8 ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < 9 ; ++index[1] ) {
+            depth.data( index, wposition::earth_radius
+                - 1000.0 - 50.0 * index[0] - 20.0 * index[1] * index[1] ) ;
+        }
+    }
+    depth.interp_type( 0, GRID_INTERP_PCHIP ) ;
+    depth.interp_type( 1, GRID_INTERP_PCHIP ) ;
+    data_grid_bathy bathy( depth, true ) ;
+    delete axis[0] ;
+    delete axis[1] ;
+
+    const double levels[] = { 0.0, 10.0, 30.0, 75.0, 150.0, 300.0, 1000.0 } ;
+    vector<double> rho( 7 ) ;
+    for ( unsigned n=0 ; n < 7 ; ++n ) {
+        rho(n) = wposition::earth_radius - levels[n] ;
+    }
+    axis[0] = new seq_data( rho ) ;
+    axis[1] = new seq_linear( to_colatitude(36.0), to_radians(0.2), 4 ) ;
+    axis[2] = new seq_linear( to_radians(15.0), to_radians(0.2), 5 ) ;
+    data_grid<double,3> speed( axis ) ;
+    for ( index[0]=0 ; index[0] < 7 ; ++index[0] ) {
+        for ( index[1]=0 ; index[1] < 4 ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < 5 ; ++index[2] ) {
+                speed.data( index, 1500.0 - 0.02 * levels[index[0]]
+                    + 0.5 * index[1] + 0.1 * index[2] ) ;
+            }
+        }
+    }
+    data_grid_svp svp( speed, true ) ;
+    for ( unsigned n=0 ; n < 3 ; ++n ) {
+        delete axis[n] ;
+    }
+
+    // compare original grids to the grids attached to the snapshot
+
+    ocean_snapshot::write( name, &bathy, &svp ) ;
+    ocean_snapshot snapshot( name ) ;
+    BOOST_CHECK( snapshot.contains( ocean_snapshot::BATHYMETRY ) ) ;
+    BOOST_CHECK( snapshot.contains( ocean_snapshot::SOUND_SPEED ) ) ;
+    data_grid_bathy* shared_bathy = snapshot.bathymetry() ;
+    data_grid_svp* shared_svp = snapshot.sound_speed() ;
+    BOOST_CHECK_EQUAL( shared_bathy->interp_type(0), GRID_INTERP_PCHIP ) ;
+    BOOST_CHECK_EQUAL( shared_svp->axis(0)->size(), 7 ) ;
+
+    for ( unsigned n=0 ; n < 10 ; ++n ) {
+        double loc[3], copy[3], derv[3], shared_derv[3] ;
+        loc[0] = to_colatitude( 35.97 - 0.06 * n ) ;
+        loc[1] = to_radians( 15.03 + 0.07 * n ) ;
+        copy[0] = loc[0] ; copy[1] = loc[1] ;
+        const double value = bathy.interpolate( loc, derv ) ;
+        BOOST_CHECK_EQUAL( shared_bathy->interpolate( copy, shared_derv ), value ) ;
+        BOOST_CHECK_EQUAL( shared_derv[0], derv[0] ) ;
+        BOOST_CHECK_EQUAL( shared_derv[1], derv[1] ) ;
+
+        loc[0] = wposition::earth_radius - 5.0 - 90.0 * n ;
+        loc[1] = to_colatitude( 35.95 - 0.05 * n ) ;
+        loc[2] = to_radians( 15.1 + 0.07 * n ) ;
+        copy[0] = loc[0] ; copy[1] = loc[1] ; copy[2] = loc[2] ;
+        const double c = svp.interpolate( loc, derv ) ;
+        BOOST_CHECK_EQUAL( shared_svp->interpolate( copy, shared_derv ), c ) ;
+        for ( unsigned d=0 ; d < 3 ; ++d ) {
+            BOOST_CHECK_EQUAL( shared_derv[d], derv[d] ) ;
+        }
+    }
+    delete shared_bathy ;
+    delete shared_svp ;
+
+    // snapshots that end before their last block are rejected
+
+    std::ifstream is( name, std::ios::in | std::ios::binary ) ;
+    std::vector<char> contents( (std::istreambuf_iterator<char>(is)),
+                                std::istreambuf_iterator<char>() ) ;
+    const char* cutname = USML_TEST_DIR "/ocean/test/ocean_snapshot_cut.bin" ;
+    const size_t lengths[] = { 200, contents.size() / 2, contents.size() - 8 } ;
+    for ( unsigned n=0 ; n < 3 ; ++n ) {
+        std::ofstream os( cutname, std::ios::out | std::ios::binary ) ;
+        os.write( &contents[0], lengths[n] ) ;
+        os.close() ;
+        BOOST_CHECK_THROW( ocean_snapshot cut( cutname ),
+                           std::invalid_argument ) ;
+    }
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
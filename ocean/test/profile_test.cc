@@ -4,6 +4,7 @@
 #include <boost/test/unit_test.hpp>
 #include <usml/netcdf/netcdf_files.h>
 #include <usml/ocean/ocean.h>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 
 BOOST_AUTO_TEST_SUITE(profile_test)
@@ -218,6 +219,277 @@ BOOST_AUTO_TEST_CASE( compute_mackenzie_test ) {
     }
 }
 
+/**
+ * Compare the sound speed equations supported by data_grid_mackenzie.
+ * Uses the Chen and Millero check value of 1731.995 m/s at a salinity of
+ * 40 ppt, a temperature of 40 degrees C, and a pressure of 1000 bar from
+ * UNESCO Technical Papers in Marine Science 44 (1983).  The Mackenzie,
+ * Del Grosso, and Chen and Millero equations should agree to within 0.1
+ * percent across a synthetic grid, and the in place, multi-threaded
+ * construction must give exactly the same answer as the default.
+ */
+BOOST_AUTO_TEST_CASE( compute_speed_equations_test ) {
+    cout << "=== profile_test: compute_speed_equations_test ===" << endl;
+
+    // find the depth for a pressure of 100 MPa, at 45 degrees latitude
+
+    double lo = 0.0 ;
+    double hi = 12000.0 ;
+    for (unsigned n = 0; n < 60; ++n) {
+        const double mid = 0.5 * (lo + hi) ;
+        if ( data_grid_mackenzie::pressure(mid, 45.0) < 100.0 ) {
+            lo = mid ;
+        } else {
+            hi = mid ;
+        }
+    }
+    const double T = 40.0 ;
+    const double S = 40.0 ;
+    double c ;
+    data_grid_mackenzie::compute( data_grid_mackenzie::CHEN_MILLERO,
+        0.5 * (lo + hi), 45.0, &T, &S, &c, 1 ) ;
+    BOOST_CHECK_CLOSE( c, 1731.995, 1e-4 );
+
+    // build synthetic temperature and salinity grids
+
+    seq_vector* axis[3] ;
+    axis[0] = new seq_linear( wposition::earth_radius - 5000.0, 100.0, 51 ) ;
+    axis[1] = new seq_linear( to_colatitude(30.0), to_radians(0.1), 40 ) ;
+    axis[2] = new seq_linear( to_radians(-60.0), to_radians(0.1), 50 ) ;
+    data_grid<double,3> temp( axis ) ;
+    data_grid<double,3> sal( axis ) ;
+    for (unsigned n = 0; n < 3; ++n) delete axis[n] ;
+
+    unsigned index[3] ;
+    for ( index[0]=0 ; index[0] < temp.axis(0)->size() ; ++index[0] ) {
+        const double depth = wposition::earth_radius - (*temp.axis(0))[index[0]] ;
+        for ( index[1]=0 ; index[1] < temp.axis(1)->size() ; ++index[1] ) {
+            for ( index[2]=0 ; index[2] < temp.axis(2)->size() ; ++index[2] ) {
+                temp.data( index, 2.0 + 20.0 * exp(-depth/1000.0)
+                    + 0.01 * index[1] ) ;
+                sal.data( index, 34.5 + 0.5 * exp(-depth/500.0)
+                    - 0.01 * index[2] ) ;
+            }
+        }
+    }
+
+    data_grid<double,3>* mackenzie = data_grid_mackenzie::construct(
+        new data_grid<double,3>(temp,true), new data_grid<double,3>(sal,true) ) ;
+    data_grid<double,3>* in_place = data_grid_mackenzie::construct(
+        new data_grid<double,3>(temp,true), new data_grid<double,3>(sal,true),
+        true, data_grid_mackenzie::MACKENZIE, 4 ) ;
+    data_grid<double,3>* del_grosso = data_grid_mackenzie::construct(
+        new data_grid<double,3>(temp,true), new data_grid<double,3>(sal,true),
+        false, data_grid_mackenzie::DEL_GROSSO ) ;
+    data_grid<double,3>* unesco = data_grid_mackenzie::construct(
+        new data_grid<double,3>(temp,true), new data_grid<double,3>(sal,true),
+        true, data_grid_mackenzie::CHEN_MILLERO, 3 ) ;
+
+    for ( index[0]=0 ; index[0] < temp.axis(0)->size() ; index[0] += 5 ) {
+        for ( index[1]=0 ; index[1] < temp.axis(1)->size() ; index[1] += 7 ) {
+            for ( index[2]=0 ; index[2] < temp.axis(2)->size() ; index[2] += 9 ) {
+                const double m = mackenzie->data(index) ;
+                BOOST_CHECK_EQUAL( in_place->data(index), m ) ;
+                BOOST_CHECK_CLOSE( del_grosso->data(index), m, 0.1 ) ;
+                BOOST_CHECK_CLOSE( unesco->data(index), m, 0.1 ) ;
+            }
+        }
+    }
+    delete mackenzie ;
+    delete in_place ;
+    delete del_grosso ;
+    delete unesco ;
+
+    // mismatched grids are rejected, and both grids are deleted
+
+    axis[0] = new seq_linear( wposition::earth_radius - 5000.0, 100.0, 51 ) ;
+    axis[1] = new seq_linear( to_colatitude(30.0), to_radians(0.1), 40 ) ;
+    axis[2] = new seq_linear( to_radians(-60.0), to_radians(0.1), 49 ) ;
+    data_grid<double,3>* short_sal = new data_grid<double,3>( axis ) ;
+    for (unsigned n = 0; n < 3; ++n) delete axis[n] ;
+    BOOST_CHECK_THROW( data_grid_mackenzie::construct(
+        new data_grid<double,3>(temp,true), short_sal, true ),
+        std::invalid_argument ) ;
+}
+
+/**
+ * Synthetic loader for profile_epochs_test.  The sound speed for each
+ * epoch is a linear function of depth, offset by one m/s per epoch.
+ * Counts the number of times that each epoch is loaded.  The longitude
+ * axis of the "shifted" epoch starts one grid point further east.
+ * The number of longitudes can be increased, and each load can be
+ * delayed, to give other threads a chance to ask for the same epoch
+ * while it is being loaded.
+ */
+class test_epoch_loader : public epoch_loader {
+public:
+    unsigned loads[4] ;
+    unsigned shifted ;
+    unsigned columns ;
+    unsigned delay ;    // milliseconds
+
+    test_epoch_loader() : shifted( 4 ), columns( 6 ), delay( 0 ) {
+        loads[0] = loads[1] = loads[2] = loads[3] = 0 ;
+    }
+
+    virtual data_grid<double,3>* load( unsigned epoch ) {
+        ++loads[epoch] ;
+        if ( delay ) {
+            boost::this_thread::sleep(
+                boost::posix_time::milliseconds( delay ) ) ;
+        }
+        seq_vector* axis[3] ;
+        axis[0] = new seq_linear( wposition::earth_radius - 1000.0, 100.0, 11 ) ;
+        axis[1] = new seq_linear( to_colatitude(30.0), to_radians(0.1), 5 ) ;
+        const double west = ( epoch == shifted ) ? -59.9 : -60.0 ;
+        axis[2] = new seq_linear( to_radians(west), to_radians(0.1), (int) columns ) ;
+        data_grid<double,3>* grid = new data_grid<double,3>( axis ) ;
+        unsigned index[3] ;
+        for ( index[0]=0 ; index[0] < 11 ; ++index[0] ) {
+            for ( index[1]=0 ; index[1] < 5 ; ++index[1] ) {
+                for ( index[2]=0 ; index[2] < columns ; ++index[2] ) {
+                    grid->data( index, 1500.0 + epoch
+                        - 0.016 * ( 1000.0 - 100.0 * index[0] ) ) ;
+                }
+            }
+        }
+        for (unsigned n = 0; n < 3; ++n) delete axis[n] ;
+        return grid ;
+    }
+} ;
+
+/**
+ * Test the lazy loading and least recently used eviction of
+ * sound speed slabs in profile_epochs.  Only two of the four epochs
+ * may be cached at once.  Each epoch must only be loaded again after
+ * it has been evicted, and a profile for an evicted epoch must
+ * continue to work until it is destroyed.  An epoch whose axes don't
+ * match the first epoch loaded must be rejected.
+ */
+BOOST_AUTO_TEST_CASE( profile_epochs_test ) {
+    cout << "=== profile_test: profile_epochs_test ===" << endl;
+    test_epoch_loader* loader = new test_epoch_loader() ;
+    profile_epochs store( seq_linear( 0.0, 3600.0, 4 ), loader, 2 ) ;
+    BOOST_CHECK_EQUAL( store.size(), 4u ) ;
+    BOOST_CHECK_EQUAL( store.epoch( -100.0 ), 0u ) ;
+    BOOST_CHECK_EQUAL( store.epoch( 5000.0 ), 1u ) ;
+    BOOST_CHECK_EQUAL( store.epoch( 5500.0 ), 2u ) ;
+    BOOST_CHECK_EQUAL( store.epoch( 1e6 ), 3u ) ;
+
+    wposition location( 1, 1, 30.2, -59.75, -250.0 ) ;
+    matrix<double> speed( 1, 1 ) ;
+    wvector gradient( 1, 1 ) ;
+
+    profile_model* first = store.profile( 0 ) ;
+    profile_model* second = store.profile( 1 ) ;
+    profile_model* again = store.profile( 0 ) ;
+    BOOST_CHECK_EQUAL( loader->loads[0], 1u ) ;
+    BOOST_CHECK_EQUAL( loader->loads[1], 1u ) ;
+    BOOST_CHECK_EQUAL( store.num_cached(), 2u ) ;
+
+    // epoch 1 is the least recently used, and is evicted by epoch 2
+
+    profile_model* third = store.profile( 2 ) ;
+    BOOST_CHECK_EQUAL( store.num_cached(), 2u ) ;
+    delete store.profile( 0 ) ;
+    BOOST_CHECK_EQUAL( loader->loads[0], 1u ) ;
+    delete store.profile( 1 ) ;
+    BOOST_CHECK_EQUAL( loader->loads[1], 2u ) ;
+    BOOST_CHECK_EQUAL( loader->loads[2], 1u ) ;
+
+    // all views must still compute the speed for their own epoch,
+    // and match a profile_grid_fast built from the same data
+
+    data_grid<double,3>* grid = loader->load( 0 ) ;
+    profile_grid_fast reference( new data_grid_svp( *grid, true ) ) ;
+    delete grid ;
+    matrix<double> ref_speed( 1, 1 ) ;
+    wvector ref_gradient( 1, 1 ) ;
+    reference.sound_speed( location, &ref_speed, &ref_gradient ) ;
+
+    const double expected = 1500.0 - 0.016 * 250.0 ;
+    first->sound_speed( location, &speed, &gradient ) ;
+    BOOST_CHECK_CLOSE( speed(0,0), expected, 1e-6 ) ;
+    BOOST_CHECK_EQUAL( speed(0,0), ref_speed(0,0) ) ;
+    BOOST_CHECK_EQUAL( gradient.rho(0,0), ref_gradient.rho(0,0) ) ;
+    BOOST_CHECK_EQUAL( gradient.theta(0,0), ref_gradient.theta(0,0) ) ;
+    BOOST_CHECK_EQUAL( gradient.phi(0,0), ref_gradient.phi(0,0) ) ;
+    again->sound_speed( location, &speed ) ;
+    BOOST_CHECK_CLOSE( speed(0,0), expected, 1e-6 ) ;
+    second->sound_speed( location, &speed ) ;
+    BOOST_CHECK_CLOSE( speed(0,0), expected + 1.0, 1e-6 ) ;
+    third->sound_speed( location, &speed ) ;
+    BOOST_CHECK_CLOSE( speed(0,0), expected + 2.0, 1e-6 ) ;
+
+    delete first ;
+    delete second ;
+    delete again ;
+    delete third ;
+
+    // axes with the same size, but different values, are rejected
+
+    loader->shifted = 3 ;
+    BOOST_CHECK_THROW( store.profile( 3 ), std::invalid_argument ) ;
+    BOOST_CHECK_EQUAL( store.num_cached(), 2u ) ;
+}
+
+/**
+ * Computes the sound speed for one epoch in a separate thread.
+ */
+struct epoch_worker {
+    profile_epochs* store ;
+    unsigned epoch ;
+    double* speed ;
+
+    void operator()() {
+        wposition location( 1, 1, 30.2, -59.75, -250.0 ) ;
+        matrix<double> value( 1, 1 ) ;
+        profile_model* profile = store->profile( epoch ) ;
+        profile->sound_speed( location, &value ) ;
+        *speed = value(0,0) ;
+        delete profile ;
+    }
+} ;
+
+/**
+ * Test concurrent requests for sound speed slabs in profile_epochs.
+ * Twelve threads ask for three epochs at the same time, while the
+ * loader and the derivative calculation are slowed down, so several
+ * threads ask for each epoch before it has been added to the cache.
+ * The cache is large enough that nothing is evicted.  Each epoch must
+ * be loaded only once, and every thread must compute the speed for
+ * its own epoch.
+ */
+BOOST_AUTO_TEST_CASE( profile_epochs_threads_test ) {
+    cout << "=== profile_test: profile_epochs_threads_test ===" << endl;
+    test_epoch_loader* loader = new test_epoch_loader() ;
+    loader->columns = 20000 ;
+    loader->delay = 50 ;
+    profile_epochs store( seq_linear( 0.0, 3600.0, 4 ), loader, 4 ) ;
+
+    const unsigned num_threads = 12 ;
+    double speed[num_threads] ;
+    boost::thread_group workers ;
+    for ( unsigned n=0 ; n < num_threads ; ++n ) {
+        epoch_worker worker ;
+        worker.store = &store ;
+        worker.epoch = n % 3 ;
+        worker.speed = &speed[n] ;
+        workers.create_thread( worker ) ;
+    }
+    workers.join_all() ;
+
+    const double expected = 1500.0 - 0.016 * 250.0 ;
+    for ( unsigned n=0 ; n < num_threads ; ++n ) {
+        BOOST_CHECK_CLOSE( speed[n], expected + n % 3, 1e-6 ) ;
+    }
+    for ( unsigned e=0 ; e < 3 ; ++e ) {
+        BOOST_CHECK_EQUAL( loader->loads[e], 1u ) ;
+    }
+    BOOST_CHECK_EQUAL( loader->loads[3], 0u ) ;
+    BOOST_CHECK_EQUAL( store.num_cached(), 3u ) ;
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
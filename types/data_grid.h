@@ -6,6 +6,7 @@
 #define USML_TYPES_DATA_GRID_H
 
 #include <string.h>
+#include <stdexcept>
 #include <usml/types/wvector.h>
 #include <usml/types/seq_vector.h>
 
@@ -96,6 +97,9 @@ public:
 
     /**
      * Extract a data value at a specific combination of indices.
+     * Not checked, because interpolate() calls it for every point in
+     * the stencil.  Must not be used on grids that do not store their
+     * values in this data type (see data_grid_compact).
      *
      * @param  index            Index number in each dimension.
      */
@@ -108,6 +112,8 @@ public:
 
     /**
      * Define a new data value at a specific combination of indices.
+     * Must not be used on grids that do not store their values in
+     * this data type.
      *
      * @param  index            Index number in each dimension.
      * @param  value            Value to insert at this location.
@@ -119,6 +125,28 @@ public:
         _data[offset] = value;
     }
 
+    /**
+     * Direct access to the linear array of data values, with the last
+     * dimension changing fastest.  Used by routines that process the
+     * whole grid at once, without computing the offset of each point.
+     * Returns NULL if this grid does not store its values in this
+     * data type.
+     */
+    inline const DATA_TYPE* data() const
+    {
+        return _data;
+    }
+
+    /**
+     * Direct access to the linear array of data values, with the last
+     * dimension changing fastest.  Used by routines that fill the
+     * whole grid at once, without computing the offset of each point.
+     */
+    inline DATA_TYPE* data()
+    {
+        return _data;
+    }
+
     //*************************************************************************
     // interp_type property
 
@@ -553,14 +581,10 @@ private:
         return result;
     }
 
-public:
+protected:
 
     /**
-     * Multi-dimensional interpolation with the derivative calculation.
-     * So many calculations are shared between the determination of an
-     * interpolate value and its derivative, that it is computationally
-     * efficient to compute them both at the same time.
-     *
+     * Find the "interval index" in each dimension.
      * Limit interpolation to axis domain if _edge_limit turned on for that
      * dimension.  Allow extrapolation if _edge_limit turned off.
      *
@@ -569,14 +593,11 @@ public:
      *                      WARNING: The contents of the location vector
      *                      may be modified if edge_limit() is true for
      *                      any dimension.
-     * @param   derivative  If this is not null, the first derivative
-     *                      of the field at this point will also be computed.
-     * @return              Value of the field at this point.
+     * @param   offset      Index of the corner before the desired field
+     *                      point in each dimension (output).
      */
-    DATA_TYPE interpolate(double* location, DATA_TYPE* derivative = NULL)
+    void find_offset(double* location, unsigned* offset)
     {
-    	// find the "interval index" in each dimension
-
         for (unsigned dim = 0; dim < NUM_DIMS; ++dim) {
 
             // limit interpolation to axis domain if _edge_limit turned on
@@ -588,32 +609,63 @@ public:
 				if ( inc < 0) {                                                     // a > b
                     if ( location[dim] >= a ) {                                     //left of the axis
                         location[dim] = a ;
-                        _offset[dim] = 0 ;
+                        offset[dim] = 0 ;
                     } else if ( location[dim] <= b ) {                              //right of the axis
                         location[dim] = b ;
-                        _offset[dim] = _axis[dim]->size()-2 ;
+                        offset[dim] = _axis[dim]->size()-2 ;
                     } else {
-                        _offset[dim] = _axis[dim]->find_index(location[dim]);       //somewhere in-between the endpoints of the axis
+                        offset[dim] = _axis[dim]->find_index(location[dim]);        //somewhere in-between the endpoints of the axis
                     }
 				}
 				if (inc > 0 ) {                                                     // a < b
                     if ( location[dim] <= a ) {                                     //left of the axis
                         location[dim] = a ;
-                        _offset[dim] = 0 ;
+                        offset[dim] = 0 ;
                     } else if ( location[dim] >= b ) {                              //right of the axis
                         location[dim] = b ;
-                        _offset[dim] = _axis[dim]->size()-2 ;
+                        offset[dim] = _axis[dim]->size()-2 ;
                     } else {
-                        _offset[dim] = _axis[dim]->find_index(location[dim]);       //somewhere in-between the endpoints of the axis
+                        offset[dim] = _axis[dim]->find_index(location[dim]);        //somewhere in-between the endpoints of the axis
                     }
 				}
 
             // allow extrapolation if _edge_limit turned off
 
         	} else {
-        		_offset[dim] = _axis[dim]->find_index(location[dim]);
+        		offset[dim] = _axis[dim]->find_index(location[dim]);
         	}
         }
+    }
+
+public:
+
+    /**
+     * Multi-dimensional interpolation with the derivative calculation.
+     * So many calculations are shared between the determination of an
+     * interpolate value and its derivative, that it is computationally
+     * efficient to compute them both at the same time.
+     *
+     * Limit interpolation to axis domain if _edge_limit turned on for that
+     * dimension.  Allow extrapolation if _edge_limit turned off.
+     *
+     * Declared virtual so that sub-classes with faster interpolation
+     * engines, like data_grid_unrolled, can be used as drop-in replacements
+     * wherever a data_grid pointer is expected (ex: profile_grid).
+     *
+     * @param   location    Location at which field value is desired. Must
+     *                      have the same rank as the data grid or higher.
+     *                      WARNING: The contents of the location vector
+     *                      may be modified if edge_limit() is true for
+     *                      any dimension.
+     * @param   derivative  If this is not null, the first derivative
+     *                      of the field at this point will also be computed.
+     * @return              Value of the field at this point.
+     */
+    virtual DATA_TYPE interpolate(double* location, DATA_TYPE* derivative = NULL)
+    {
+    	// find the "interval index" in each dimension
+
+        find_offset(location, _offset);
 
         // compute interpolation results for value and derivative
 
@@ -739,6 +791,20 @@ protected:
         memset(_edge_limit, true, NUM_DIMS * sizeof(bool));
     }
 
+    /**
+     * Fail loudly if this grid does not store its values in _data.
+     * Sub-classes like data_grid_compact keep their values in some
+     * other form, and leave _data set to NULL.  Used when a grid is
+     * copied, instead of in the per-element data() accessors.
+     */
+    inline void check_data() const
+    {
+        if (_data == NULL) {
+            throw std::invalid_argument(
+                "data_grid values are not stored in this data type");
+        }
+    }
+
 public:
 
     /**
@@ -771,9 +837,15 @@ public:
      * @param other         Grid to be copied.
      * @param copy_data     Copy both axes and data if true.
      *                      Copy just axes and structure if false.
+     * @throws std::invalid_argument if copy_data is true, and the other
+     *                      grid does not store its values in this
+     *                      data type (see data_grid_compact).
      */
     data_grid(const data_grid& other, bool copy_data)
     {
+        if (copy_data) {
+            other.check_data();
+        }
         size_t N = 1;
         for (unsigned n = 0; n < NUM_DIMS; ++n) {
             _axis[n] = other._axis[n]->clone();
@@ -793,7 +865,7 @@ public:
     /**
      * Destroys memory area for field data.
      */
-    ~data_grid()
+    virtual ~data_grid()
     {
         for (unsigned n = 0; n < NUM_DIMS; ++n) {
         	if (_axis[n] != NULL) {
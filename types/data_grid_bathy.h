@@ -46,87 +46,31 @@ public:
      * @param grid      The data_grid that is to be wrapped.
      * @param copy_data If true, copies the data grids data
      *                  fields as well as the axises.
+     * @param derivatives   Derivatives in each direction, from the
+     *                  derivatives() of a grid with the same axes and data.
+     *                  Computed from the data if this is NULL.
      */
 
-    data_grid_bathy(const data_grid<double, 2>& grid, bool copy_data = true) :
+    data_grid_bathy(const data_grid<double, 2>& grid, bool copy_data = true,
+                    const double* derivatives = NULL) :
             data_grid<double, 2>(grid, copy_data), _bicubic_coeff(16, 1),
             _field(16, 1), _xyloc(1, 16), _result_pchip(1, 1), _value(4, 4),
-            _kmin(0u), _k0max(_axis[0]->size() - 1u), _k1max(_axis[1]->size() - 1u)
+            _kmin(0u), _k0max(_axis[0]->size() - 1u), _k1max(_axis[1]->size() - 1u),
+            _shared(false)
     {
-        // Construct the inverse bicubic interpolation coefficient matrix
-        _inv_bicubic_coeff = zero_matrix<double>(16, 16);
-        _inv_bicubic_coeff(0, 0) = 1;
-        _inv_bicubic_coeff(1, 8) = 1;
-        _inv_bicubic_coeff(2, 0) = -3;
-        _inv_bicubic_coeff(2, 1) = 3;
-        _inv_bicubic_coeff(2, 8) = -2;
-        _inv_bicubic_coeff(2, 9) = -1;
-        _inv_bicubic_coeff(3, 0) = 2;
-        _inv_bicubic_coeff(3, 1) = -2;
-        _inv_bicubic_coeff(3, 8) = _inv_bicubic_coeff(3, 9) = 1;
-        _inv_bicubic_coeff(4, 4) = 1;
-        _inv_bicubic_coeff(5, 12) = 1;
-        _inv_bicubic_coeff(6, 4) = -3;
-        _inv_bicubic_coeff(6, 5) = 3;
-        _inv_bicubic_coeff(6, 12) = -2;
-        _inv_bicubic_coeff(6, 13) = -1;
-        _inv_bicubic_coeff(7, 4) = 2;
-        _inv_bicubic_coeff(7, 5) = -2;
-        _inv_bicubic_coeff(7, 12) = _inv_bicubic_coeff(7, 13) = 1;
-        _inv_bicubic_coeff(8, 0) = -3;
-        _inv_bicubic_coeff(8, 2) = 3;
-        _inv_bicubic_coeff(8, 4) = -2;
-        _inv_bicubic_coeff(8, 6) = -1;
-        _inv_bicubic_coeff(9, 8) = -3;
-        _inv_bicubic_coeff(9, 10) = 3;
-        _inv_bicubic_coeff(9, 12) = -2;
-        _inv_bicubic_coeff(9, 14) = -1;
-        _inv_bicubic_coeff(10, 0) = _inv_bicubic_coeff(10, 3) = 9;
-        _inv_bicubic_coeff(10, 1) = _inv_bicubic_coeff(10, 2) = -9;
-        _inv_bicubic_coeff(10, 4) = _inv_bicubic_coeff(10, 8) = 6;
-        _inv_bicubic_coeff(10, 5) = _inv_bicubic_coeff(10, 10) = -6;
-        _inv_bicubic_coeff(10, 6) = _inv_bicubic_coeff(10, 9) = 3;
-        _inv_bicubic_coeff(10, 7) = _inv_bicubic_coeff(10, 11) = -3;
-        _inv_bicubic_coeff(10, 12) = 4;
-        _inv_bicubic_coeff(10, 13) = _inv_bicubic_coeff(10, 14) = 2;
-        _inv_bicubic_coeff(10, 15) = 1;
-        _inv_bicubic_coeff(11, 0) = _inv_bicubic_coeff(11, 3) = -6;
-        _inv_bicubic_coeff(11, 1) = _inv_bicubic_coeff(11, 2) = 6;
-        _inv_bicubic_coeff(11, 6) = _inv_bicubic_coeff(11, 12) =
-                    _inv_bicubic_coeff(11, 13) = -2;
-        _inv_bicubic_coeff(11, 4) = -4;
-        _inv_bicubic_coeff(11, 5) = 4;
-        _inv_bicubic_coeff(11, 7) = 2;
-        _inv_bicubic_coeff(11, 8) = _inv_bicubic_coeff(11, 9) = -3;
-        _inv_bicubic_coeff(11, 10) = _inv_bicubic_coeff(11, 11) = 3;
-        _inv_bicubic_coeff(11, 14) = _inv_bicubic_coeff(11, 15) = -1;
-        _inv_bicubic_coeff(12, 0) = 2;
-        _inv_bicubic_coeff(12, 2) = -2;
-        _inv_bicubic_coeff(12, 4) = _inv_bicubic_coeff(12, 6) = 1;
-        _inv_bicubic_coeff(13, 8) = 2;
-        _inv_bicubic_coeff(13, 10) = -2;
-        _inv_bicubic_coeff(13, 12) = _inv_bicubic_coeff(13, 14) = 1;
-        _inv_bicubic_coeff(14, 0) = _inv_bicubic_coeff(14, 3) = -6;
-        _inv_bicubic_coeff(14, 1) = _inv_bicubic_coeff(14, 2) = 6;
-        _inv_bicubic_coeff(14, 4) = _inv_bicubic_coeff(14, 6) = -3;
-        _inv_bicubic_coeff(14, 5) = _inv_bicubic_coeff(14, 7) = 3;
-        _inv_bicubic_coeff(14, 8) = -4;
-        _inv_bicubic_coeff(14, 10) = 4;
-        _inv_bicubic_coeff(14, 9) = _inv_bicubic_coeff(14, 12) =
-                _inv_bicubic_coeff(14, 14) = -2;
-        _inv_bicubic_coeff(14, 11) = 2;
-        _inv_bicubic_coeff(14, 13) = _inv_bicubic_coeff(14, 15) = -1;
-        _inv_bicubic_coeff(15, 0) = _inv_bicubic_coeff(15, 3) = 4;
-        _inv_bicubic_coeff(15, 1) = _inv_bicubic_coeff(15, 2) = -4;
-        _inv_bicubic_coeff(15, 4) = _inv_bicubic_coeff(15, 6) =
-                _inv_bicubic_coeff(15, 8) = _inv_bicubic_coeff(15, 9) = 2;
-        _inv_bicubic_coeff(15, 5) = _inv_bicubic_coeff(15, 7) =
-                _inv_bicubic_coeff(15, 10) = _inv_bicubic_coeff(15, 11) = -2;
-        _inv_bicubic_coeff(15, 12) = _inv_bicubic_coeff(15, 13) =
-                _inv_bicubic_coeff(15, 14) = _inv_bicubic_coeff(15, 15) = 1;
-
-        _fast_index[0] = 0;
-        _fast_index[1] = 0;
+        init_coefficients();
+
+        // derivatives are stored as three contiguous tables,
+        // each in the same order as the data
+
+        const size_t N = (_k0max + 1u) * (_k1max + 1u);
+        _derv_x = new double[3 * N];
+        _derv_y = _derv_x + N;
+        _derv_x_y = _derv_y + N;
+        if (derivatives) {
+            memcpy(_derv_x, derivatives, 3 * N * sizeof(double));
+            return;
+        }
 
         //Pre-construct increments for all intervals once to save time
         matrix<double> inc_x(_k0max + 1u, 1);
@@ -149,105 +93,102 @@ public:
         }
 
         // Pre-construct all derivatives and cross-dervs once to save time
-        _derv_x = matrix<double>(_k0max + 1u, _k1max + 1u);
-        _derv_y = matrix<double>(_k0max + 1u, _k1max + 1u);
-        _derv_x_y = matrix<double>(_k0max + 1u, _k1max + 1u);
         for (unsigned i = 0; i < _k0max + 1u; ++i) {
             for (unsigned j = 0; j < _k1max + 1u; ++j) {
                 if (i < 1 && j < 1) {                      //top-left corner
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: i<1 && j<1***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i + 1, j) - data_2d(i, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i + 1, j + 1) - data_2d(i + 1, j)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i + 1, j + 1) - data_2d(i + 1, j)
                             - data_2d(i, j + 1) + data_2d(i, j))
                             / (inc_x(i, 0) * inc_y(j, 0));
                 } else if (i == _k0max && j == _k1max) {     //bottom-right corner
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: i==_k0max && j==_k1max***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i, j) - data_2d(i - 1, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i, j) - data_2d(i - 1, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j) - data_2d(i, j - 1))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j) - data_2d(i, j - 1))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i, j) - data_2d(i, j - 1)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i, j) - data_2d(i, j - 1)
                             - data_2d(i - 1, j) + data_2d(i - 1, j - 1))
                             / (inc_x(i, 0) * inc_y(j, 0));
                 } else if (i < 1 && j == _k1max) {             //top-right corner
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: i<1 && j==_k1max***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i + 1, j) - data_2d(i, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j) - data_2d(i, j - 1))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j) - data_2d(i, j - 1))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i + 1, j) - data_2d(i + 1, j - 1)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i + 1, j - 1)
                             - data_2d(i, j) + data_2d(i, j - 1))
                             / (inc_x(i, 0) * inc_y(j, 0));
                 } else if (j < 1 && i == _k0max) {           //bottom-left corner
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: j<1 && i==_k0max***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i, j) - data_2d(i - 1, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i, j) - data_2d(i - 1, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j)
                             - data_2d(i - 1, j + 1) + data_2d(i - 1, j))
                             / (inc_x(i, 0) * inc_y(j, 0));
                 } else if (i < 1 && (1 <= j && j < _k1max)) {       //top row
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: i<1 && (1<=j && j<_k1max)***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i + 1, j) - data_2d(i, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j - 1))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j - 1))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i + 1, j + 1)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i + 1, j + 1)
                             - data_2d(i + 1, j - 1) - data_2d(i, j + 1)
                             + data_2d(i, j - 1)) / (inc_x(i, 0) * inc_y(j, 0));
                 } else if (j < 1 && (1 <= i && i < _k0max)) {  //left most column
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: j<1 && (1<=i && i<_k0max)***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i + 1, j) - data_2d(i - 1, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i - 1, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i + 1, j + 1) - data_2d(i + 1, j)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i + 1, j + 1) - data_2d(i + 1, j)
                             - data_2d(i - 1, j + 1) + data_2d(i - 1, j))
                             / (inc_x(i, 0) * inc_y(j, 0));
                 } else if (j == _k1max && (1 <= i && i < _k0max)) { //right most column
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: j>_k1max && (1<=i && i<_k0max)***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i + 1, j) - data_2d(i - 1, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i - 1, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j) - data_2d(i, j - 1))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j) - data_2d(i, j - 1))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i + 1, j) - data_2d(i + 1, j - 1)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i + 1, j - 1)
                             - data_2d(i - 1, j) + data_2d(i - 1, j - 1))
                             / (inc_x(i, 0) * inc_y(j, 0));
                 } else if (i == _k0max && (1 <= j && j < _k1max)) {   //bottom row
                     #ifdef DERV_CONSTRUCT
                         cout << "***Condition: i>_k0max && (1<=j && j<_k1max)***" << endl;
                     #endif
-                    _derv_x(i, j) = (data_2d(i, j) - data_2d(i - 1, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i, j) - data_2d(i - 1, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j - 1))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j - 1))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j - 1)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j - 1)
                             - data_2d(i - 1, j + 1) + data_2d(i - 1, j - 1))
                             / (inc_x(i, 0) * inc_y(j, 0));
                 } else {                                //inside, restrictive
-                    _derv_x(i, j) = (data_2d(i + 1, j) - data_2d(i - 1, j))
+                    _derv_x[index_2d(i, j)] = (data_2d(i + 1, j) - data_2d(i - 1, j))
                             / inc_x(i, 0);
-                    _derv_y(i, j) = (data_2d(i, j + 1) - data_2d(i, j - 1))
+                    _derv_y[index_2d(i, j)] = (data_2d(i, j + 1) - data_2d(i, j - 1))
                             / inc_y(j, 0);
-                    _derv_x_y(i, j) = (data_2d(i + 1, j + 1)
+                    _derv_x_y[index_2d(i, j)] = (data_2d(i + 1, j + 1)
                             - data_2d(i + 1, j - 1) - data_2d(i - 1, j + 1)
                             + data_2d(i - 1, j - 1))
                             / (inc_x(i, 0) * inc_y(j, 0));
@@ -256,6 +197,64 @@ public:
         } //end for-loop in i
     }// end constructor
 
+    /**
+     * Constructor - Attaches a fast interpolation grid to data and
+     * derivatives that are owned by someone else, such as a memory mapped
+     * ocean_snapshot.  Neither the data nor the derivatives are copied,
+     * and they are not deleted when this grid is destroyed.  The caller
+     * must keep them valid, and unchanged, for the life of this grid.
+     * Interpolation types and edge limits are left at their defaults.
+     *
+     * @param axis      Axes of the grid, copied with seq_vector::clone().
+     * @param data      Data values, stored in the same order as data_grid.
+     * @param derivatives   Derivatives in the same layout as derivatives().
+     * @throws std::invalid_argument if data or derivatives is NULL.
+     */
+
+    data_grid_bathy(seq_vector* axis[], const double* data,
+                    const double* derivatives) :
+            data_grid<double, 2>(), _bicubic_coeff(16, 1),
+            _field(16, 1), _xyloc(1, 16), _result_pchip(1, 1), _value(4, 4),
+            _kmin(0u), _k0max(axis[0]->size() - 1u), _k1max(axis[1]->size() - 1u),
+            _shared(true)
+    {
+        if (data == NULL || derivatives == NULL) {
+            throw std::invalid_argument(
+                "attached data and derivatives must not be NULL");
+        }
+        init_coefficients();
+        for (unsigned n = 0; n < 2; ++n) {
+            _axis[n] = axis[n]->clone();
+        }
+        _data = const_cast<double*>(data);
+        const size_t N = (_k0max + 1u) * (_k1max + 1u);
+        _derv_x = const_cast<double*>(derivatives);
+        _derv_y = _derv_x + N;
+        _derv_x_y = _derv_y + N;
+    }
+
+    /**
+     * Destroys the storage for derivatives, unless it is shared.
+     */
+    virtual ~data_grid_bathy() {
+        if (_shared) {
+            _data = NULL;       // keeps base class from deleting it
+        } else {
+            delete[] _derv_x;
+        }
+    }
+
+    /**
+     * Derivatives with respect to the first axis, second axis, and both
+     * axes, stored as three contiguous tables in the same order as
+     * the data.  Can be saved, and passed to the constructor
+     * of a new grid with the same axes and data, to avoid computing
+     * them again.
+     */
+    inline const double* derivatives() const {
+        return _derv_x;
+    }
+
     /**
      * Overrides the interpolate function within data_grid using the
      * non-recursive formula. Determines which interpolate function to
@@ -415,6 +414,92 @@ public:
 
 private:
 
+    /** Index of a grid point in the derivative tables. */
+    inline size_t index_2d(unsigned row, unsigned col) const {
+        return row * (_k1max + 1u) + col;
+    }
+
+    /**
+     * Construct the inverse bicubic interpolation coefficient matrix
+     * used during pchip calculations.
+     */
+    void init_coefficients() {
+        _inv_bicubic_coeff = zero_matrix<double>(16, 16);
+        _inv_bicubic_coeff(0, 0) = 1;
+        _inv_bicubic_coeff(1, 8) = 1;
+        _inv_bicubic_coeff(2, 0) = -3;
+        _inv_bicubic_coeff(2, 1) = 3;
+        _inv_bicubic_coeff(2, 8) = -2;
+        _inv_bicubic_coeff(2, 9) = -1;
+        _inv_bicubic_coeff(3, 0) = 2;
+        _inv_bicubic_coeff(3, 1) = -2;
+        _inv_bicubic_coeff(3, 8) = _inv_bicubic_coeff(3, 9) = 1;
+        _inv_bicubic_coeff(4, 4) = 1;
+        _inv_bicubic_coeff(5, 12) = 1;
+        _inv_bicubic_coeff(6, 4) = -3;
+        _inv_bicubic_coeff(6, 5) = 3;
+        _inv_bicubic_coeff(6, 12) = -2;
+        _inv_bicubic_coeff(6, 13) = -1;
+        _inv_bicubic_coeff(7, 4) = 2;
+        _inv_bicubic_coeff(7, 5) = -2;
+        _inv_bicubic_coeff(7, 12) = _inv_bicubic_coeff(7, 13) = 1;
+        _inv_bicubic_coeff(8, 0) = -3;
+        _inv_bicubic_coeff(8, 2) = 3;
+        _inv_bicubic_coeff(8, 4) = -2;
+        _inv_bicubic_coeff(8, 6) = -1;
+        _inv_bicubic_coeff(9, 8) = -3;
+        _inv_bicubic_coeff(9, 10) = 3;
+        _inv_bicubic_coeff(9, 12) = -2;
+        _inv_bicubic_coeff(9, 14) = -1;
+        _inv_bicubic_coeff(10, 0) = _inv_bicubic_coeff(10, 3) = 9;
+        _inv_bicubic_coeff(10, 1) = _inv_bicubic_coeff(10, 2) = -9;
+        _inv_bicubic_coeff(10, 4) = _inv_bicubic_coeff(10, 8) = 6;
+        _inv_bicubic_coeff(10, 5) = _inv_bicubic_coeff(10, 10) = -6;
+        _inv_bicubic_coeff(10, 6) = _inv_bicubic_coeff(10, 9) = 3;
+        _inv_bicubic_coeff(10, 7) = _inv_bicubic_coeff(10, 11) = -3;
+        _inv_bicubic_coeff(10, 12) = 4;
+        _inv_bicubic_coeff(10, 13) = _inv_bicubic_coeff(10, 14) = 2;
+        _inv_bicubic_coeff(10, 15) = 1;
+        _inv_bicubic_coeff(11, 0) = _inv_bicubic_coeff(11, 3) = -6;
+        _inv_bicubic_coeff(11, 1) = _inv_bicubic_coeff(11, 2) = 6;
+        _inv_bicubic_coeff(11, 6) = _inv_bicubic_coeff(11, 12) =
+                    _inv_bicubic_coeff(11, 13) = -2;
+        _inv_bicubic_coeff(11, 4) = -4;
+        _inv_bicubic_coeff(11, 5) = 4;
+        _inv_bicubic_coeff(11, 7) = 2;
+        _inv_bicubic_coeff(11, 8) = _inv_bicubic_coeff(11, 9) = -3;
+        _inv_bicubic_coeff(11, 10) = _inv_bicubic_coeff(11, 11) = 3;
+        _inv_bicubic_coeff(11, 14) = _inv_bicubic_coeff(11, 15) = -1;
+        _inv_bicubic_coeff(12, 0) = 2;
+        _inv_bicubic_coeff(12, 2) = -2;
+        _inv_bicubic_coeff(12, 4) = _inv_bicubic_coeff(12, 6) = 1;
+        _inv_bicubic_coeff(13, 8) = 2;
+        _inv_bicubic_coeff(13, 10) = -2;
+        _inv_bicubic_coeff(13, 12) = _inv_bicubic_coeff(13, 14) = 1;
+        _inv_bicubic_coeff(14, 0) = _inv_bicubic_coeff(14, 3) = -6;
+        _inv_bicubic_coeff(14, 1) = _inv_bicubic_coeff(14, 2) = 6;
+        _inv_bicubic_coeff(14, 4) = _inv_bicubic_coeff(14, 6) = -3;
+        _inv_bicubic_coeff(14, 5) = _inv_bicubic_coeff(14, 7) = 3;
+        _inv_bicubic_coeff(14, 8) = -4;
+        _inv_bicubic_coeff(14, 10) = 4;
+        _inv_bicubic_coeff(14, 9) = _inv_bicubic_coeff(14, 12) =
+                _inv_bicubic_coeff(14, 14) = -2;
+        _inv_bicubic_coeff(14, 11) = 2;
+        _inv_bicubic_coeff(14, 13) = _inv_bicubic_coeff(14, 15) = -1;
+        _inv_bicubic_coeff(15, 0) = _inv_bicubic_coeff(15, 3) = 4;
+        _inv_bicubic_coeff(15, 1) = _inv_bicubic_coeff(15, 2) = -4;
+        _inv_bicubic_coeff(15, 4) = _inv_bicubic_coeff(15, 6) =
+                _inv_bicubic_coeff(15, 8) = _inv_bicubic_coeff(15, 9) = 2;
+        _inv_bicubic_coeff(15, 5) = _inv_bicubic_coeff(15, 7) =
+                _inv_bicubic_coeff(15, 10) = _inv_bicubic_coeff(15, 11) = -2;
+        _inv_bicubic_coeff(15, 12) = _inv_bicubic_coeff(15, 13) =
+                _inv_bicubic_coeff(15, 14) = _inv_bicubic_coeff(15, 15) = 1;
+
+
+        _fast_index[0] = 0;
+        _fast_index[1] = 0;
+    }
+
     /** Utility accessor function for data grid values */
     inline double data_2d(unsigned row, unsigned col) {
         unsigned grid_index[2];
@@ -513,9 +598,9 @@ private:
         cout << "data value at offset: " << ( (data(interp_index) > 1e6) ?
                 data(interp_index) - wposition::earth_radius : data(interp_index) ) << endl;
         cout << "_value: " << _value << endl;
-        cout << "_derv_x: " << _derv_x << endl;
-        cout << "_derv_y: " << _derv_y << endl;
-        cout << "_derv_x_y: " << _derv_x_y << endl;
+        cout << "_derv_x: " << _derv_x[index_2d(k0, k1)] << endl;
+        cout << "_derv_y: " << _derv_y[index_2d(k0, k1)] << endl;
+        cout << "_derv_x_y: " << _derv_x_y[index_2d(k0, k1)] << endl;
 #endif
 
         // Construct the _field matrix
@@ -523,18 +608,18 @@ private:
         _field(1, 0) = _value(1, 2);                  //f(0,1)
         _field(2, 0) = _value(2, 1);                  //f(1,0)
         _field(3, 0) = _value(2, 2);                  //f(1,1)
-        _field(4, 0) = _derv_x(k0, k1);               //f_x(0,0)
-        _field(5, 0) = _derv_x(k0, k1 + 1);           //f_x(0,1)
-        _field(6, 0) = _derv_x(k0 + 1, k1);           //f_x(1,0)
-        _field(7, 0) = _derv_x(k0 + 1, k1 + 1);       //f_x(1,1)
-        _field(8, 0) = _derv_y(k0, k1);               //f_y(0,0)
-        _field(9, 0) = _derv_y(k0, k1 + 1);           //f_y(0,1)
-        _field(10, 0) = _derv_y(k0 + 1, k1);          //f_y(1,0)
-        _field(11, 0) = _derv_y(k0 + 1, k1 + 1);      //f_y(1,1)
-        _field(12, 0) = _derv_x_y(k0, k1);            //f_x_y(0,0)
-        _field(13, 0) = _derv_x_y(k0, k1 + 1);        //f_x_y(0,1)
-        _field(14, 0) = _derv_x_y(k0 + 1, k1);        //f_x_y(1,0)
-        _field(15, 0) = _derv_x_y(k0 + 1, k1 + 1);    //f_x_y(1,1)
+        _field(4, 0) = _derv_x[index_2d(k0, k1)];               //f_x(0,0)
+        _field(5, 0) = _derv_x[index_2d(k0, k1 + 1)];           //f_x(0,1)
+        _field(6, 0) = _derv_x[index_2d(k0 + 1, k1)];           //f_x(1,0)
+        _field(7, 0) = _derv_x[index_2d(k0 + 1, k1 + 1)];       //f_x(1,1)
+        _field(8, 0) = _derv_y[index_2d(k0, k1)];               //f_y(0,0)
+        _field(9, 0) = _derv_y[index_2d(k0, k1 + 1)];           //f_y(0,1)
+        _field(10, 0) = _derv_y[index_2d(k0 + 1, k1)];          //f_y(1,0)
+        _field(11, 0) = _derv_y[index_2d(k0 + 1, k1 + 1)];      //f_y(1,1)
+        _field(12, 0) = _derv_x_y[index_2d(k0, k1)];            //f_x_y(0,0)
+        _field(13, 0) = _derv_x_y[index_2d(k0, k1 + 1)];        //f_x_y(0,1)
+        _field(14, 0) = _derv_x_y[index_2d(k0 + 1, k1)];        //f_x_y(1,0)
+        _field(15, 0) = _derv_x_y[index_2d(k0 + 1, k1 + 1)];    //f_x_y(1,1)
 
         // Construct the coefficients of the bicubic interpolation
         _bicubic_coeff = prod(_inv_bicubic_coeff, _field);
@@ -608,14 +693,22 @@ private:
     c_matrix<double, 1, 16> _xyloc;
     c_matrix<double, 1, 1> _result_pchip;
     c_matrix<double, 4, 4> _value;
-    matrix<double> _derv_x;
-    matrix<double> _derv_y;
-    matrix<double> _derv_x_y;
     unsigned  _fast_index[2];
     const int _kmin;
     const int _k0max;
     const int _k1max;
 
+    /**
+     * Derivatives with respect to x, y, and both. All three point
+     * into a single block of memory, which starts at _derv_x.
+     */
+    double* _derv_x;
+    double* _derv_y;
+    double* _derv_x_y;
+
+    /** True if the data and derivatives are owned by someone else. */
+    const bool _shared;
+
 }; // end data_grid_bathy
 
 } // end of namespace types
@@ -0,0 +1,292 @@
+/**
+ * @file data_grid_compact.h
+ * Data grid that stores its values in single precision, but
+ * computes interpolations in double precision.
+ */
+#ifndef USML_TYPES_DATA_GRID_COMPACT_H
+#define USML_TYPES_DATA_GRID_COMPACT_H
+
+#include <usml/types/data_grid_unrolled.h>
+
+namespace usml {
+namespace types {
+/// @ingroup data_grid
+/// @{
+
+template<unsigned NUM_DIMS> class data_grid_compact ;
+
+/**
+ * @internal
+ * Converts the run-time interpolation type of each dimension into a
+ * compile-time data_grid_interp_list, one dimension at a time, and then
+ * evaluates the matching data_grid_kernel.  Generates 3^NUM_DIMS kernels,
+ * one for each combination of interpolation types.
+ *
+ * @param  NUM_DIMS     Number of dimensions in the grid.
+ * @param  Dim          Dimension currently being resolved.
+ * @param  TYPES        data_grid_interp_list for dimensions less than Dim.
+ */
+template<unsigned NUM_DIMS, unsigned Dim, class TYPES>
+struct data_grid_compact_dispatch {
+
+    /**
+     * Replace the interpolation type of dimension Dim in the TYPES list,
+     * and continue with the next dimension.
+     */
+    template<int TYPE> struct with {
+        typedef data_grid_interp_list<
+            ( Dim == 0 ) ? TYPE : TYPES::template at<0>::value,
+            ( Dim == 1 ) ? TYPE : TYPES::template at<1>::value,
+            ( Dim == 2 ) ? TYPE : TYPES::template at<2>::value,
+            ( Dim == 3 ) ? TYPE : TYPES::template at<3>::value > list ;
+        typedef data_grid_compact_dispatch<NUM_DIMS,Dim+1,list> next ;
+    };
+
+    static double eval( const data_grid_compact<NUM_DIMS>& grid,
+        unsigned* index, const double* location, double* derivative )
+    {
+        switch ( grid.interp_type(Dim) ) {
+            case GRID_INTERP_NEAREST :
+                return with<GRID_INTERP_NEAREST>::next::eval(
+                    grid, index, location, derivative ) ;
+            case GRID_INTERP_PCHIP :
+                return with<GRID_INTERP_PCHIP>::next::eval(
+                    grid, index, location, derivative ) ;
+            default :
+                return with<GRID_INTERP_LINEAR>::next::eval(
+                    grid, index, location, derivative ) ;
+        }
+    }
+};
+
+/**
+ * @internal
+ * All interpolation types are known, evaluate the kernel.
+ */
+template<unsigned NUM_DIMS, class TYPES>
+struct data_grid_compact_dispatch<NUM_DIMS,NUM_DIMS,TYPES> {
+
+    typedef data_grid_kernel< double, NUM_DIMS, TYPES, NUM_DIMS-1,
+        TYPES::template at<NUM_DIMS-1>::value > kernel ;
+
+    static double eval( const data_grid_compact<NUM_DIMS>& grid,
+        unsigned* index, const double* location, double* derivative )
+    {
+        data_grid_stencil<double,NUM_DIMS> st ;
+        st.stride = grid.stride() ;
+        kernel::setup( grid.axes(), index, location, st ) ;
+
+        size_t corner = 0 ;
+        for ( unsigned n=0 ; n < NUM_DIMS ; ++n ) {
+            corner += index[n] * st.stride[n] ;
+        }
+        double dresult ;
+        return kernel::eval( grid.compact()+corner, st, dresult, derivative ) ;
+    }
+};
+
+/**
+ * Data grid that stores its values in single precision, but computes
+ * interpolations in double precision.  Halves the memory footprint of
+ * large environmental databases, like bathymetry and sound speed grids,
+ * while keeping the arithmetic of the interpolation in double precision.
+ * The only loss of accuracy comes from rounding each grid value to float,
+ * a relative error of about 6E-8, which is well below the accuracy of
+ * the underlying oceanographic measurements.
+ *
+ * Built from an existing data_grid of any data type, such as a
+ * netcdf_bathy, netcdf_profile, or netcdf_coards<float,N>.  The values
+ * are copied into single precision storage, and the original grid can
+ * then be deleted.  For example:
+ * <pre>
+ *      netcdf_profile* temp = new netcdf_profile( ... ) ;
+ *      data_grid<double,3>* ssp = new data_grid_compact<3>( *temp ) ;
+ *      delete temp ;
+ *      profile_grid<double,3> profile( ssp ) ;
+ * </pre>
+ * Because interpolate() is virtual, this class can be used wherever
+ * a data_grid<double,N> pointer is expected.  The interpolation type
+ * for each axis is still a run-time property, and it is dispatched to
+ * the compile-time kernels of data_grid_unrolled, which limits this grid
+ * to a maximum of 4 dimensions.
+ *
+ * The data() accessors of the data_grid base class are not supported,
+ * because this grid does not have a double precision copy of its values.
+ * The flat data() array is NULL, and the data(index) accessors of this
+ * class throw std::invalid_argument.  The base class accessors are not
+ * checked, because they are on the hot path of data_grid::interpolate(),
+ * so they must not be called through a data_grid pointer.  Copies are
+ * checked instead: data_grid, data_grid_svp, data_grid_bathy, and
+ * data_grid_compact refuse to copy the data of a compact grid.  Use
+ * compact_data() to read or write individual values instead.
+ *
+ * Bathymetry grids store rho, the distance from the center of the earth,
+ * and float can only resolve that to about half a meter.
+ *
+ * @param  NUM_DIMS     Number of dimensions in this grid (1 to 4).
+ */
+template<unsigned NUM_DIMS>
+class data_grid_compact : public data_grid<double, NUM_DIMS> {
+
+public:
+
+    using data_grid<double, NUM_DIMS>::interpolate ;
+    using data_grid<double, NUM_DIMS>::data ;
+
+    /**
+     * Creates a single precision copy of an existing data_grid.
+     * Copies the axes, interpolation types, and edge limits of
+     * the original grid.
+     *
+     * @param grid      The data_grid that is to be copied.
+     * @throws std::invalid_argument if the original grid does not
+     *                  store its values in its own data type, like
+     *                  another data_grid_compact.
+     */
+    template<class DATA_TYPE>
+    data_grid_compact(const data_grid<DATA_TYPE, NUM_DIMS>& grid)
+    {
+        if ( grid.data() == NULL ) {
+            throw std::invalid_argument(
+                "data_grid values are not stored in this data type") ;
+        }
+        size_t N = 1 ;
+        for ( int n=NUM_DIMS-1 ; n >= 0 ; --n ) {
+            this->_axis[n] = grid.axis(n)->clone() ;
+            this->interp_type( n, grid.interp_type(n) ) ;
+            this->edge_limit( n, grid.edge_limit(n) ) ;
+            _stride[n] = N ;
+            N *= this->_axis[n]->size() ;
+        }
+        _compact = new float[N] ;
+
+        // data_grid_compute_offset() uses the same row major order as
+        // the strides, so the index can just be incremented like a counter
+
+        unsigned index[NUM_DIMS] ;
+        memset( index, 0, NUM_DIMS * sizeof(unsigned) ) ;
+        for ( size_t k=0 ; k < N ; ++k ) {
+            _compact[k] = (float) grid.data(index) ;
+            for ( int n=NUM_DIMS-1 ; n >= 0 ; --n ) {
+                if ( ++index[n] < this->_axis[n]->size() ) break ;
+                index[n] = 0 ;
+            }
+        }
+    }
+
+    /**
+     * Destroys memory area for field data.
+     */
+    virtual ~data_grid_compact() {
+        delete[] _compact ;
+    }
+
+    /**
+     * Not supported, because this grid has no double precision copy
+     * of its values.  Use compact_data() instead.
+     *
+     * @throws std::invalid_argument every time it is called.
+     */
+    inline double data(const unsigned*) const {
+        throw std::invalid_argument(
+            "data_grid values are not stored in this data type") ;
+    }
+
+    /**
+     * Not supported, because this grid has no double precision copy
+     * of its values.  Use compact_data() instead.
+     *
+     * @throws std::invalid_argument every time it is called.
+     */
+    inline void data(const unsigned*, double) {
+        throw std::invalid_argument(
+            "data_grid values are not stored in this data type") ;
+    }
+
+    /**
+     * Extract a data value at a specific combination of indices.
+     *
+     * @param  index            Index number in each dimension.
+     */
+    inline double compact_data(const unsigned* index) const {
+        return (double) _compact[ offset(index) ] ;
+    }
+
+    /**
+     * Define a new data value at a specific combination of indices.
+     * The value is rounded to single precision.
+     *
+     * @param  index            Index number in each dimension.
+     * @param  value            Value to insert at this location.
+     */
+    inline void compact_data(const unsigned* index, double value) {
+        _compact[ offset(index) ] = (float) value ;
+    }
+
+    /**
+     * Multi-dimensional interpolation with the derivative calculation.
+     * Uses the same edge limiting rules as data_grid::interpolate().
+     * Does not modify any member variables.
+     *
+     * @param   location    Location at which field value is desired. Must
+     *                      have the same rank as the data grid or higher.
+     *                      WARNING: The contents of the location vector
+     *                      may be modified if edge_limit() is true for
+     *                      any dimension.
+     * @param   derivative  If this is not null, the first derivative
+     *                      of the field at this point will also be computed.
+     * @return              Value of the field at this point.
+     */
+    virtual double interpolate(double* location, double* derivative = NULL)
+    {
+        unsigned index[NUM_DIMS] ;
+        this->find_offset( location, index ) ;
+        return data_grid_compact_dispatch<NUM_DIMS,0,
+            data_grid_interp_list<GRID_INTERP_LINEAR,GRID_INTERP_LINEAR,
+                                  GRID_INTERP_LINEAR,GRID_INTERP_LINEAR> >
+            ::eval( *this, index, location, derivative ) ;
+    }
+
+    /** @internal Axes used by the interpolation kernels. */
+    inline seq_vector* const* axes() const {
+        return this->_axis ;
+    }
+
+    /** @internal Number of data elements between neighbors. */
+    inline const size_t* stride() const {
+        return _stride ;
+    }
+
+    /** @internal Single precision storage used by the kernels. */
+    inline const float* compact() const {
+        return _compact ;
+    }
+
+private:
+
+    /** Multi-dimensional data stored as single precision. */
+    float* _compact ;
+
+    /** Number of data elements between neighbors in each dimension. */
+    size_t _stride[NUM_DIMS] ;
+
+    /** Offset of a specific combination of indices into _compact. */
+    inline size_t offset(const unsigned* index) const {
+        size_t k = 0 ;
+        for ( unsigned n=0 ; n < NUM_DIMS ; ++n ) {
+            k += index[n] * _stride[n] ;
+        }
+        return k ;
+    }
+
+    // prevent copies of the single precision storage
+
+    data_grid_compact( const data_grid_compact& ) ;
+    data_grid_compact& operator=( const data_grid_compact& ) ;
+} ;
+
+/// @}
+} // end of namespace types
+} // end of namespace usml
+
+#endif
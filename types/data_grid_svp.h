@@ -7,6 +7,8 @@
 #define USML_TYPES_DATA_GRID_SVP_H
 
 #include <usml/types/data_grid.h>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
 
 //#define FAST_GRID_DEBUG
 //#define FAST_PCHIP_GRID_DEBUG
@@ -41,27 +43,32 @@ public:
 
     /**
      * Constructor - Creates a fast interpolation grid from an existing
-     * data_grid.
+     * data_grid.  The PCHIP derivatives in the depth direction are either
+     * computed from the data, or copied from a previous grid.  Large grids
+     * compute their derivatives using several threads, with each thread
+     * processing a block of (lat,lon) columns.
      *
      * @param grid      The data_grid that is to be wrapped.
      * @param copy_data If true, copies the data grids data
      *                  fields as well as the axises.
+     * @param derivatives   Derivatives in the depth direction, from the
+     *                  derivatives() of a grid with the same axes and data.
+     *                  Computed from the data if this is NULL.
+     * @param num_threads   Number of threads used to compute derivatives.
+     *                  If zero, uses the number of hardware threads, or a
+     *                  single thread for grids too small to justify
+     *                  threading.
      */
 
-    data_grid_svp(const data_grid<double, 3>& grid, bool copy_data = true)
+    data_grid_svp(const data_grid<double, 3>& grid, bool copy_data = true,
+                  const double* derivatives = NULL, unsigned num_threads = 0)
         :   data_grid<double, 3>(grid, copy_data),
             _kzmax(_axis[0]->size() - 1u),
             _kxmax(_axis[1]->size() - 1u),
-            _kymax(_axis[2]->size() - 1u)
+            _kymax(_axis[2]->size() - 1u),
+            _plane((_kxmax + 1u) * (_kymax + 1u)),
+            _shared(false)
     {
-        double result = 0.0;
-
-        //pchip variables
-        double inc1, inc2;
-        double w1, w2;
-        double slope_1, slope_2;
-
-
         if (interp_type(0) != GRID_INTERP_PCHIP) {
             interp_type(0, GRID_INTERP_PCHIP);
         }
@@ -70,117 +77,95 @@ public:
             interp_type(1, GRID_INTERP_LINEAR);
             interp_type(2, GRID_INTERP_LINEAR);
         }
-        derv_z = new double**[_kzmax + 1u];
-        for (int i = 0; i < _kzmax + 1u; ++i) {
-            derv_z[i] = new double*[_kxmax + 1u];
-            for (int j = 0; j < _kxmax + 1u; ++j) {
-                derv_z[i][j] = new double[_kymax + 1u];
+
+        // derivatives are stored in the same order as the data
+
+        const size_t N = (_kzmax + 1u) * _plane;
+        _derv_z = new double[N];
+        if (derivatives) {
+            memcpy(_derv_z, derivatives, N * sizeof(double));
+            return;
+        }
+
+        // split the (lat,lon) columns into blocks for each thread
+
+        if (num_threads == 0) {
+            num_threads = (N < MIN_THREAD_SIZE) ? 1u
+                : std::max(1u, boost::thread::hardware_concurrency());
+        }
+        num_threads = std::min(num_threads, (unsigned) _plane);
+        if (num_threads < 2) {
+            fill_derivatives(0, _plane);
+        } else {
+            boost::thread_group threads;
+            for (unsigned n = 0; n < num_threads; ++n) {
+                threads.add_thread(new boost::thread(
+                        &data_grid_svp::fill_derivatives, this,
+                        n * _plane / num_threads,
+                        (n + 1) * _plane / num_threads));
             }
+            threads.join_all();
         }
-        for (int i = 0; i < _kzmax + 1u; ++i) {
-            for (int j = 0; j < _kxmax + 1u; ++j) {
-                for (int k = 0; k < _kymax + 1u; ++k) {
-                    if (i == 0) {
-                        inc1 = _axis[0]->increment(i);
-                        inc2 = _axis[0]->increment(i + 1);
-                        slope_1 = (data_3d(i + 1, j, k) - data_3d(i, j, k))
-                                / inc1;
-                        slope_2 = (data_3d(i + 2, j, k) - data_3d(i + 1, j, k))
-                                / inc2;
-                        result =
-                                ((2.0 * inc1 + inc2) * slope_1 - inc1 * slope_2)
-                                        / (inc1 + inc2);
-                        derv_z[i][j][k] = result;
-                        if (result * slope_1 <= 0.0) {
-                            derv_z[i][j][k] = 0.0;
-                        } else if ((slope_1 * slope_2 <= 0.0)
-                                && (abs(result) > abs(3.0 * slope_1))) {
-                            derv_z[i][j][k] = 3.0 * slope_1;
-                        }
-                        #ifdef FAST_NaN_GRID_DEBUG
-                            if(abs(derv_z[i][j][k])>=20.0) {
-                                cout << "***Warning: bogus derivative in the z-direction***" << endl;
-                                cout << "---i==0 condition---" << endl;
-                                cout << "inc1: " << inc1 << "\tinc2: " << inc2 << endl;
-                                cout << "data(" << i << "," << j << "," << k << "): " << data_3d(i,j,k)
-                                << "\tdata(" << i+1 << "," << j << "," << k << "): " << data_3d(i+1,j,k)
-                                << "\tdata(" << i+2 << "," << j << "," << k << "): " << data_3d(i+2,j,k)
-                                << endl;
-                                cout << "slope1: " << slope_1 << "\tslope2: " << slope_2 << endl;
-                                cout << "result: " << result << endl;
-                                cout << "derv_z[" << i << "][" << j << "][" << k << "]: "
-                                << derv_z[i][j][k] << endl;
-                            }
-                        #endif
-                    } else if (i == _kzmax) {
-                        inc1 = _axis[0]->increment(i - 1);
-                        inc2 = _axis[0]->increment(i);
-                        slope_1 = (data_3d(i - 1, j, k) - data_3d(i - 2, j, k))
-                                / inc1;
-                        slope_2 = (data_3d(i, j, k) - data_3d(i - 1, j, k))
-                                / inc2;
-                        result =
-                                ((2.0 * inc1 + inc2) * slope_2 - inc1 * slope_1)
-                                        / (inc1 + inc2);
-                        derv_z[i][j][k] = result;
-                        if (result * slope_1 <= 0.0) {
-                            derv_z[i][j][k] = 0.0;
-                        } else if ((slope_1 * slope_2 <= 0.0)
-                                && (abs(result) > abs(3.0 * slope_1))) {
-                            derv_z[i][j][k] = 3.0 * slope_1;
-                        }
-                        #ifdef FAST_NaN_GRID_DEBUG
-                            if(abs(derv_z[i][j][k])>=20.0) {
-                                cout << "***Warning: bogus derivative in the z-direction***" << endl;
-                                cout << "---i==_kzmax condition---" << endl;
-                                cout << "inc1: " << inc1 << "\tinc2: " << inc2 << endl;
-                                cout << "data(" << i-2 << "," << j << "," << k << "): " << data_3d(i-2,j,k)
-                                << "\tdata(" << i-1 << "," << j << "," << k << "): " << data_3d(i-1,j,k)
-                                << "\tdata(" << i << "," << j << "," << k << "): " << data_3d(i,j,k)
-                                << endl;
-                                cout << "slope1: " << slope_1 << "\tslope2: " << slope_2 << endl;
-                                cout << "result: " << result << endl;
-                                cout << "derv_z[" << i << "][" << j << "][" << k << "]: "
-                                << derv_z[i][j][k] << endl;
-                            }
-                        #endif
-                    } else {
-                        inc1 = _axis[0]->increment(i - 1);
-                        inc2 = _axis[0]->increment(i);
-                        w1 = 2.0 * inc2 + inc1;
-                        w2 = inc2 + 2.0 * inc1;
-                        slope_1 = (data_3d(i, j, k) - data_3d(i - 1, j, k))
-                                / inc1;
-                        slope_2 = (data_3d(i + 1, j, k) - data_3d(i, j, k))
-                                / inc2;
-                        if (slope_1 * slope_2 <= 0.0) {
-                            derv_z[i][j][k] = 0.0;
-                        } else {
-                            derv_z[i][j][k] = (w1 + w2)
-                                    / ((w1 / slope_1) + (w2 / slope_2));
-                        }
-                    #ifdef FAST_NaN_GRID_DEBUG
-                        if(abs(derv_z[i][j][k])>=20.0) {
-                            cout << "***Warning: bogus derivative in the z-direction***" << endl;
-                            cout << "---else condition---" << endl;
-                            cout << "inc1: " << inc1 << "\tinc2: " << inc2 << endl;
-                            cout << "data(" << i-1 << "," << j << "," << k << "): " << data_3d(i-1,j,k)
-                            << "\tdata(" << i << "," << j << "," << k << "): " << data_3d(i,j,k)
-                            << "\tdata(" << i+1 << "," << j << "," << k << "): " << data_3d(i+1,j,k)
-                            << endl;
-                            cout << "slope1: " << slope_1 << "\tslope2: " << slope_2 << endl;
-                            cout << "w1: " << w1 << "\tw2: " << w2 << endl;
-                            cout << "derv_z[" << i << "][" << j << "][" << k << "]: "
-                            << derv_z[i][j][k] << endl;
-                        }
-                    #endif
-                    }
-                } //end for-loop in k
-            } //end for-loop in j
-        } //end for-loop in i
 
     } // end Constructor
 
+    /**
+     * Constructor - Attaches a fast interpolation grid to data and
+     * derivatives that are owned by someone else, such as a memory mapped
+     * ocean_snapshot.  Neither the data nor the derivatives are copied,
+     * and they are not deleted when this grid is destroyed.  The caller
+     * must keep them valid, and unchanged, for the life of this grid.
+     *
+     * @param axis      Axes of the grid, copied with seq_vector::clone().
+     * @param data      Data values, stored in the same order as data_grid.
+     * @param derivatives   Derivatives in the same layout as derivatives().
+     * @throws std::invalid_argument if data or derivatives is NULL.
+     */
+
+    data_grid_svp(seq_vector* axis[], const double* data,
+                  const double* derivatives)
+        :   data_grid<double, 3>(),
+            _kzmax(axis[0]->size() - 1u),
+            _kxmax(axis[1]->size() - 1u),
+            _kymax(axis[2]->size() - 1u),
+            _plane((_kxmax + 1u) * (_kymax + 1u)),
+            _derv_z(const_cast<double*>(derivatives)),
+            _shared(true)
+    {
+        if (data == NULL || derivatives == NULL) {
+            throw std::invalid_argument(
+                "attached data and derivatives must not be NULL");
+        }
+        for (unsigned n = 0; n < 3; ++n) {
+            _axis[n] = axis[n]->clone();
+        }
+        _data = const_cast<double*>(data);
+        interp_type(0, GRID_INTERP_PCHIP);
+        interp_type(1, GRID_INTERP_LINEAR);
+        interp_type(2, GRID_INTERP_LINEAR);
+    }
+
+    /**
+     * Destroys the storage for derivatives, unless it is shared.
+     */
+    virtual ~data_grid_svp() {
+        if (_shared) {
+            _data = NULL;       // keeps base class from deleting it
+        } else {
+            delete[] _derv_z;
+        }
+    }
+
+    /**
+     * PCHIP derivatives in the depth direction, stored in the same
+     * order as the data.  Can be saved, and passed to the constructor
+     * of a new grid with the same axes and data, to avoid computing
+     * them again.
+     */
+    inline const double* derivatives() const {
+        return _derv_z;
+    }
+
     /**
      * Overrides the interpolate function within data_grid using the
      * non-recursive formula. Determines which interpolate function to
@@ -203,7 +188,7 @@ public:
         double x, x1, x2, y, y1, y2;
 
         //pchip variables
-        double v1, v2;
+        double v1, v2, d1, d2;
         double inc1;
         double t, t_2, t_3;
         double h00, h10, h01, h11;
@@ -255,10 +240,10 @@ public:
             : cout << (*_axis[0])(_offset[0]);
             cout << "\taxis[1]: " << (*_axis[1])(_offset[1])
             << "\taxis[2]: " << (*_axis[2])(_offset[2]) << endl;
-            cout << "derv_z: (" << derv_z[_offset[0]][_offset[1]][_offset[2]]
-            << ", " << derv_z[_offset[0]+1][_offset[1]][_offset[2]]
-            << ", " << derv_z[_offset[0]+2][_offset[1]][_offset[2]]
-            << ", " << derv_z[_offset[0]+3][_offset[1]][_offset[2]] << ")" << endl;
+            cout << "derv_z: (" << _derv_z[index_3d(_offset[0],_offset[1],_offset[2])]
+            << ", " << _derv_z[index_3d(_offset[0]+1,_offset[1],_offset[2])]
+            << ", " << _derv_z[index_3d(_offset[0]+2,_offset[1],_offset[2])]
+            << ", " << _derv_z[index_3d(_offset[0]+3,_offset[1],_offset[2])] << ")" << endl;
         #endif
 
         //** PCHIP contribution in zeroth dimension */
@@ -274,8 +259,11 @@ public:
         for (int i = 0; i < 2; ++i) {
             for (int j = 0; j < 2; ++j) {
                 //extract data and take precautions when at boundaries of the axis
-                v1 = data_3d(k0, k1 + i, k2 + j);
-                v2 = data_3d(k0 + 1, k1 + i, k2 + j);
+                const size_t n = index_3d(k0, k1 + i, k2 + j);
+                v1 = _data[n];
+                v2 = _data[n + _plane];
+                d1 = _derv_z[n];
+                d2 = _derv_z[n + _plane];
                 inc1 = _axis[0]->increment(k0);
 
                 t = (location[0] - (*_axis[0])(k0)) / inc1;
@@ -288,16 +276,16 @@ public:
                 h01 = (3 * t_2 - 2 * t_3);
                 h11 = (t_3 - t_2);
 
-                _interp_plane(i, j) = h00 * v1 + h10 * derv_z[k0][k1 + i][k2 + j]
-                        + h01 * v2 + h11 * derv_z[k0 + 1][k1 + i][k2 + j];
+                _interp_plane(i, j) = h00 * v1 + h10 * d1
+                        + h01 * v2 + h11 * d2;
 
                 #ifdef FAST_PCHIP_GRID_DEBUG
                     cout << "v1: " << v1 << "\tv2: " << v2 << endl;
                     cout << "inc1: " << inc1 << endl;
                     cout << "t: " << t << "\tt_2: " << t_2
                     << "\tt_3: " << t_3 << endl;
-                    cout << "slope_1: " << derv_z[k0][k1+i][k2+j]
-                    << "\tslope_2: " << derv_z[k0+1][k1+i][k2+j] << endl;
+                    cout << "slope_1: " << d1
+                    << "\tslope_2: " << d2 << endl;
                     cout << "h00: " << h00 << "\th10: " << h10
                     << "\th01: " << h01 << "\th11: " << h11 << endl;
                     cout << "_interp_plane(" << i << ", " << j << "): "
@@ -306,9 +294,9 @@ public:
 
                 if (derivative) {
                     _dz(i, j) = (6 * t_2 - 6 * t) * v1 / inc1
-                            + (3 * t_2 - 4 * t + 1) * derv_z[k0][k1 + i][k2 + j]
+                            + (3 * t_2 - 4 * t + 1) * d1
                                     / inc1 + (6 * t - 6 * t_2) * v2 / inc1
-                            + (3 * t_2 - 2 * t) * derv_z[k0 + 1][k1 + i][k2 + j]
+                            + (3 * t_2 - 2 * t) * d2
                                     / inc1;
                 }
             }
@@ -396,16 +384,96 @@ public:
 
 private:
 
-    /** Utility accessor function for data grid values */
-    inline double data_3d(unsigned dim0, unsigned dim1, unsigned dim2)
+    /** Offset of a data grid value, and its derivative, in storage. */
+    inline size_t index_3d(unsigned dim0, unsigned dim1, unsigned dim2) const
     {
-        unsigned grid_index[3];
-        grid_index[0] = dim0;
-        grid_index[1] = dim1;
-        grid_index[2] = dim2;
-        return data(grid_index);
+        return (dim0 * (_kxmax + 1u) + dim1) * (_kymax + 1u) + dim2;
 
-    } // end data_3d
+    } // end index_3d
+
+    /**
+     * Compute PCHIP derivatives in the depth direction for a block of
+     * (lat,lon) columns.  Each depth is processed as a contiguous run
+     * of columns, which share the same depth increments.
+     *
+     * @param first     Index of the first column in the block.
+     * @param last      Index one past the last column in the block.
+     */
+    void fill_derivatives(size_t first, size_t last)
+    {
+        for (unsigned i = 0; i <= _kzmax; ++i) {
+            double* derv = _derv_z + i * _plane;
+            if (i == 0) {
+                const double inc1 = _axis[0]->increment(i);
+                const double inc2 = _axis[0]->increment(i + 1);
+                const double* d0 = _data + i * _plane;
+                for (size_t p = first; p < last; ++p) {
+                    const double slope_1 = (d0[p + _plane] - d0[p]) / inc1;
+                    const double slope_2 =
+                            (d0[p + 2 * _plane] - d0[p + _plane]) / inc2;
+                    const double result =
+                            ((2.0 * inc1 + inc2) * slope_1 - inc1 * slope_2)
+                                    / (inc1 + inc2);
+                    derv[p] = result;
+                    if (result * slope_1 <= 0.0) {
+                        derv[p] = 0.0;
+                    } else if ((slope_1 * slope_2 <= 0.0)
+                            && (abs(result) > abs(3.0 * slope_1))) {
+                        derv[p] = 3.0 * slope_1;
+                    }
+                }
+            } else if (i == _kzmax) {
+                const double inc1 = _axis[0]->increment(i - 1);
+                const double inc2 = _axis[0]->increment(i);
+                const double* d0 = _data + (i - 2) * _plane;
+                for (size_t p = first; p < last; ++p) {
+                    const double slope_1 =
+                            (d0[p + _plane] - d0[p]) / inc1;
+                    const double slope_2 =
+                            (d0[p + 2 * _plane] - d0[p + _plane]) / inc2;
+                    const double result =
+                            ((2.0 * inc1 + inc2) * slope_2 - inc1 * slope_1)
+                                    / (inc1 + inc2);
+                    derv[p] = result;
+                    if (result * slope_1 <= 0.0) {
+                        derv[p] = 0.0;
+                    } else if ((slope_1 * slope_2 <= 0.0)
+                            && (abs(result) > abs(3.0 * slope_1))) {
+                        derv[p] = 3.0 * slope_1;
+                    }
+                }
+            } else {
+                const double inc1 = _axis[0]->increment(i - 1);
+                const double inc2 = _axis[0]->increment(i);
+                const double w1 = 2.0 * inc2 + inc1;
+                const double w2 = inc2 + 2.0 * inc1;
+                const double* d0 = _data + (i - 1) * _plane;
+                for (size_t p = first; p < last; ++p) {
+                    const double slope_1 = (d0[p + _plane] - d0[p]) / inc1;
+                    const double slope_2 =
+                            (d0[p + 2 * _plane] - d0[p + _plane]) / inc2;
+                    derv[p] = (slope_1 * slope_2 <= 0.0) ? 0.0
+                            : (w1 + w2) / ((w1 / slope_1) + (w2 / slope_2));
+                }
+            }
+            #ifdef FAST_NaN_GRID_DEBUG
+                for (size_t p = first; p < last; ++p) {
+                    if (abs(derv[p]) >= 20.0) {
+                        cout << "***Warning: bogus derivative in the z-direction***"
+                             << endl << "derv_z[" << i << "][" << p << "]: "
+                             << derv[p] << endl;
+                    }
+                }
+            #endif
+        }
+
+    } // end fill_derivatives
+
+    /**
+     * Minimum number of grid points before derivatives
+     * are computed using multiple threads.
+     */
+    static const size_t MIN_THREAD_SIZE = 1 << 18;
 
     /**
      * Create all variables needed for each calculation once
@@ -413,12 +481,20 @@ private:
      */
     unsigned _kzmax, _kxmax, _kymax;  //max index on z-axis (depth)
 
+    /** Number of (lat,lon) columns, the distance between depths in storage. */
+    size_t _plane;
+
     //bi-linear variable
     c_matrix<double, 2, 2> _interp_plane;
 
     //pchip variables
     c_matrix<double, 2, 2> _dz;
-    double*** derv_z;
+
+    /** PCHIP derivatives in depth direction, stored like the data. */
+    double* _derv_z;
+
+    /** True if the data and derivatives are owned by someone else. */
+    const bool _shared;
 
 }; // end data_grid_svp class
 
@@ -0,0 +1,523 @@
+/**
+ * @file data_grid_unrolled.h
+ * Wrapper for a data_grid that uses a compile-time unrolled
+ * interpolation engine.
+ */
+#ifndef USML_TYPES_DATA_GRID_UNROLLED_H
+#define USML_TYPES_DATA_GRID_UNROLLED_H
+
+#include <stdexcept>
+#include <usml/types/data_grid.h>
+
+namespace usml {
+namespace types {
+/// @ingroup data_grid
+/// @{
+
+/**
+ * @internal
+ * Interpolation type used to terminate the kernel recursion at Dim=-1.
+ */
+const int DATA_GRID_INTERP_TERMINAL = -2 ;
+
+/**
+ * @internal
+ * Compile-time selection of the interpolation type for one dimension.
+ * Specializations exist for Dim=-1 (terminal) through Dim=3, which limits
+ * data_grid_unrolled to a maximum of 4 dimensions.
+ */
+template<int Dim, int T0, int T1, int T2, int T3>
+struct data_grid_interp_select ;
+
+/** @internal Terminal dimension. */
+template<int T0, int T1, int T2, int T3>
+struct data_grid_interp_select<-1,T0,T1,T2,T3> {
+    enum { value = DATA_GRID_INTERP_TERMINAL } ;
+};
+
+/** @internal Interpolation type of dimension 0. */
+template<int T0, int T1, int T2, int T3>
+struct data_grid_interp_select<0,T0,T1,T2,T3> { enum { value = T0 } ; };
+
+/** @internal Interpolation type of dimension 1. */
+template<int T0, int T1, int T2, int T3>
+struct data_grid_interp_select<1,T0,T1,T2,T3> { enum { value = T1 } ; };
+
+/** @internal Interpolation type of dimension 2. */
+template<int T0, int T1, int T2, int T3>
+struct data_grid_interp_select<2,T0,T1,T2,T3> { enum { value = T2 } ; };
+
+/** @internal Interpolation type of dimension 3. */
+template<int T0, int T1, int T2, int T3>
+struct data_grid_interp_select<3,T0,T1,T2,T3> { enum { value = T3 } ; };
+
+/**
+ * @internal
+ * List of the interpolation types for each dimension, known at compile time.
+ */
+template<int T0, int T1, int T2, int T3>
+struct data_grid_interp_list {
+
+    /** Interpolation type for a specific dimension. */
+    template<int Dim> struct at {
+        enum { value = data_grid_interp_select<Dim,T0,T1,T2,T3>::value } ;
+    };
+
+    /** Run-time lookup of the interpolation type for a dimension. */
+    static enum GRID_INTERP_TYPE type( unsigned dim ) {
+        const int list[] = { T0, T1, T2, T3 } ;
+        return (enum GRID_INTERP_TYPE) list[dim] ;
+    }
+};
+
+/**
+ * @internal
+ * Interpolation coefficients computed once for each call to
+ * data_grid_unrolled::interpolate(). Shared by all of the stencil
+ * points in the evaluation, so that the increment() and operator()
+ * methods of each axis are only invoked once per dimension.
+ */
+template<class DATA_TYPE, unsigned NUM_DIMS>
+struct data_grid_stencil {
+
+    /** Number of data elements between neighbors in each dimension. */
+    const size_t* stride ;
+
+    /** Normalized offset into the interval for linear interpolation. */
+    DATA_TYPE u[NUM_DIMS] ;
+
+    /** Offset from the start of the interval for pchip interpolation. */
+    DATA_TYPE s[NUM_DIMS] ;
+
+    /** Axis intervals from k-1 to k, k to k+1, and k+1 to k+2. */
+    DATA_TYPE h0[NUM_DIMS], h1[NUM_DIMS], h2[NUM_DIMS] ;
+
+    /** True if the k-1 and k+2 points exist in each dimension. */
+    bool left[NUM_DIMS], right[NUM_DIMS] ;
+};
+
+/**
+ * @internal
+ * Compile-time recursion engine for multi-dimensional interpolation.
+ * Specialized for each type of interpolation, so that the type of
+ * interpolation never needs to be tested inside of the evaluation.
+ * The recursion order, and the arithmetic for each step, are identical
+ * to data_grid::interp() so that both engines produce the same results.
+ * The eval() methods are templated on the storage type of the data, so
+ * that data stored as float can be interpolated using double arithmetic
+ * (see data_grid_compact).
+ *
+ * @param  DATA_TYPE    Type of data to be interpolated.
+ * @param  NUM_DIMS     Number of dimensions in the grid.
+ * @param  TYPES        data_grid_interp_list for all dimensions.
+ * @param  Dim          Dimension currently being processed.
+ * @param  TYPE         Type of interpolation for this dimension.
+ */
+template<class DATA_TYPE, unsigned NUM_DIMS, class TYPES, int Dim, int TYPE>
+struct data_grid_kernel ;
+
+/**
+ * @internal
+ * Terminates the recursion by retrieving a single data element.
+ */
+template<class DATA_TYPE, unsigned NUM_DIMS, class TYPES>
+struct data_grid_kernel<DATA_TYPE,NUM_DIMS,TYPES,-1,DATA_GRID_INTERP_TERMINAL> {
+
+    typedef data_grid_stencil<DATA_TYPE,NUM_DIMS> stencil ;
+
+    static void setup( seq_vector* const*, unsigned*,
+        const double*, stencil& )
+    {
+    }
+
+    template<class STORAGE>
+    static inline DATA_TYPE eval( const STORAGE* data, const stencil&,
+        DATA_TYPE&, DATA_TYPE* )
+    {
+        return (DATA_TYPE) *data ;
+    }
+};
+
+/**
+ * @internal
+ * Nearest neighbor interpolation for this dimension. The choice of
+ * neighbor is made in setup() by moving the corner index.
+ */
+template<class DATA_TYPE, unsigned NUM_DIMS, class TYPES, int Dim>
+struct data_grid_kernel<DATA_TYPE,NUM_DIMS,TYPES,Dim,GRID_INTERP_NEAREST> {
+
+    typedef data_grid_stencil<DATA_TYPE,NUM_DIMS> stencil ;
+    typedef data_grid_kernel< DATA_TYPE, NUM_DIMS, TYPES, Dim-1,
+        TYPES::template at<Dim-1>::value > next ;
+
+    static void setup( seq_vector* const* axis, unsigned* index,
+        const double* location, stencil& st )
+    {
+        const unsigned k = index[Dim] ;
+        const seq_vector* ax = axis[Dim] ;
+        const double u = (location[Dim] - (*ax)(k)) / ax->increment(k) ;
+        if ( u >= 0.5 ) ++index[Dim] ;
+        next::setup( axis, index, location, st ) ;
+    }
+
+    template<class STORAGE>
+    static inline DATA_TYPE eval( const STORAGE* data, const stencil& st,
+        DATA_TYPE& deriv, DATA_TYPE* deriv_vec )
+    {
+        DATA_TYPE da = 0.0 ;
+        const DATA_TYPE result = next::eval( data, st, da, deriv_vec ) ;
+        if ( deriv_vec ) {
+            deriv = 0.0 ;
+            deriv_vec[Dim] = deriv ;
+            if ( Dim > 0 ) deriv_vec[Dim-1] = da ;
+        }
+        return result ;
+    }
+};
+
+/**
+ * @internal
+ * Linear interpolation for this dimension.
+ */
+template<class DATA_TYPE, unsigned NUM_DIMS, class TYPES, int Dim>
+struct data_grid_kernel<DATA_TYPE,NUM_DIMS,TYPES,Dim,GRID_INTERP_LINEAR> {
+
+    typedef data_grid_stencil<DATA_TYPE,NUM_DIMS> stencil ;
+    typedef data_grid_kernel< DATA_TYPE, NUM_DIMS, TYPES, Dim-1,
+        TYPES::template at<Dim-1>::value > next ;
+
+    static void setup( seq_vector* const* axis, unsigned* index,
+        const double* location, stencil& st )
+    {
+        const unsigned k = index[Dim] ;
+        const seq_vector* ax = axis[Dim] ;
+        st.h1[Dim] = (DATA_TYPE) ax->increment(k) ;
+        st.u[Dim] = (location[Dim] - (*ax)(k)) / st.h1[Dim] ;
+        next::setup( axis, index, location, st ) ;
+    }
+
+    template<class STORAGE>
+    static inline DATA_TYPE eval( const STORAGE* data, const stencil& st,
+        DATA_TYPE& deriv, DATA_TYPE* deriv_vec )
+    {
+        DATA_TYPE da = 0.0, db = 0.0 ;
+        const DATA_TYPE a = next::eval( data, st, da, deriv_vec ) ;
+        const DATA_TYPE b = next::eval( data+st.stride[Dim], st, db, deriv_vec ) ;
+        const DATA_TYPE u = st.u[Dim] ;
+        const DATA_TYPE result = a * (1.0 - u) + b * u ;
+        if ( deriv_vec ) {
+            deriv = (b - a) / st.h1[Dim] ;
+            deriv_vec[Dim] = deriv ;
+            if ( Dim > 0 ) deriv_vec[Dim-1] = da * (1.0 - u) + db * u ;
+        }
+        return result ;
+    }
+};
+
+/**
+ * @internal
+ * Piecewise Cubic Hermite Interpolation Polynomial (PCHIP) for
+ * this dimension.  See data_grid::pchip() for a description of the
+ * algorithm and its end-point treatment.
+ */
+template<class DATA_TYPE, unsigned NUM_DIMS, class TYPES, int Dim>
+struct data_grid_kernel<DATA_TYPE,NUM_DIMS,TYPES,Dim,GRID_INTERP_PCHIP> {
+
+    typedef data_grid_stencil<DATA_TYPE,NUM_DIMS> stencil ;
+    typedef data_grid_kernel< DATA_TYPE, NUM_DIMS, TYPES, Dim-1,
+        TYPES::template at<Dim-1>::value > next ;
+
+    static void setup( seq_vector* const* axis, unsigned* index,
+        const double* location, stencil& st )
+    {
+        const unsigned k = index[Dim] ;
+        const seq_vector* ax = axis[Dim] ;
+        st.h0[Dim] = (DATA_TYPE) ax->increment(k - 1) ;
+        st.h1[Dim] = (DATA_TYPE) ax->increment(k) ;
+        st.h2[Dim] = (DATA_TYPE) ax->increment(k + 1) ;
+        st.s[Dim] = location[Dim] - (*ax)(k) ;
+        st.left[Dim] = ( k >= 1u ) ;
+        st.right[Dim] = ( k <= ax->size() - 3u ) ;
+        next::setup( axis, index, location, st ) ;
+    }
+
+    template<class STORAGE>
+    static inline DATA_TYPE eval( const STORAGE* data, const stencil& st,
+        DATA_TYPE& deriv, DATA_TYPE* deriv_vec )
+    {
+        const size_t stride = st.stride[Dim] ;
+        DATA_TYPE y0, y1, y2, y3 ;
+        DATA_TYPE dy0 = 0.0, dy1 = 0.0, dy2 = 0.0, dy3 = 0.0 ;
+
+        // gather values at k, k-1, k+1, k+2 in the same order as pchip()
+
+        y1 = next::eval( data, st, dy1, deriv_vec ) ;
+        if ( st.left[Dim] ) {
+            y0 = next::eval( data-stride, st, dy0, deriv_vec ) ;
+        } else {
+            y0 = y1 ;
+            dy0 = dy1 ;
+        }
+        y2 = next::eval( data+stride, st, dy2, deriv_vec ) ;
+        if ( st.right[Dim] ) {
+            y3 = next::eval( data+2*stride, st, dy3, deriv_vec ) ;
+        } else {
+            y3 = y2 ;
+            dy3 = dy2 ;
+        }
+
+        // compute difference values used frequently in computation
+
+        const DATA_TYPE h0 = st.h0[Dim] ;
+        const DATA_TYPE h1 = st.h1[Dim] ;
+        const DATA_TYPE h2 = st.h2[Dim] ;
+        const DATA_TYPE h1_2 = h1 * h1 ;
+        const DATA_TYPE h1_3 = h1_2 * h1 ;
+
+        const DATA_TYPE s = st.s[Dim] ;
+        const DATA_TYPE s_2 = s * s, s_3 = s_2 * s ;
+        const DATA_TYPE sh_minus = s - h1 ;
+        const DATA_TYPE sh_term = 3.0 * h1 * s_2 - 2.0 * s_3 ;
+
+        // compute first divided differences (forward derivative)
+
+        const DATA_TYPE deriv0 = (y1 - y0) / h0 ;
+        const DATA_TYPE deriv1 = (y2 - y1) / h1 ;
+        const DATA_TYPE deriv2 = (y3 - y2) / h2 ;
+
+        DATA_TYPE dderiv0=0.0, dderiv1=0.0, dderiv2=0.0 ;
+        if ( deriv_vec ) {
+            dderiv0 = (dy1 - dy0) / h0 ;
+            dderiv1 = (dy2 - dy1) / h1 ;
+            dderiv2 = (dy3 - dy2) / h2 ;
+        }
+
+        // weighted harmonic mean of slopes around index k
+
+        DATA_TYPE slope1=0.0, dslope1=0.0 ;
+        if ( st.left[Dim] ) {
+            const DATA_TYPE w0 = 2.0 * h1 + h0 ;
+            const DATA_TYPE w1 = h1 + 2.0 * h0 ;
+            if ( deriv0 * deriv1 > 0.0 ) {
+                slope1 = (w0 + w1) / ( w0 / deriv0 + w1 / deriv1 ) ;
+            }
+            if ( deriv_vec != NULL && dderiv0 * dderiv1 > 0.0 ) {
+                dslope1 = (w0 + w1) / ( w0 / dderiv0 + w1 / dderiv1 ) ;
+            }
+        } else {
+            slope1 = ( (2.0+h1+h2) * deriv1 - h1 * deriv2 ) / (h1+h2) ;
+            if ( slope1 * deriv1 < 0.0 ) {
+                slope1 = 0.0 ;
+            } else if ( (deriv1*deriv2 < 0.0) && (abs(slope1) > abs(3.0*deriv1)) ) {
+                slope1 = 3.0*deriv1 ;
+            }
+            if ( deriv_vec ) {
+                dslope1 = ( (2.0+h1+h2) * dderiv1 - h1 * dderiv2 ) / (h1+h2) ;
+                if ( dslope1 * dderiv1 < 0.0 ) {
+                    dslope1 = 0.0 ;
+                } else if ( (dderiv1*dderiv2 < 0.0) && (abs(dslope1) > abs(3.0*dderiv1)) ) {
+                    dslope1 = 3.0*dderiv1 ;
+                }
+            }
+        }
+
+        // weighted harmonic mean of slopes around index k+1
+
+        DATA_TYPE slope2=0.0, dslope2=0.0 ;
+        if ( st.right[Dim] ) {
+            const DATA_TYPE w1 = 2.0 * h1 + h0 ;
+            const DATA_TYPE w2 = h1 + 2.0 * h0 ;
+            if ( deriv1 * deriv2 > 0.0 ) {
+                slope2 = (w1 + w2) / ( w1 / deriv1 + w2 / deriv2 ) ;
+            }
+            if ( deriv_vec != NULL && dderiv1 * dderiv2 > 0.0 ) {
+                dslope2 = (w1 + w2) / ( w1 / dderiv1 + w2 / dderiv2 ) ;
+            }
+        } else {
+            slope2 = ( (2.0+h1+h2) * deriv1 - h1 * deriv0 ) / (h1+h0) ;
+            if ( slope2 * deriv1 < 0.0 ) {
+                slope2 = 0.0 ;
+            } else if ( (deriv1*deriv0 < 0.0) && (abs(slope2) > abs(3.0*deriv1)) ) {
+                slope2 = 3.0*deriv1 ;
+            }
+            if ( deriv_vec ) {
+                dslope2 = ( (2.0+h1+h2) * dderiv1 - h1 * dderiv0 ) / (h1+h0) ;
+                if ( dslope2 * dderiv1 < 0.0 ) {
+                    dslope2 = 0.0 ;
+                } else if ( (dderiv1*dderiv0 < 0.0) && (abs(dslope2) > abs(3.0*dderiv1)) ) {
+                    dslope2 = 3.0*dderiv1 ;
+                }
+            }
+        }
+
+        // compute interpolation value and derivative in this dimension
+
+        const DATA_TYPE result = y2 * sh_term / h1_3
+               + y1 * (h1_3 - sh_term) / h1_3
+               + slope2 * s_2 * sh_minus / h1_2
+               + slope1 * s * sh_minus * sh_minus / h1_2 ;
+
+        if ( deriv_vec ) {
+            const DATA_TYPE u = s / h1 ;
+            deriv = slope1 * (1.0 - u) + slope2 * u ;
+            deriv_vec[Dim] = deriv ;
+            if ( Dim > 0 ) {
+                deriv_vec[Dim-1] = dy2 * sh_term / h1_3
+                                 + dy1 * (h1_3 - sh_term) / h1_3
+                                 + dslope2 * s_2 * sh_minus / h1_2
+                                 + dslope1 * s * sh_minus * sh_minus / h1_2 ;
+            }
+        }
+        return result ;
+    }
+};
+
+/**
+ * Implements fast calculations for data_grids using an interpolation
+ * engine that is unrolled at compile time.  The type of interpolation
+ * in each dimension is a template parameter, instead of a run-time
+ * property. This allows the compiler to generate a dedicated kernel
+ * for each combination of interpolation types, that:
+ *
+ * - computes the interval index, and the interpolation coefficients,
+ *   for each dimension exactly once per interpolate() call,
+ * - gathers the 2^N (linear) or 4^N (pchip) stencil by pointer offsets
+ *   into the data array, instead of copying index arrays,
+ * - never tests the type of interpolation inside the evaluation.
+ *
+ * The results are identical to those of data_grid::interpolate() for
+ * the same combination of interpolation types. Because interpolate() is
+ * virtual, this class can be used as a drop-in replacement for the
+ * data_grid passed to profile_grid<double,N> and boundary_grid<double,N>.
+ * Supports a maximum of 4 dimensions. If interp_type() is changed after
+ * construction, like boundary_grid::height() does for quick_interp,
+ * interpolate() falls back to data_grid::interpolate() until the types
+ * match the template parameters again.
+ *
+ * @param  DATA_TYPE    Type of data to be interpolated.
+ * @param  NUM_DIMS     Number of dimensions in this grid (1 to 4).
+ * @param  INTERP0      Type of interpolation for dimension 0.
+ * @param  INTERP1      Type of interpolation for dimension 1.
+ * @param  INTERP2      Type of interpolation for dimension 2.
+ * @param  INTERP3      Type of interpolation for dimension 3.
+ */
+template< class DATA_TYPE, unsigned NUM_DIMS,
+    enum GRID_INTERP_TYPE INTERP0 = GRID_INTERP_LINEAR,
+    enum GRID_INTERP_TYPE INTERP1 = GRID_INTERP_LINEAR,
+    enum GRID_INTERP_TYPE INTERP2 = GRID_INTERP_LINEAR,
+    enum GRID_INTERP_TYPE INTERP3 = GRID_INTERP_LINEAR >
+class data_grid_unrolled : public data_grid<DATA_TYPE, NUM_DIMS> {
+
+    /** Compile-time list of interpolation types. */
+    typedef data_grid_interp_list<INTERP0,INTERP1,INTERP2,INTERP3> types ;
+
+    /** Recursion engine that starts with the last dimension. */
+    typedef data_grid_kernel< DATA_TYPE, NUM_DIMS, types, NUM_DIMS-1,
+        types::template at<NUM_DIMS-1>::value > kernel ;
+
+public:
+
+    using data_grid<DATA_TYPE, NUM_DIMS>::interpolate ;
+
+    /**
+     * Creates a fast interpolation grid from an existing data_grid.
+     *
+     * @param grid      The data_grid that is to be wrapped.
+     * @param copy_data If true, copies the data grids data
+     *                  fields as well as the axises.
+     * @throws std::invalid_argument if an axis is too short for the
+     *                  requested type of interpolation.
+     */
+    data_grid_unrolled(const data_grid<DATA_TYPE, NUM_DIMS>& grid,
+        bool copy_data = true)
+        : data_grid<DATA_TYPE, NUM_DIMS>(grid, copy_data)
+    {
+        initialize() ;
+    }
+
+    /**
+     * Create data grid from its associated axes.
+     * Allocates new memory for the data at each grid point.
+     *
+     * @param axis  Axes to use for each dimension of the grid.
+     * @throws std::invalid_argument if an axis is too short for the
+     *              requested type of interpolation.
+     */
+    data_grid_unrolled(seq_vector *axis[])
+        : data_grid<DATA_TYPE, NUM_DIMS>(axis)
+    {
+        initialize() ;
+    }
+
+    /**
+     * Multi-dimensional interpolation with the derivative calculation.
+     * Uses the same edge limiting rules as data_grid::interpolate().
+     * Uses data_grid::interpolate() if the interpolation type of any
+     * axis no longer matches the template parameters.
+     * Does not modify any member variables.
+     *
+     * @param   location    Location at which field value is desired. Must
+     *                      have the same rank as the data grid or higher.
+     *                      WARNING: The contents of the location vector
+     *                      may be modified if edge_limit() is true for
+     *                      any dimension.
+     * @param   derivative  If this is not null, the first derivative
+     *                      of the field at this point will also be computed.
+     * @return              Value of the field at this point.
+     */
+    virtual DATA_TYPE interpolate(double* location, DATA_TYPE* derivative = NULL)
+    {
+        for ( unsigned n=0 ; n < NUM_DIMS ; ++n ) {
+            if ( this->interp_type(n) != types::type(n) ) {
+                return data_grid<DATA_TYPE, NUM_DIMS>::interpolate(
+                    location, derivative ) ;
+            }
+        }
+        unsigned index[NUM_DIMS] ;
+        this->find_offset( location, index ) ;
+
+        data_grid_stencil<DATA_TYPE,NUM_DIMS> st ;
+        st.stride = _stride ;
+        kernel::setup( this->_axis, index, location, st ) ;
+
+        size_t corner = 0 ;
+        for ( unsigned n=0 ; n < NUM_DIMS ; ++n ) {
+            corner += index[n] * _stride[n] ;
+        }
+        DATA_TYPE dresult ;
+        return kernel::eval( this->_data+corner, st, dresult, derivative ) ;
+    }
+
+private:
+
+    /** Number of data elements between neighbors in each dimension. */
+    size_t _stride[NUM_DIMS] ;
+
+    /**
+     * Computes strides and forces the interpolation type of each axis
+     * to match the template parameters.
+     */
+    void initialize() {
+        size_t stride = 1 ;
+        for ( int n=NUM_DIMS-1 ; n >= 0 ; --n ) {
+            const unsigned size = this->_axis[n]->size() ;
+            const enum GRID_INTERP_TYPE type = types::type(n) ;
+            if ( (type > GRID_INTERP_NEAREST && size < 2)
+              || (type > GRID_INTERP_LINEAR && size < 4) )
+            {
+                throw std::invalid_argument(
+                    "axis too short for interpolation type") ;
+            }
+            this->interp_type( n, type ) ;
+            _stride[n] = stride ;
+            stride *= size ;
+        }
+    }
+
+} ;
+
+/// @}
+} // end of namespace types
+} // end of namespace usml
+
+#endif
@@ -5,6 +5,7 @@
 #ifndef USML_TYPES_SEQ_DATA_H
 #define USML_TYPES_SEQ_DATA_H
 
+#include <vector>
 #include <usml/types/seq_vector.h>
 
 namespace usml {
@@ -23,7 +24,12 @@ using boost::numeric::ublas::vector;
  * of points and this class is needed for completeness.
  *
  * The find_index() routine in this implementation tries to speed up the
- * search by using the last search as the initial guess for the next search.
+ * search by first checking the interval found by the last search.  If the
+ * new value is outside of that interval, it falls back to a branch-free
+ * binary search, so queries that jump around the axis (different rays,
+ * different threads) cost O(log N) instead of a linear walk.
+ * The lookup_table() method can be used to narrow this binary search
+ * to a few elements using a table of uniformly spaced bins.
  */
 class USML_DECLSPEC seq_data : public seq_vector {
 
@@ -49,6 +55,20 @@ protected:
     /** Sign value is 1 if the sequence is increasing, -1 if decreasing. */
     value_type _sign;
 
+    /**
+     * Optional lookup table that maps uniformly spaced bins onto the
+     * first index of the binary search. Entry "b" is the index of the
+     * largest element not greater than the start of bin "b".
+     * Search is not accelerated if this table is empty.
+     */
+    std::vector<size_type> _lut;
+
+    /** Value (times _sign) at the start of the first lookup table bin. */
+    value_type _lut_first;
+
+    /** Number of lookup table bins per unit value (times _sign). */
+    value_type _lut_scale;
+
     //**************************************************
     // private functions
 
@@ -61,6 +81,34 @@ protected:
     void init( const double* data, unsigned size ) {
     }
 
+    /**
+     * Stateless search that uses the lookup table, if it exists,
+     * to limit the range of the branch-free binary search.
+     *
+     * @param   value       Value of the element to find.
+     * @return              Index of the largest value that is not greater
+     *                      than the argument, limited to [0,size-2].
+     */
+    inline size_type lookup( value_type value ) const {
+        if ( _lut.empty() ) {
+            return bisect( value, 0, _max_index ) ;
+        }
+        const value_type bin = ( value * _sign - _lut_first ) * _lut_scale ;
+        const size_type nbins = _lut.size() - 1 ;
+        size_type b = 0 ;
+        if ( bin >= (value_type) nbins ) {
+            b = nbins - 1 ;
+        } else if ( bin > 0.0 ) {
+            b = (size_type) bin ;
+        }
+        // widen the range by one element on each side
+        // to protect against round-off at the bin edges
+
+        const size_type first = ( _lut[b] > 0 ) ? _lut[b] - 1 : 0 ;
+        const size_type last = min( _lut[b+1] + 1, _max_index - 1 ) ;
+        return bisect( value, first, last - first + 1 ) ;
+    }
+
     //**************************************************
     // virtual functions
 
@@ -89,42 +137,57 @@ public:
         }
         _value = value;
 
-        // search backwards (toward the front)?
-
-        value *= _sign;
-        if (_index_data > value) {
-
-            // Looping ends when the beginning of the list is hit or when
-            // then new point is less than, or equal to, the search value.
-
-            for (difference_type n = _index - 1; n >= 0 && _index_data > value; --n) {
-                _index_data = _data(--_index) * _sign;
-            }
-
-            // search forwards (toward the back)?
-
-        } else if (_index_data < value) {
+        // check the interval from the last search
 
-            // Looping ends when the end of the list is hit or when
-            // new point is greater than, or equal to, the search value.
+        const value_type v = value * _sign;
+        if ( _index_data <= v && v < _data[_index+1] * _sign ) {
+            return _index;
+        }
 
-            difference_type N = size() - 2;
-            for (difference_type n = _index + 1; n <= N && _index_data < value; ++n) {
-                _index_data = _data(++_index) * _sign;
-            }
+        // search the whole sequence
 
-            // If new point is greater than the search value,
-            // we've gone too far and we need to back up by one.
+        _index = lookup(value);
+        _index_data = _data[_index] * _sign;
+        return _index;
+    }
 
-            if (_index_data > value && _index > 0) {
-                _index_data = _data(--_index) * _sign;
-            }
+    /**
+     * Search for a value in this sequence without updating the cache
+     * of the last search. Safe for concurrent use by multiple threads.
+     *
+     * @param   value       Value of the element to find.
+     * @return              Index of the largest value that is not greater
+     *                      than the argument, limited to [0,size-2].
+     */
+    virtual size_type find_index_stateless(value_type value) const {
+        return lookup(value);
+    }
 
+    /**
+     * Build a lookup table that accelerates find_index() for long,
+     * unevenly spaced sequences. The range of the sequence is divided
+     * into uniformly spaced bins, and each bin remembers the range of
+     * indices that overlap it.  The binary search is then limited
+     * to that range.
+     *
+     * @param  num_bins     Number of bins in the table.
+     *                      Removes the table if zero.
+     */
+    void lookup_table( size_type num_bins ) {
+        _lut.clear();
+        if ( num_bins == 0 || _max_index < 2 ) {
+            return;
         }
-        return _index;
+        _lut_first = _data[0] * _sign ;
+        _lut_scale = num_bins / ( _data[_max_index] * _sign - _lut_first ) ;
+        std::vector<size_type> table( num_bins+1 ) ;
+        for ( size_type b=0 ; b <= num_bins ; ++b ) {
+            table[b] = bisect( ( _lut_first + b / _lut_scale ) * _sign,
+                               0, _max_index ) ;
+        }
+        _lut.swap( table ) ;
     }
 
-
     //***************************************************************
     // constructors and destructors
 
@@ -137,7 +200,9 @@ public:
      *
      * @param  size		  Length of the sequence to create.
      */
-    seq_data(size_type size) : seq_vector(size) {
+    seq_data(size_type size) : seq_vector(size),
+        _lut_first(0.0), _lut_scale(0.0)
+    {
     }
 
     /**
@@ -148,7 +213,9 @@ public:
      * @param  size               Number of elements in data.
      * @throws invalid_argument   If series not monotonic
      */
-    seq_data( const double* data, unsigned size ) : seq_vector( size ) {
+    seq_data( const double* data, unsigned size ) : seq_vector( size ),
+        _lut_first(0.0), _lut_scale(0.0)
+    {
         _index = 0 ;
         _value = data[0] ;
         _sign = 1.0;
@@ -191,7 +258,8 @@ public:
      * @throws invalid_argument   If series not monotonic
      */
     template<class T, class A> seq_data( const vector<T,A> &data )
-        : seq_vector( data.size() )
+        : seq_vector( data.size() ),
+        _lut_first(0.0), _lut_scale(0.0)
     {
         _index = 0 ;
         _value = data[0] ;
@@ -235,7 +303,9 @@ public:
     seq_data( const seq_data & copy ) :
         seq_vector(copy),
         _index(copy._index), _value(copy._value),
-        _index_data(copy._index_data), _sign(copy._sign)
+        _index_data(copy._index_data), _sign(copy._sign),
+        _lut(copy._lut), _lut_first(copy._lut_first),
+        _lut_scale(copy._lut_scale)
     {
     }
 
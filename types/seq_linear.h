@@ -38,9 +38,22 @@ public:
      *                      than the argument.
      */
     virtual size_type find_index( value_type value ) {
+        return seq_linear::find_index_stateless( value ) ;
+    }
+
+    /**
+     * Search for a value in this sequence without modifying the sequence.
+     * Uniform spacing allows the index to be computed arithmetically
+     * in O(1) time, so this is also the implementation for find_index().
+     *
+     * @param   value       Value of the element to find.
+     * @return              Index of the largest value that is not greater
+     *                      than the argument.
+     */
+    virtual size_type find_index_stateless( value_type value ) const {
         return (size_type) max(
             (difference_type) 0, min( (difference_type) _size-2,
-            (difference_type) floor( (value - _data(0)) / _increment(0) )));
+            (difference_type) floor( (value - _data[0]) / _increment[0] )));
     }
 
     //***************************************************************
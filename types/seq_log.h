@@ -32,16 +32,15 @@ public:
     /**
      * Search for a value in this sequence. If the value is outside of the
      * legal range, the index for the nearest endpoint will
-     * be returned.
+     * be returned. Uses a branch-free binary search because the
+     * spacing between elements is not uniform.
      *
      * @param   value       Value of the element to find.
      * @return              Index of the largest value that is not greater
      *                      than the argument.
      */
     virtual size_type find_index( value_type value ) {
-        return (size_type) max(
-            (difference_type) 0, min( (difference_type) _size-2,
-            (difference_type) floor( (value - _data(0)) / _increment(0) )));
+        return bisect( value, 0, _max_index ) ;
     }
 
     //***************************************************************
@@ -198,6 +198,50 @@ public:
      */
     virtual size_type find_index(value_type value) = 0;
 
+    /**
+     * Search for a value in this sequence without modifying any of the
+     * search caches used by find_index(). Safe for concurrent use by
+     * multiple threads, and for queries that jump around the axis.
+     * The default implementation uses a branch-free binary search.
+     *
+     * @param   value       Value of the element to find.
+     * @return              Index of the largest value that is not greater
+     *                      than the argument, limited to [0,size-2].
+     */
+    virtual size_type find_index_stateless(value_type value) const {
+        return bisect( value, 0, _max_index ) ;
+    }
+
+protected:
+
+    /**
+     * Branch-free binary search for the interval that contains a value.
+     * Works for both increasing and decreasing sequences.  The loop
+     * always executes log2(count) times, and the comparison inside of it
+     * compiles to a conditional move instead of a branch.
+     *
+     * @param   value       Value of the element to find.
+     * @param   first       First index in the search range.
+     * @param   count       Number of intervals in the search range.
+     * @return              Largest index in [first,first+count-1] whose
+     *                      value is not greater than the argument,
+     *                      or first if there is no such index.
+     */
+    inline size_type bisect(
+        value_type value, size_type first, size_type count ) const
+    {
+        if ( count == 0 ) return first ;
+        const value_type sign = ( _increment[0] < 0.0 ) ? -1.0 : 1.0 ;
+        const value_type* data = &_data[0] ;
+        value = value * sign ;
+        while ( count > 1 ) {
+            const size_type half = count / 2 ;
+            first = ( data[first+half] * sign <= value ) ? first+half : first ;
+            count -= half ;
+        }
+        return first ;
+    }
+
     //**************************************************
     // constructors and destructors
 
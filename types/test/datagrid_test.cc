@@ -5,6 +5,7 @@
 #include <usml/types/types.h>
 #include <iostream>
 #include <stdio.h>
+#include <cstring>
 #ifdef WIN32
 #include "sys_time_win32.h"
 #else
@@ -525,4 +526,205 @@ BOOST_AUTO_TEST_CASE( datagrid_fast_acc_test ) {
     BOOST_CHECK_CLOSE(v0, v1, 3.0);
 }
 
+/**
+ * @ingroup types_test
+ * Verify that a data_grid_svp built from the derivatives() of another
+ * grid gives exactly the same values and derivatives as the original,
+ * and that its values are close to those of the general purpose
+ * data_grid interpolation.  Also checks that derivatives computed with
+ * 4 threads are identical to those computed with a single thread, even
+ * though the 63 (lat,lon) columns don't divide evenly across the threads.
+ */
+BOOST_AUTO_TEST_CASE( datagrid_svp_cache_test ) {
+    cout << "=== datagrid_test: datagrid_svp_cache_test ===" << endl;
+
+    seq_vector* axis[3];
+    axis[0] = new seq_linear(0.0, 100.0, 10);
+    axis[1] = new seq_linear(0.5, 0.01, 7);
+    axis[2] = new seq_linear(-1.0, 0.02, 9);
+    data_grid<double,3> grid(axis);
+    for (unsigned n = 0; n < 3; ++n) delete axis[n];
+
+    unsigned index[3];
+    for (index[0] = 0; index[0] < grid.axis(0)->size(); ++index[0]) {
+        for (index[1] = 0; index[1] < grid.axis(1)->size(); ++index[1]) {
+            for (index[2] = 0; index[2] < grid.axis(2)->size(); ++index[2]) {
+                const double z = (*grid.axis(0))(index[0]);
+                grid.data(index, 1500.0 - 0.05 * z + 1e-5 * z * z
+                        + 3.0 * index[1] - 2.0 * index[2]);
+            }
+        }
+    }
+    grid.interp_type(0, GRID_INTERP_PCHIP);
+    grid.interp_type(1, GRID_INTERP_LINEAR);
+    grid.interp_type(2, GRID_INTERP_LINEAR);
+
+    data_grid_svp fast(grid, true, NULL, 1);
+    data_grid_svp cached(grid, true, fast.derivatives());
+    data_grid_svp threaded(grid, true, NULL, 4);
+    const size_t N = grid.axis(0)->size() * grid.axis(1)->size()
+                   * grid.axis(2)->size();
+    for (size_t n = 0; n < N; ++n) {
+        BOOST_CHECK_EQUAL(fast.derivatives()[n], threaded.derivatives()[n]);
+    }
+
+    double location[3], copy[3], d1[3], d2[3];
+    for (unsigned n = 0; n < 50; ++n) {
+        location[0] = 10.0 + 17.3 * n;
+        location[1] = 0.5 + 0.0011 * n;
+        location[2] = -1.0 + 0.0031 * n;
+        memcpy(copy, location, sizeof(copy));
+        const double v0 = grid.interpolate(copy);
+        memcpy(copy, location, sizeof(copy));
+        const double v1 = fast.interpolate(copy, d1);
+        memcpy(copy, location, sizeof(copy));
+        const double v2 = cached.interpolate(copy, d2);
+        BOOST_CHECK_EQUAL(v1, v2);
+        BOOST_CHECK_EQUAL(d1[0], d2[0]);
+        BOOST_CHECK_EQUAL(d1[1], d2[1]);
+        BOOST_CHECK_EQUAL(d1[2], d2[2]);
+        BOOST_CHECK_CLOSE(v0, v1, 0.1);
+    }
+}
+
+/**
+ * @ingroup types_test
+ * Compare the results of the compile-time unrolled interpolation
+ * engine to those of the recursive data_grid engine for a 3-D grid that
+ * uses pchip interpolation in the first dimension, linear interpolation
+ * in the second dimension, and nearest neighbor in the third.  Access the
+ * unrolled grid through a data_grid pointer to verify that it can
+ * be used as a drop-in replacement. Generate errors if values or
+ * derivatives differ by more that 1E-10 percent.
+ */
+BOOST_AUTO_TEST_CASE( datagrid_unrolled_test ) {
+    cout << "=== datagrid_test: datagrid_unrolled_test ===" << endl;
+
+    seq_vector* axis[3];
+    axis[0] = new seq_linear(1.0, 1.0, 8);
+    axis[1] = new seq_log(1.0, 1.5, 6);
+    axis[2] = new seq_linear(-2.0, 0.5, 5);
+    data_grid<double,3> grid(axis);
+    for (unsigned n = 0; n < 3; ++n) delete axis[n];
+
+    unsigned index[3];
+    double vals[2];
+    for (index[0] = 0; index[0] < grid.axis(0)->size(); ++index[0]) {
+        for (index[1] = 0; index[1] < grid.axis(1)->size(); ++index[1]) {
+            for (index[2] = 0; index[2] < grid.axis(2)->size(); ++index[2]) {
+                vals[0] = (*grid.axis(0))(index[0]);
+                vals[1] = (*grid.axis(1))(index[1]);
+                grid.data(index, cubic2d(vals) + (*grid.axis(2))(index[2]));
+            }
+        }
+    }
+    grid.interp_type(0, GRID_INTERP_PCHIP);
+    grid.interp_type(1, GRID_INTERP_LINEAR);
+    grid.interp_type(2, GRID_INTERP_NEAREST);
+
+    data_grid<double,3>* fast = new data_grid_unrolled<double, 3,
+        GRID_INTERP_PCHIP, GRID_INTERP_LINEAR, GRID_INTERP_NEAREST>(grid);
+
+    for (int i = 0; i < 100; ++i) {
+        double loc1[3], loc2[3], d1[3], d2[3];
+        loc1[0] = loc2[0] = 0.5 + 8.0 * randgen::uniform();
+        loc1[1] = loc2[1] = 0.5 + 8.0 * randgen::uniform();
+        loc1[2] = loc2[2] = -2.5 + 3.0 * randgen::uniform();
+        const double v1 = grid.interpolate(loc1, d1);
+        const double v2 = fast->interpolate(loc2, d2);
+        BOOST_CHECK_CLOSE(v1, v2, 1e-10);
+        for (unsigned n = 0; n < 3; ++n) {
+            BOOST_CHECK_CLOSE(d1[n] + 1.0, d2[n] + 1.0, 1e-10);
+        }
+    }
+    delete fast;
+}
+
+/**
+ * @ingroup types_test
+ * Compare the results of the single precision storage grid to those
+ * of the double precision data_grid engine for the same 3-D grid used
+ * in datagrid_unrolled_test.  Repeat the comparison after changing the
+ * interpolation type of the last axis to verify that the compact grid
+ * follows run-time changes in interpolation type.  Generate errors if
+ * values differ by more than 1E-4 percent, or derivatives differ by
+ * more than 1E-3 percent.  The float storage rounds each value with a
+ * relative error of about 6E-8.  Also checks that the double precision
+ * data() accessors of the compact grid, and copies of its data, fail
+ * loudly, while copies of just its structure still work.  Grids can not
+ * be attached to NULL data.
+ */
+BOOST_AUTO_TEST_CASE( datagrid_compact_test ) {
+    cout << "=== datagrid_test: datagrid_compact_test ===" << endl;
+
+    seq_vector* axis[3];
+    axis[0] = new seq_linear(1.0, 1.0, 8);
+    axis[1] = new seq_log(1.0, 1.5, 6);
+    axis[2] = new seq_linear(-2.0, 0.5, 5);
+    data_grid<double,3> grid(axis);
+    for (unsigned n = 0; n < 3; ++n) delete axis[n];
+
+    unsigned index[3];
+    double vals[2];
+    for (index[0] = 0; index[0] < grid.axis(0)->size(); ++index[0]) {
+        for (index[1] = 0; index[1] < grid.axis(1)->size(); ++index[1]) {
+            for (index[2] = 0; index[2] < grid.axis(2)->size(); ++index[2]) {
+                vals[0] = (*grid.axis(0))(index[0]);
+                vals[1] = (*grid.axis(1))(index[1]);
+                grid.data(index, cubic2d(vals) + (*grid.axis(2))(index[2]));
+            }
+        }
+    }
+    grid.interp_type(0, GRID_INTERP_PCHIP);
+    grid.interp_type(1, GRID_INTERP_LINEAR);
+    grid.interp_type(2, GRID_INTERP_NEAREST);
+
+    data_grid_compact<3>* compact = new data_grid_compact<3>(grid);
+    data_grid<double,3>* fast = compact;
+
+    index[0] = 3; index[1] = 2; index[2] = 1;
+    BOOST_CHECK_CLOSE(grid.data(index), compact->compact_data(index), 1e-5);
+
+    // the compact grid has no double precision copy of its values
+
+    typedef data_grid<double,3> grid_type;
+    BOOST_CHECK(fast->data() == NULL);
+    BOOST_CHECK_THROW(compact->data(index), std::invalid_argument);
+    BOOST_CHECK_THROW(compact->data(index, 1.0), std::invalid_argument);
+    BOOST_CHECK_THROW(grid_type copy(*fast, true),
+                      std::invalid_argument);
+    BOOST_CHECK_THROW(data_grid_svp svp(*fast), std::invalid_argument);
+    BOOST_CHECK_THROW(data_grid_compact<3> twice(*fast),
+                      std::invalid_argument);
+    grid_type structure(*fast, false);
+    BOOST_CHECK_EQUAL(structure.data(index), 0.0);
+
+    seq_vector* shape[3];
+    for (unsigned n = 0; n < 3; ++n) {
+        shape[n] = const_cast<seq_vector*>(fast->axis(n));
+    }
+    BOOST_CHECK_THROW(data_grid_svp attached(shape, fast->data(), NULL),
+                      std::invalid_argument);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass > 0) {
+            grid.interp_type(2, GRID_INTERP_LINEAR);
+            fast->interp_type(2, GRID_INTERP_LINEAR);
+        }
+        for (int i = 0; i < 100; ++i) {
+            double loc1[3], loc2[3], d1[3], d2[3];
+            loc1[0] = loc2[0] = 0.5 + 8.0 * randgen::uniform();
+            loc1[1] = loc2[1] = 0.5 + 8.0 * randgen::uniform();
+            loc1[2] = loc2[2] = -2.5 + 3.0 * randgen::uniform();
+            const double v1 = grid.interpolate(loc1, d1);
+            const double v2 = fast->interpolate(loc2, d2);
+            BOOST_CHECK_CLOSE(v1, v2, 1e-4);
+            for (unsigned n = 0; n < 3; ++n) {
+                BOOST_CHECK_CLOSE(d1[n] + 1.0, d2[n] + 1.0, 1e-3);
+            }
+        }
+    }
+    delete fast;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -348,4 +348,67 @@ BOOST_AUTO_TEST_CASE( sequence_rayfan_test ) {
     cout << endl;
 }
 
+/**
+ * Compare the results of the find_index() and find_index_stateless()
+ * methods to a brute force search for queries that jump randomly
+ * around the axis.  Tests increasing and decreasing seq_data,
+ * seq_rayfan, and seq_log sequences, with and without the lookup
+ * table acceleration.
+ */
+static void check_search( seq_vector& seq, int num_queries ) {
+    const double first = seq(0) ;
+    const double last = seq(seq.size()-1) ;
+    const double sign = ( last > first ) ? 1.0 : -1.0 ;
+    for ( int n=0 ; n < num_queries ; ++n ) {
+        double value = first + (last-first) * ( 1.2 * randgen::uniform() - 0.1 ) ;
+        if ( n % 10 == 0 ) value = seq( n % seq.size() ) ;   // on element
+        seq_vector::size_type truth = 0 ;
+        for ( seq_vector::size_type i=0 ; i < seq.size()-1 ; ++i ) {
+            if ( seq(i)*sign <= value*sign ) truth = i ;
+        }
+        BOOST_CHECK_EQUAL( seq.find_index_stateless(value), truth ) ;
+        BOOST_CHECK_EQUAL( seq.find_index(value), truth ) ;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( sequence_search_test ) {
+
+    cout << "=== sequence_test: sequence_search_test ===" << endl;
+
+    const int N = 200 ;
+    double up[N], down[N] ;
+    up[0] = 0.0 ;
+    for ( int n=1 ; n < N ; ++n ) {
+        up[n] = up[n-1] + 0.01 + randgen::uniform() * n ;
+    }
+    for ( int n=0 ; n < N ; ++n ) {
+        down[n] = -up[n] ;
+    }
+
+    seq_data increasing( up, N ) ;
+    check_search( increasing, 1000 ) ;
+    increasing.lookup_table( 32 ) ;
+    check_search( increasing, 1000 ) ;
+
+    seq_data decreasing( down, N ) ;
+    check_search( decreasing, 1000 ) ;
+    decreasing.lookup_table( 7 ) ;
+    check_search( decreasing, 1000 ) ;
+
+    seq_data* copy = (seq_data*) increasing.clone() ;
+    check_search( *copy, 100 ) ;
+    delete copy ;
+
+    seq_rayfan rayfan( -90.0, 90.0, 91, 10.0 ) ;
+    check_search( rayfan, 1000 ) ;
+    rayfan.lookup_table( 180 ) ;
+    check_search( rayfan, 1000 ) ;
+
+    seq_log log( 10.0, std::pow(2.0,1.0/3.0), 30 ) ;
+    check_search( log, 1000 ) ;
+
+    seq_linear linear( 5.0, -0.5, 40 ) ;
+    check_search( linear, 1000 ) ;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -43,5 +43,7 @@
 #include <usml/types/data_grid.h>
 #include <usml/types/data_grid_bathy.h>
 #include <usml/types/data_grid_svp.h>
+#include <usml/types/data_grid_unrolled.h>
+#include <usml/types/data_grid_compact.h>
 
 #endif
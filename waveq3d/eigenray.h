@@ -6,6 +6,7 @@
 #define USML_WAVEQ3D_EIGENRAY_H
 
 #include <usml/types/types.h>
+#include <usml/waveq3d/eigenray_arena.h>
 #include <list>
 
 namespace usml {
@@ -18,6 +19,13 @@ using boost::numeric::ublas::vector;
 /// @ingroup waveq3d
 /// @{
 
+/**
+ * Storage for the frequency dependent terms of an eigenray.
+ * Memory is obtained from the eigenray_arena, instead of the heap.
+ */
+typedef vector< double, boost::numeric::ublas::unbounded_array<
+    double, eigenray_allocator<double> > > eigenray_vector ;
+
 /**
  * A single acoustic path between a source and target.
  */
@@ -36,12 +44,12 @@ struct eigenray {
     /** 
      * Propagation loss as a function of frequency (dB,positive).
      */
-    vector< double > intensity ;
+    eigenray_vector intensity ;
 
     /** 
      * Phase change as a function of frequency (radians).
      */
-    vector< double > phase ;
+    eigenray_vector phase ;
 
     /** 
      * Initial depression/elevation angle at the 
@@ -85,8 +93,9 @@ struct eigenray {
 
 /**
  * List of acoustic paths between a source and target.
+ * List nodes are obtained from the eigenray_arena, instead of the heap.
  */
-typedef std::list< eigenray > eigenray_list ;
+typedef std::list< eigenray, eigenray_allocator<eigenray> > eigenray_list ;
 
 /// @}
 }  // end of namespace waveq3d
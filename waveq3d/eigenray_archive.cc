@@ -0,0 +1,402 @@
+/**
+ * @file eigenray_archive.cc
+ * Compact binary storage for the eigenrays of a propagation loss run.
+ */
+#include <usml/waveq3d/eigenray_archive.h>
+#include <usml/waveq3d/proploss.h>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+using namespace usml::waveq3d ;
+using boost::uint64_t ;
+using boost::uint32_t ;
+using boost::int32_t ;
+
+static const char ARCHIVE_MAGIC[8] = { 'U','S','M','L','E','R','A','Y' } ;
+static const uint32_t ARCHIVE_VERSION = 1 ;
+
+/**
+ * Round a byte count up to the next 8 byte boundary.
+ */
+static inline uint64_t align8( uint64_t n ) {
+    return ( n + 7 ) & ~((uint64_t) 7) ;
+}
+
+/**
+ * True if a block of count values, each elem bytes long, starting
+ * at offset, fits inside a file of the given size.
+ */
+static inline bool in_file( uint64_t offset, uint64_t count,
+                            uint64_t elem, uint64_t size )
+{
+    return offset <= size && count <= ( size - offset ) / elem ;
+}
+
+/**
+ * Write a block of values and pad it to the next 8 byte boundary.
+ */
+template<class T> static void write_block(
+    std::ofstream& os, const std::vector<T>& block )
+{
+    static const char pad[8] = { 0 } ;
+    const uint64_t bytes = block.size() * sizeof(T) ;
+    if ( bytes ) {
+        os.write( (const char*) &block[0], bytes ) ;
+    }
+    os.write( pad, align8(bytes) - bytes ) ;
+}
+
+/**
+ * Gather all real valued fields into contiguous blocks and write them.
+ */
+template<class REAL> static void write_reals(
+    std::ofstream& os, proploss& loss, uint64_t records )
+{
+    const unsigned num_freqs = loss.frequencies()->size() ;
+    std::vector<REAL> time, source_de, source_az, target_de, target_az ;
+    std::vector<REAL> intensity, phase ;
+    time.reserve( records ) ;
+    source_de.reserve( records ) ;
+    source_az.reserve( records ) ;
+    target_de.reserve( records ) ;
+    target_az.reserve( records ) ;
+    intensity.reserve( records * num_freqs ) ;
+    phase.reserve( records * num_freqs ) ;
+
+    for ( unsigned t1=0 ; t1 < loss.size1() ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < loss.size2() ; ++t2 ) {
+            const eigenray_list* list = loss.eigenrays(t1,t2) ;
+            eigenray_list::const_iterator iter = list->begin() ;
+            for ( int n = -1 ; n < (int) list->size() ; ++n ) {
+                const eigenray& ray = ( n < 0 ) ? *loss.total(t1,t2) : *iter++ ;
+                time.push_back( (REAL) ray.time ) ;
+                source_de.push_back( (REAL) ray.source_de ) ;
+                source_az.push_back( (REAL) ray.source_az ) ;
+                target_de.push_back( (REAL) ray.target_de ) ;
+                target_az.push_back( (REAL) ray.target_az ) ;
+                for ( unsigned f=0 ; f < num_freqs ; ++f ) {
+                    intensity.push_back( (REAL) ray.intensity(f) ) ;
+                    phase.push_back( (REAL) ray.phase(f) ) ;
+                }
+            }
+        }
+    }
+
+    write_block( os, time ) ;
+    write_block( os, intensity ) ;
+    write_block( os, phase ) ;
+    write_block( os, source_de ) ;
+    write_block( os, source_az ) ;
+    write_block( os, target_de ) ;
+    write_block( os, target_az ) ;
+}
+
+/**
+ * Write the eigenrays and summed propagation loss to an archive file.
+ */
+void eigenray_archive::write( const char* filename, proploss& loss,
+                              bool single )
+{
+    const uint64_t rows = loss.size1() ;
+    const uint64_t cols = loss.size2() ;
+    const uint64_t num_freqs = loss.frequencies()->size() ;
+
+    // build the record index for each target
+
+    std::vector<uint64_t> index( rows * cols + 1 ) ;
+    uint64_t records = 0 ;
+    for ( unsigned t1=0 ; t1 < rows ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < cols ; ++t2 ) {
+            index[ t1 * cols + t2 ] = records ;
+            records += 1 + loss.eigenrays(t1,t2)->size() ;
+        }
+    }
+    index[ rows * cols ] = records ;
+
+    // compute the location of each block
+
+    header_type header ;
+    std::memset( &header, 0, sizeof(header) ) ;
+    std::memcpy( header.magic, ARCHIVE_MAGIC, sizeof(header.magic) ) ;
+    header.version = ARCHIVE_VERSION ;
+    header.flags = single ? SINGLE_PRECISION : 0 ;
+    header.freqs = num_freqs ;
+    header.rows = rows ;
+    header.cols = cols ;
+    header.records = records ;
+
+    const uint64_t real_size = single ? sizeof(float) : sizeof(double) ;
+    uint64_t offset = align8( sizeof(header) )
+        + align8( index.size() * sizeof(uint64_t) )
+        + align8( num_freqs * sizeof(double) )
+        + align8( 3 * rows * cols * sizeof(double) ) ;
+    for ( unsigned n=0 ; n < NUM_FIELDS ; ++n ) {
+        header.column[n] = offset ;
+        uint64_t bytes ;
+        switch ( n ) {
+            case INTENSITY :
+            case PHASE :
+                bytes = records * num_freqs * real_size ;
+                break ;
+            case SURFACE :
+            case BOTTOM :
+            case CAUSTIC :
+                bytes = records * sizeof(int32_t) ;
+                break ;
+            default :
+                bytes = records * real_size ;
+                break ;
+        }
+        offset += align8( bytes ) ;
+    }
+
+    // write header, index, frequencies, and target positions
+
+    std::ofstream os( filename, std::ios::out | std::ios::binary ) ;
+    if ( !os ) {
+        throw std::invalid_argument("can not create eigenray archive") ;
+    }
+    std::vector<char> head( align8(sizeof(header)), 0 ) ;
+    std::memcpy( &head[0], &header, sizeof(header) ) ;
+    write_block( os, head ) ;
+    write_block( os, index ) ;
+
+    std::vector<double> block( num_freqs ) ;
+    for ( unsigned f=0 ; f < num_freqs ; ++f ) {
+        block[f] = (*loss.frequencies())(f) ;
+    }
+    write_block( os, block ) ;
+
+    block.resize( 3 * rows * cols ) ;
+    for ( unsigned t1=0 ; t1 < rows ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < cols ; ++t2 ) {
+            const unsigned n = t1 * cols + t2 ;
+            const wposition1 pos = loss.position(t1,t2) ;
+            block[n] = pos.latitude() ;
+            block[n+rows*cols] = pos.longitude() ;
+            block[n+2*rows*cols] = pos.altitude() ;
+        }
+    }
+    write_block( os, block ) ;
+
+    // write real valued fields followed by path counts
+
+    if ( single ) {
+        write_reals<float>( os, loss, records ) ;
+    } else {
+        write_reals<double>( os, loss, records ) ;
+    }
+
+    std::vector<int32_t> surface, bottom, caustic ;
+    surface.reserve( records ) ;
+    bottom.reserve( records ) ;
+    caustic.reserve( records ) ;
+    for ( unsigned t1=0 ; t1 < rows ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < cols ; ++t2 ) {
+            const eigenray_list* list = loss.eigenrays(t1,t2) ;
+            eigenray_list::const_iterator iter = list->begin() ;
+            for ( int n = -1 ; n < (int) list->size() ; ++n ) {
+                const eigenray& ray = ( n < 0 ) ? *loss.total(t1,t2) : *iter++ ;
+                surface.push_back( ray.surface ) ;
+                bottom.push_back( ray.bottom ) ;
+                caustic.push_back( ray.caustic ) ;
+            }
+        }
+    }
+    write_block( os, surface ) ;
+    write_block( os, bottom ) ;
+    write_block( os, caustic ) ;
+
+    if ( !os ) {
+        throw std::invalid_argument("can not write eigenray archive") ;
+    }
+}
+
+/**
+ * Map an existing archive file into memory.
+ */
+eigenray_archive::eigenray_archive( const char* filename ) :
+    _data( NULL ), _size( 0 ), _header( NULL ), _index( NULL ),
+    _targets( NULL ), _frequencies( NULL )
+{
+    #ifdef _WIN32
+        std::ifstream is( filename, std::ios::in | std::ios::binary ) ;
+        if ( !is ) {
+            throw std::invalid_argument("file not found") ;
+        }
+        is.seekg( 0, std::ios::end ) ;
+        _size = is.tellg() ;
+        is.seekg( 0, std::ios::beg ) ;
+        char* buffer = new char[ _size ] ;
+        is.read( buffer, _size ) ;
+        _data = buffer ;
+    #else
+        const int fd = open( filename, O_RDONLY ) ;
+        if ( fd < 0 ) {
+            throw std::invalid_argument("file not found") ;
+        }
+        struct stat info ;
+        if ( fstat( fd, &info ) != 0 ) {
+            close( fd ) ;
+            throw std::invalid_argument("can not read eigenray archive") ;
+        }
+        _size = info.st_size ;
+        void* map = ( _size > 0 )
+            ? mmap( NULL, _size, PROT_READ, MAP_SHARED, fd, 0 )
+            : MAP_FAILED ;
+        close( fd ) ;
+        if ( map == MAP_FAILED ) {
+            throw std::invalid_argument("can not map eigenray archive") ;
+        }
+        _data = (const char*) map ;
+    #endif
+
+    // validate header and locate the fixed size sections
+
+    _header = (const header_type*) _data ;
+    if ( _size < sizeof(header_type)
+         || std::memcmp( _header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC) )
+         || _header->version != ARCHIVE_VERSION )
+    {
+        unmap() ;
+        throw std::invalid_argument("unrecognized file type") ;
+    }
+
+    // every section must lie inside the file
+
+    const uint64_t rows = _header->rows ;
+    const uint64_t cols = _header->cols ;
+    const uint64_t records = _header->records ;
+    const uint64_t num_freqs = _header->freqs ;
+    const uint64_t real_size = single_precision() ? sizeof(float) : sizeof(double) ;
+    if ( rows > _size || cols > _size || records > _size || num_freqs > _size
+         || ( rows && cols > _size / rows ) )
+    {
+        unmap() ;
+        throw std::invalid_argument("truncated eigenray archive") ;
+    }
+    const uint64_t num_targets = rows * cols ;
+    uint64_t offset = align8( sizeof(header_type) ) ;
+    bool valid = in_file( offset, num_targets + 1, sizeof(uint64_t), _size ) ;
+    _index = (const uint64_t*) ( _data + offset ) ;
+    if ( valid ) {
+        offset += align8( ( num_targets + 1 ) * sizeof(uint64_t) ) ;
+        valid = in_file( offset, num_freqs, sizeof(double), _size ) ;
+    }
+    const double* freq = (const double*) ( _data + offset ) ;
+    if ( valid ) {
+        offset += align8( num_freqs * sizeof(double) ) ;
+        valid = in_file( offset, 3 * num_targets, sizeof(double), _size ) ;
+    }
+    _targets = (const double*) ( _data + offset ) ;
+    for ( unsigned n=0 ; valid && n < NUM_FIELDS ; ++n ) {
+        switch ( n ) {
+            case INTENSITY :
+            case PHASE :
+                valid = num_freqs == 0 || records <= _size / num_freqs ;
+                valid = valid && in_file( _header->column[n],
+                    records * num_freqs, real_size, _size ) ;
+                break ;
+            case SURFACE :
+            case BOTTOM :
+            case CAUSTIC :
+                valid = in_file( _header->column[n], records,
+                    sizeof(int32_t), _size ) ;
+                break ;
+            default :
+                valid = in_file( _header->column[n], records, real_size, _size ) ;
+                break ;
+        }
+    }
+
+    // each target has its summed loss record, followed by its eigenrays
+
+    for ( uint64_t n=0 ; valid && n < num_targets ; ++n ) {
+        valid = _index[n] < _index[n+1] ;
+    }
+    if ( ! valid || _index[0] != 0 || _index[num_targets] != records ) {
+        unmap() ;
+        throw std::invalid_argument("truncated eigenray archive") ;
+    }
+    try {
+        _frequencies = new seq_data( freq, (unsigned) num_freqs ) ;
+    } catch (...) {
+        unmap() ;
+        throw ;
+    }
+}
+
+/**
+ * Release the memory mapped file.
+ */
+eigenray_archive::~eigenray_archive() {
+    delete _frequencies ;
+    unmap() ;
+}
+
+/**
+ * Release the memory used to store the file contents.
+ */
+void eigenray_archive::unmap() {
+    #ifdef _WIN32
+        delete[] _data ;
+    #else
+        if ( _data ) munmap( (void*) _data, _size ) ;
+    #endif
+    _data = NULL ;
+}
+
+/**
+ * Position of a single target in the grid.
+ */
+wposition1 eigenray_archive::position( unsigned t1, unsigned t2 ) const {
+    const uint64_t num_targets = _header->rows * _header->cols ;
+    const uint64_t n = t1 * _header->cols + t2 ;
+    return wposition1( _targets[n], _targets[n+num_targets],
+                       _targets[n+2*num_targets] ) ;
+}
+
+/**
+ * Extract a single record from the archive.
+ */
+void eigenray_archive::read( uint64_t record, eigenray& ray ) const {
+    const unsigned num_freqs = (unsigned) _header->freqs ;
+    ray.frequencies = _frequencies ;
+    ray.time = real( TIME, record ) ;
+    ray.source_de = real( SOURCE_DE, record ) ;
+    ray.source_az = real( SOURCE_AZ, record ) ;
+    ray.target_de = real( TARGET_DE, record ) ;
+    ray.target_az = real( TARGET_AZ, record ) ;
+    ray.intensity.resize( num_freqs ) ;
+    ray.phase.resize( num_freqs ) ;
+    for ( unsigned f=0 ; f < num_freqs ; ++f ) {
+        ray.intensity(f) = real( INTENSITY, record * num_freqs + f ) ;
+        ray.phase(f) = real( PHASE, record * num_freqs + f ) ;
+    }
+    ray.surface = ((const int32_t*) column(SURFACE))[record] ;
+    ray.bottom = ((const int32_t*) column(BOTTOM))[record] ;
+    ray.caustic = ((const int32_t*) column(CAUSTIC))[record] ;
+}
+
+/**
+ * Extract the eigenrays for a single target.
+ */
+void eigenray_archive::eigenrays(
+    unsigned t1, unsigned t2, eigenray_list& list ) const
+{
+    list.clear() ;
+    const uint64_t first = index(t1,t2) + 1 ;
+    const uint64_t last = first + num_eigenrays(t1,t2) ;
+    for ( uint64_t n = first ; n < last ; ++n ) {
+        list.push_back( eigenray() ) ;
+        read( n, list.back() ) ;
+    }
+}
@@ -0,0 +1,251 @@
+/**
+ * @file eigenray_archive.h
+ * Compact binary storage for the eigenrays of a propagation loss run.
+ */
+#ifndef USML_WAVEQ3D_EIGENRAY_ARCHIVE_H
+#define USML_WAVEQ3D_EIGENRAY_ARCHIVE_H
+
+#include <usml/waveq3d/eigenray.h>
+#include <boost/cstdint.hpp>
+
+namespace usml {
+namespace waveq3d {
+
+class proploss ;
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Compact binary storage for the eigenrays of a propagation loss run.
+ * The NetCDF output of proploss::write_netcdf() is self-describing, but
+ * it writes each eigenray one element at a time, and it is slow to read
+ * back when the number of eigenrays gets large.  This archive format
+ * trades self-description for speed.  Each eigenray field is stored as a
+ * contiguous block of values (columnar storage), and a 64-bit index
+ * gives the location of the first record for each target.  Readers map
+ * the file into memory, so that the eigenrays for one target can be
+ * extracted without scanning the rest of the file.
+ *
+ * The file layout, in native byte order, is:
+ *
+ * - header
+ *   - magic number "USMLERAY" (8 bytes)
+ *   - format version (uint32) and flags (uint32)
+ *   - number of frequencies, rows, columns, and records (uint64)
+ *   - byte offset of each column block, in field order (uint64)
+ * - record index for each target, in row major order,
+ *   plus one final entry equal to the number of records (uint64)
+ * - frequencies (double)
+ * - target latitude, longitude, and altitude (double)
+ * - one block for each field: time, intensity, phase, source_de,
+ *   source_az, target_de, target_az, surface, bottom, caustic.
+ *
+ * Like the NetCDF ragged array format, the first record for each target
+ * is the propagation loss summed over all eigenrays, and the individual
+ * eigenrays immediately follow it.  The intensity and phase blocks store
+ * all frequencies for each record together.  Real valued fields are stored
+ * as either double or float (see SINGLE_PRECISION flag).  Path counts
+ * are stored as int32.  Each block starts on an 8 byte boundary.
+ *
+ * Block compression is not supported.  Memory mapped reads of uncompressed
+ * columns are already limited by disk bandwidth, and the single precision
+ * option halves the size of the real valued fields.
+ */
+class USML_DECLSPEC eigenray_archive {
+
+public:
+
+    /** Fields stored in the archive, in the order of their blocks. */
+    typedef enum {
+        TIME, INTENSITY, PHASE,
+        SOURCE_DE, SOURCE_AZ, TARGET_DE, TARGET_AZ,
+        SURFACE, BOTTOM, CAUSTIC,
+        NUM_FIELDS
+    } field_type ;
+
+    /** Flag that indicates that real values are stored as float. */
+    static const boost::uint32_t SINGLE_PRECISION = 0x1 ;
+
+    /**
+     * Write the eigenrays and summed propagation loss for each target
+     * to an archive file.  The user is responsible for ensuring that
+     * sum_eigenrays() has been called prior to this routine.
+     *
+     * @param   filename    Name of the file to write to disk.
+     * @param   loss        Propagation loss and eigenrays to write.
+     * @param   single      Store real values as float, if true.
+     * @throws  std::invalid_argument if file can not be written.
+     */
+    static void write( const char* filename, proploss& loss,
+                       bool single = false ) ;
+
+    /**
+     * Map an existing archive file into memory.
+     *
+     * @param   filename    Name of the archive file to read.
+     * @throws  std::invalid_argument if file is not a valid archive.
+     */
+    eigenray_archive( const char* filename ) ;
+
+    /** Release the memory mapped file. */
+    ~eigenray_archive() ;
+
+    /** Number of rows in target grid. */
+    inline unsigned size1() const {
+        return (unsigned) _header->rows ;
+    }
+
+    /** Number of columns in target grid. */
+    inline unsigned size2() const {
+        return (unsigned) _header->cols ;
+    }
+
+    /** Total number of records, including the summed loss records. */
+    inline boost::uint64_t num_records() const {
+        return _header->records ;
+    }
+
+    /** True if real values are stored as float instead of double. */
+    inline bool single_precision() const {
+        return ( _header->flags & SINGLE_PRECISION ) != 0 ;
+    }
+
+    /** Frequencies over which propagation was computed (Hz). */
+    inline const seq_vector* frequencies() const {
+        return _frequencies ;
+    }
+
+    /**
+     * Position of a single target in the grid.
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     */
+    wposition1 position( unsigned t1, unsigned t2 ) const ;
+
+    /**
+     * Record number of the summed propagation loss for a single target.
+     * The eigenrays for this target follow in the next num_eigenrays()
+     * records.
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     */
+    inline boost::uint64_t index( unsigned t1, unsigned t2 ) const {
+        return _index[ t1 * _header->cols + t2 ] ;
+    }
+
+    /**
+     * Number of eigenrays for a single target.
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     */
+    inline unsigned num_eigenrays( unsigned t1, unsigned t2 ) const {
+        const unsigned n = t1 * _header->cols + t2 ;
+        return (unsigned) ( _index[n+1] - _index[n] - 1 ) ;
+    }
+
+    /**
+     * Raw access to the block of values for a single field.  Values are
+     * float or double, as given by single_precision(), for real valued
+     * fields, and int32 for the path counts.  Intensity and phase have
+     * frequencies()->size() values for each record.  Intended for bulk
+     * post-processing that wants to avoid building eigenray objects.
+     *
+     * @param   field       Field to retrieve.
+     * @return              Pointer into the memory mapped file.
+     */
+    inline const void* column( field_type field ) const {
+        return _data + _header->column[field] ;
+    }
+
+    /**
+     * Extract a single record from the archive.
+     *
+     * @param   record      Record number.
+     * @param   ray         Eigenray to fill with data from this record.
+     */
+    void read( boost::uint64_t record, eigenray& ray ) const ;
+
+    /**
+     * Propagation loss for a single target summed over eigenrays.
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     * @param   ray         Eigenray to fill with the summed loss.
+     */
+    inline void total( unsigned t1, unsigned t2, eigenray& ray ) const {
+        read( index(t1,t2), ray ) ;
+    }
+
+    /**
+     * Extract the eigenrays for a single target.  Only the records for
+     * this target are touched.
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     * @param   list        List to fill with eigenrays (output).
+     */
+    void eigenrays( unsigned t1, unsigned t2, eigenray_list& list ) const ;
+
+private:
+
+    /** Fixed size header at the start of each archive file. */
+    struct header_type {
+        char magic[8] ;
+        boost::uint32_t version ;
+        boost::uint32_t flags ;
+        boost::uint64_t freqs ;
+        boost::uint64_t rows ;
+        boost::uint64_t cols ;
+        boost::uint64_t records ;
+        boost::uint64_t column[NUM_FIELDS] ;
+    } ;
+
+    /** Start of the file contents in memory. */
+    const char* _data ;
+
+    /** Size of the file in bytes. */
+    boost::uint64_t _size ;
+
+    /** Header at the start of the file. */
+    const header_type* _header ;
+
+    /** First record for each target, plus number of records. */
+    const boost::uint64_t* _index ;
+
+    /** Target latitudes, longitudes, and altitudes, in that order. */
+    const double* _targets ;
+
+    /** Frequencies over which propagation was computed (Hz). */
+    seq_vector* _frequencies ;
+
+    /**
+     * Read a real valued field as a double.
+     *
+     * @param   field       Field to retrieve.
+     * @param   n           Offset into this block, in values.
+     */
+    inline double real( field_type field, boost::uint64_t n ) const {
+        if ( single_precision() ) {
+            return ((const float*) column(field))[n] ;
+        }
+        return ((const double*) column(field))[n] ;
+    }
+
+    /** Release the memory used to store the file contents. */
+    void unmap() ;
+
+    // prevent copies of the memory map
+
+    eigenray_archive( const eigenray_archive& ) ;
+    eigenray_archive& operator=( const eigenray_archive& ) ;
+} ;
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
+
+#endif
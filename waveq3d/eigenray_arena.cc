@@ -0,0 +1,184 @@
+/**
+ * @file eigenray_arena.cc
+ * Memory pool for the storage of eigenrays.
+ */
+#include <usml/waveq3d/eigenray_arena.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <vector>
+#include <new>
+
+using namespace usml::waveq3d ;
+
+namespace {
+
+/** Unit of allocation, also used to align each block. */
+const size_t WORD = sizeof(double) ;
+
+/** Number of block sizes managed by the pool, in words. */
+const size_t NUM_SIZES = eigenray_arena::MAX_BLOCK / WORD + 1 ;
+
+/** Released block, linked into the free list for its size. */
+struct free_block {
+    free_block* next ;
+} ;
+
+/**
+ * Free lists owned by a single thread.  Blocks move between this cache
+ * and the shared pool in batches of one chunk's worth of blocks,
+ * so the shared mutex is only locked once per batch.
+ */
+struct thread_cache {
+    std::vector< free_block* > free ;   // free list for each size in words
+    std::vector< size_t > count ;       // length of each free list
+
+    thread_cache() : free( NUM_SIZES, NULL ), count( NUM_SIZES, 0 ) {}
+} ;
+
+void release_cache( thread_cache* cache ) ;
+
+/**
+ * Shared state of the pool.  Created on first use, so that eigenrays can
+ * be safely constructed during static initialization.  Never destroyed,
+ * so that eigenrays can also be safely destroyed during program exit.
+ */
+struct arena_state {
+    boost::mutex mutex ;
+    std::vector< free_block* > free ;   // free list for each size in words
+    size_t reserved ;
+    boost::thread_specific_ptr< thread_cache > cache ;
+
+    arena_state() : free( NUM_SIZES, NULL ), reserved( 0 ),
+                    cache( &release_cache ) {}
+} ;
+
+arena_state& state() {
+    static arena_state* instance = new arena_state ;
+    return *instance ;
+}
+
+/** Number of blocks of a specific size in each batch. */
+inline size_t batch_size( size_t words ) {
+    const size_t block = words * WORD ;
+    return ( eigenray_arena::CHUNK_SIZE + block - 1 ) / block ;
+}
+
+/** Free lists for the calling thread, created on first use. */
+inline thread_cache& local_cache( arena_state& pool ) {
+    thread_cache* cache = pool.cache.get() ;
+    if ( cache == NULL ) {
+        cache = new thread_cache ;
+        pool.cache.reset( cache ) ;
+    }
+    return *cache ;
+}
+
+/**
+ * Return all of the blocks in a thread's cache to the shared pool
+ * when that thread exits, so that other threads can re-use them.
+ */
+void release_cache( thread_cache* cache ) {
+    arena_state& pool = state() ;
+    {
+        boost::mutex::scoped_lock lock( pool.mutex ) ;
+        for ( size_t words=1 ; words < NUM_SIZES ; ++words ) {
+            while ( cache->free[words] != NULL ) {
+                free_block* ptr = cache->free[words] ;
+                cache->free[words] = ptr->next ;
+                ptr->next = pool.free[words] ;
+                pool.free[words] = ptr ;
+            }
+        }
+    }
+    delete cache ;
+}
+
+}
+
+/**
+ * Allocate a block of memory.
+ */
+void* eigenray_arena::allocate( size_t bytes ) {
+    if ( bytes == 0 ) return NULL ;
+    if ( bytes > MAX_BLOCK ) return ::operator new( bytes ) ;
+
+    const size_t words = ( bytes + WORD - 1 ) / WORD ;
+    arena_state& pool = state() ;
+    thread_cache& cache = local_cache( pool ) ;
+    free_block*& head = cache.free[words] ;
+
+    // refill an empty cache with a batch of blocks from the shared pool,
+    // or carve a new chunk into blocks of this size if the pool is empty
+
+    if ( head == NULL ) {
+        const size_t count = batch_size( words ) ;
+        boost::mutex::scoped_lock lock( pool.mutex ) ;
+        free_block*& shared = pool.free[words] ;
+        if ( shared == NULL ) {
+            const size_t block = words * WORD ;
+            char* chunk = (char*) ::operator new( count * block ) ;
+            pool.reserved += count * block ;
+            for ( size_t n=0 ; n < count ; ++n ) {
+                free_block* ptr = (free_block*) ( chunk + n * block ) ;
+                ptr->next = head ;
+                head = ptr ;
+            }
+            cache.count[words] = count ;
+        } else {
+            while ( shared != NULL && cache.count[words] < count ) {
+                free_block* ptr = shared ;
+                shared = ptr->next ;
+                ptr->next = head ;
+                head = ptr ;
+                ++cache.count[words] ;
+            }
+        }
+    }
+    free_block* ptr = head ;
+    head = ptr->next ;
+    --cache.count[words] ;
+    return ptr ;
+}
+
+/**
+ * Return a block of memory to the pool.
+ */
+void eigenray_arena::deallocate( void* ptr, size_t bytes ) {
+    if ( ptr == NULL || bytes == 0 ) return ;
+    if ( bytes > MAX_BLOCK ) {
+        ::operator delete( ptr ) ;
+        return ;
+    }
+    const size_t words = ( bytes + WORD - 1 ) / WORD ;
+    arena_state& pool = state() ;
+    thread_cache& cache = local_cache( pool ) ;
+    free_block*& head = cache.free[words] ;
+    free_block* block = (free_block*) ptr ;
+    block->next = head ;
+    head = block ;
+
+    // return a batch of blocks to the shared pool if this thread
+    // is holding more than two batches of this size
+
+    const size_t count = batch_size( words ) ;
+    if ( ++cache.count[words] > 2 * count ) {
+        boost::mutex::scoped_lock lock( pool.mutex ) ;
+        free_block*& shared = pool.free[words] ;
+        for ( size_t n=0 ; n < count ; ++n ) {
+            free_block* extra = head ;
+            head = extra->next ;
+            extra->next = shared ;
+            shared = extra ;
+        }
+        cache.count[words] -= count ;
+    }
+}
+
+/**
+ * Total number of bytes that the pool has obtained from the heap.
+ */
+size_t eigenray_arena::reserved() {
+    arena_state& pool = state() ;
+    boost::mutex::scoped_lock lock( pool.mutex ) ;
+    return pool.reserved ;
+}
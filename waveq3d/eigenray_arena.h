@@ -0,0 +1,136 @@
+/**
+ * @file eigenray_arena.h
+ * Memory pool for the storage of eigenrays.
+ */
+#ifndef USML_WAVEQ3D_EIGENRAY_ARENA_H
+#define USML_WAVEQ3D_EIGENRAY_ARENA_H
+
+#include <usml/usml_config.h>
+#include <memory>
+#include <cstddef>
+
+namespace usml {
+namespace waveq3d {
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Memory pool for the storage of eigenrays.  Broadband runs can produce
+ * millions of eigenrays, and each one allocates its own intensity and
+ * phase vectors, along with a list node in its eigenray_list.  This pool
+ * carves fixed size blocks out of large chunks of memory, and keeps a
+ * separate free list for each block size.  Blocks that are released are
+ * recycled by the next request of the same size, so once the pool has
+ * warmed up, eigenray production and storage no longer call the heap.
+ *
+ * Implemented as a singleton, so that eigenrays can be copied freely
+ * between lists that were created in different parts of the application.
+ * Because all of the methods are declared static, the developer
+ * never actually creates a class of this type.  Chunks are kept until
+ * the program exits, so that they can be re-used by the next propagation
+ * run.  Requests larger than MAX_BLOCK bytes bypass the pool.
+ *
+ * All methods are thread safe.  Each thread allocates from, and releases
+ * to, its own free lists without locking.  Blocks only move between
+ * a thread and the shared pool in batches of about CHUNK_SIZE bytes,
+ * when a thread's list for that size runs empty, or grows beyond two
+ * batches.  The blocks held by a thread are returned to the shared pool
+ * when that thread exits.
+ */
+class USML_DECLSPEC eigenray_arena {
+
+public:
+
+    /** Largest block, in bytes, that is managed by the pool. */
+    static const size_t MAX_BLOCK = 32768 ;
+
+    /**
+     * Minimum number of bytes allocated from the heap for each chunk.
+     * Also the size of each batch moved between a thread and the pool.
+     */
+    static const size_t CHUNK_SIZE = 262144 ;
+
+    /**
+     * Allocate a block of memory.
+     *
+     * @param   bytes       Size of the block. Returns NULL if zero.
+     * @return              Memory aligned for storage of doubles.
+     */
+    static void* allocate( size_t bytes ) ;
+
+    /**
+     * Return a block of memory to the pool.
+     *
+     * @param   ptr         Block returned by allocate(). Ignored if NULL.
+     * @param   bytes       Size that was given to allocate().
+     */
+    static void deallocate( void* ptr, size_t bytes ) ;
+
+    /** Total number of bytes that the pool has obtained from the heap. */
+    static size_t reserved() ;
+} ;
+
+/**
+ * Standard allocator that obtains its memory from the eigenray_arena.
+ * Used for the intensity and phase vectors of each eigenray, and for
+ * the nodes of each eigenray_list.  The allocator has no state, so all
+ * instances are interchangeable.
+ *
+ * @param  T            Type of object being allocated.
+ */
+template<class T> class eigenray_allocator : public std::allocator<T> {
+
+public:
+
+    typedef size_t size_type ;
+    typedef ptrdiff_t difference_type ;
+    typedef T* pointer ;
+    typedef const T* const_pointer ;
+    typedef T& reference ;
+    typedef const T& const_reference ;
+    typedef T value_type ;
+
+    /** Allocator for another type of object. */
+    template<class U> struct rebind {
+        typedef eigenray_allocator<U> other ;
+    } ;
+
+    eigenray_allocator() throw() {}
+
+    eigenray_allocator( const eigenray_allocator& ) throw()
+        : std::allocator<T>() {}
+
+    template<class U> eigenray_allocator( const eigenray_allocator<U>& ) throw()
+        {}
+
+    /** Allocate storage for n objects from the eigenray_arena. */
+    pointer allocate( size_type n, const void* = 0 ) {
+        return (pointer) eigenray_arena::allocate( n * sizeof(T) ) ;
+    }
+
+    /** Return storage for n objects to the eigenray_arena. */
+    void deallocate( pointer ptr, size_type n ) {
+        eigenray_arena::deallocate( ptr, n * sizeof(T) ) ;
+    }
+} ;
+
+/** All eigenray_allocators are interchangeable. */
+template<class T, class U> inline bool operator==(
+    const eigenray_allocator<T>&, const eigenray_allocator<U>& )
+{
+    return true ;
+}
+
+/** All eigenray_allocators are interchangeable. */
+template<class T, class U> inline bool operator!=(
+    const eigenray_allocator<T>&, const eigenray_allocator<U>& )
+{
+    return false ;
+}
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
+
+#endif
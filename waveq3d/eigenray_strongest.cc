@@ -0,0 +1,155 @@
+/**
+ * @file eigenray_strongest.cc
+ * Retains a fixed number of the strongest eigenrays for each target.
+ */
+#include <usml/waveq3d/eigenray_strongest.h>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace usml::waveq3d ;
+
+namespace {
+
+/**
+ * Orders slot numbers by their propagation loss, so that the heap root
+ * is the weakest eigenray, and a sorted heap is strongest first.
+ */
+class loss_order {
+    const std::vector<double>& _loss ;
+public:
+    loss_order( const std::vector<double>& loss ) : _loss( loss ) {}
+    bool operator()( unsigned a, unsigned b ) const {
+        return _loss[a] < _loss[b] ;
+    }
+} ;
+
+}
+
+/**
+ * Allocate storage for the strongest eigenrays of each target.
+ */
+eigenray_strongest::eigenray_strongest(
+    const wposition* targets, unsigned capacity, strength_type strength
+) :
+    _size1( targets->size1() ),
+    _size2( targets->size2() ),
+    _capacity( capacity ),
+    _strength( strength ),
+    _rays( targets->size1() * targets->size2() * capacity ),
+    _loss( _rays.size(), 0.0 ),
+    _heap( _rays.size(), 0 ),
+    _count( targets->size1() * targets->size2(), 0 )
+{
+    if ( capacity == 0 ) {
+        throw std::invalid_argument("eigenray capacity must be positive") ;
+    }
+}
+
+/**
+ * Strength of an eigenray, expressed as propagation loss.
+ */
+double eigenray_strongest::strength( const eigenray& ray ) const {
+    if ( _strength == FIRST_FREQUENCY || ray.intensity.size() < 2 ) {
+        return ray.intensity(0) ;
+    }
+    double power = 0.0 ;
+    for ( unsigned f=0 ; f < ray.intensity.size() ; ++f ) {
+        power += pow( 10.0, -ray.intensity(f) / 10.0 ) ;
+    }
+    return -10.0 * log10( power / ray.intensity.size() ) ;
+}
+
+/**
+ * Offer a new eigenray for a target.
+ */
+bool eigenray_strongest::addEigenray(
+    unsigned targetRow, unsigned targetCol, eigenray pRay )
+{
+    return add( targetRow * _size2 + targetCol, pRay ) ;
+}
+
+/**
+ * Offer a batch of eigenrays, for any number of targets.
+ */
+bool eigenray_strongest::addEigenrays(
+    const target_eigenray* rays, unsigned count )
+{
+    bool result = true ;
+    for ( unsigned n=0 ; n < count ; ++n ) {
+        result = add( rays[n].row * _size2 + rays[n].col, rays[n].ray )
+            && result ;
+    }
+    return result ;
+}
+
+/**
+ * Offer a new eigenray for a target.
+ */
+bool eigenray_strongest::add( unsigned target, const eigenray& ray ) {
+    const double loss = strength( ray ) ;
+    std::vector<unsigned>::iterator first = _heap.begin() + target * _capacity ;
+    unsigned& count = _count[target] ;
+    unsigned slot ;
+
+    if ( count < _capacity ) {          // use the next free slot
+        slot = target * _capacity + count ;
+        first[count++] = slot ;
+    } else {                            // replace the weakest eigenray
+        if ( loss >= _loss[ first[0] ] ) return false ;
+        std::pop_heap( first, first + count, loss_order(_loss) ) ;
+        slot = first[count-1] ;
+    }
+    _rays[slot] = ray ;
+    _loss[slot] = loss ;
+    std::push_heap( first, first + count, loss_order(_loss) ) ;
+    return true ;
+}
+
+/**
+ * Slot numbers for a single target in strongest first order.
+ */
+void eigenray_strongest::sorted(
+    unsigned target, std::vector<unsigned>& order ) const
+{
+    std::vector<unsigned>::const_iterator first =
+        _heap.begin() + target * _capacity ;
+    order.assign( first, first + _count[target] ) ;
+    std::sort_heap( order.begin(), order.end(), loss_order(_loss) ) ;
+}
+
+/**
+ * Extract the retained eigenrays for a single target.
+ */
+void eigenray_strongest::eigenrays(
+    unsigned t1, unsigned t2, eigenray_list& list ) const
+{
+    list.clear() ;
+    std::vector<unsigned> order ;
+    sorted( t1 * _size2 + t2, order ) ;
+    for ( unsigned n=0 ; n < order.size() ; ++n ) {
+        list.push_back( _rays[ order[n] ] ) ;
+    }
+}
+
+/**
+ * Send the retained eigenrays for all targets to another listener.
+ */
+void eigenray_strongest::forward( proplossListener* listener ) const {
+    std::vector<unsigned> order ;
+    order.reserve( _capacity ) ;
+    for ( unsigned t1=0 ; t1 < _size1 ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < _size2 ; ++t2 ) {
+            sorted( t1 * _size2 + t2, order ) ;
+            for ( unsigned n=0 ; n < order.size() ; ++n ) {
+                listener->addEigenray( t1, t2, _rays[ order[n] ] ) ;
+            }
+        }
+    }
+}
+
+/**
+ * Discard all of the retained eigenrays.
+ */
+void eigenray_strongest::clear() {
+    std::fill( _count.begin(), _count.end(), 0 ) ;
+}
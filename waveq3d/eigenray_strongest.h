@@ -0,0 +1,188 @@
+/**
+ * @file eigenray_strongest.h
+ * Retains a fixed number of the strongest eigenrays for each target.
+ */
+#ifndef USML_WAVEQ3D_EIGENRAY_STRONGEST_H
+#define USML_WAVEQ3D_EIGENRAY_STRONGEST_H
+
+#include <usml/waveq3d/proplossListener.h>
+#include <vector>
+
+namespace usml {
+namespace waveq3d {
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Retains a fixed number of the strongest eigenrays for each target.
+ * The proploss class keeps every eigenray that beats the intensity
+ * threshold of the wave_queue, so its memory use grows with the length of
+ * the run, and with the multipath richness of the environment.  When only
+ * the strongest K paths to each target are of interest, this listener
+ * can be used instead, to bound memory use at K eigenrays per target.
+ *
+ * The storage for all eigenrays is allocated in the constructor, as one
+ * block of K slots for each target.  The slots for each target are
+ * organized as a heap, whose root is the weakest of the retained
+ * eigenrays.  Once a target's slots are full, a new eigenray replaces
+ * the root only if it is stronger.  Each new eigenray costs O(log K).
+ * No memory is allocated during propagation, unless the number of
+ * frequencies changes.
+ *
+ * Strength is measured by the propagation loss at the first
+ * frequency, or by the propagation loss averaged over all frequencies
+ * in linear (non-dB) space.  At the end of propagation, the retained
+ * eigenrays can be extracted in strongest first order, or forwarded
+ * to another listener, like proploss, for summation and output.
+ */
+class USML_DECLSPEC eigenray_strongest : public proplossListener {
+
+public:
+
+    /** Measure used to rank the strength of each eigenray. */
+    typedef enum {
+        FIRST_FREQUENCY,    ///< propagation loss at the first frequency
+        BAND_AVERAGE        ///< loss averaged over all frequencies
+    } strength_type ;
+
+    /**
+     * Allocate storage for the strongest eigenrays of each target.
+     *
+     * @param   targets     Grid of targets to ensonify.
+     * @param   capacity    Maximum number of eigenrays for each target.
+     * @param   strength    Measure used to rank eigenrays.
+     * @throws  std::invalid_argument if capacity is zero.
+     */
+    eigenray_strongest( const wposition* targets, unsigned capacity,
+                        strength_type strength = FIRST_FREQUENCY ) ;
+
+    /** Number of rows in target grid. */
+    inline unsigned size1() const {
+        return _size1 ;
+    }
+
+    /** Number of columns in target grid. */
+    inline unsigned size2() const {
+        return _size2 ;
+    }
+
+    /** Maximum number of eigenrays for each target. */
+    inline unsigned capacity() const {
+        return _capacity ;
+    }
+
+    /**
+     * Number of eigenrays currently retained for a single target.
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     */
+    inline unsigned size( unsigned t1, unsigned t2 ) const {
+        return _count[ t1 * _size2 + t2 ] ;
+    }
+
+    /**
+     * Offer a new eigenray for a target.  Retained if this target has
+     * free slots, or if it is stronger than the weakest retained eigenray.
+     * Implementation of the pure virtual method of proplossListener.
+     *
+     * @param   targetRow   Row number of the target.
+     * @param   targetCol   Column number of the target.
+     * @param   pRay        The eigenray to add.
+     * @return              True if the eigenray was retained.
+     */
+    virtual bool addEigenray( unsigned targetRow, unsigned targetCol,
+                              eigenray pRay ) ;
+
+    /**
+     * Offer a batch of eigenrays, for any number of targets.
+     *
+     * @param   rays        Pointer to the first eigenray in the batch.
+     * @param   count       Number of eigenrays in the batch.
+     * @return              True if all of the eigenrays were retained.
+     */
+    virtual bool addEigenrays( const target_eigenray* rays, unsigned count ) ;
+
+    /**
+     * Extract the retained eigenrays for a single target,
+     * in strongest first order.
+     *
+     * @param   t1          Row number of the target.
+     * @param   t2          Column number of the target.
+     * @param   list        List to fill with eigenrays (output).
+     */
+    void eigenrays( unsigned t1, unsigned t2, eigenray_list& list ) const ;
+
+    /**
+     * Send the retained eigenrays for all targets to another listener,
+     * in strongest first order.  Used to compute propagation loss and
+     * write results to disk using the proploss class.
+     *
+     * @param   listener    Listener to receive the eigenrays.
+     */
+    void forward( proplossListener* listener ) const ;
+
+    /** Discard all of the retained eigenrays. */
+    void clear() ;
+
+private:
+
+    /** Number of rows in target grid. */
+    const unsigned _size1 ;
+
+    /** Number of columns in target grid. */
+    const unsigned _size2 ;
+
+    /** Maximum number of eigenrays for each target. */
+    const unsigned _capacity ;
+
+    /** Measure used to rank eigenrays. */
+    const strength_type _strength ;
+
+    /** Storage for eigenrays, _capacity slots for each target. */
+    std::vector< eigenray > _rays ;
+
+    /** Propagation loss used to rank each slot (dB, smaller is stronger). */
+    std::vector< double > _loss ;
+
+    /**
+     * Heap of slot numbers for each target, ordered so that
+     * the first entry is the weakest eigenray.
+     */
+    std::vector< unsigned > _heap ;
+
+    /** Number of eigenrays retained for each target. */
+    std::vector< unsigned > _count ;
+
+    /**
+     * Strength of an eigenray, expressed as propagation loss.
+     *
+     * @param   ray         Eigenray to be ranked.
+     * @return              Propagation loss (dB, smaller is stronger).
+     */
+    double strength( const eigenray& ray ) const ;
+
+    /**
+     * Offer a new eigenray for a target.
+     *
+     * @param   target      Target number in row major order.
+     * @param   ray         The eigenray to add.
+     * @return              True if the eigenray was retained.
+     */
+    bool add( unsigned target, const eigenray& ray ) ;
+
+    /**
+     * Slot numbers for a single target in strongest first order.
+     *
+     * @param   target      Target number in row major order.
+     * @param   order       Slot numbers (output).
+     */
+    void sorted( unsigned target, std::vector<unsigned>& order ) const ;
+} ;
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
+
+#endif
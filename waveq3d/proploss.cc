@@ -3,6 +3,7 @@
  * List of targets and their associated propagation data.
  */
 #include <usml/waveq3d/proploss.h>
+#include <usml/waveq3d/eigenray_archive.h>
 #include <netcdfcpp.h>
 
 using namespace usml::waveq3d ;
@@ -28,7 +29,9 @@ proploss::proploss(
 	_time_step(time_step),
 	_eigenrays( size1(), size2() ),
 	_num_eigenrays(0),
-	_loss( size1(), size2() )
+	_loss( size1(), size2() ),
+	_streaming(false),
+	_coherent(true)
 {
 	initialize();
 }
@@ -48,10 +51,103 @@ void proploss::initialize()
     }
 }
 
+/**
+ * Accumulate propagation loss as eigenrays arrive.
+ */
+void proploss::stream_eigenrays( bool coherent ) {
+    _streaming = true ;
+    _coherent = coherent ;
+    for ( unsigned t1=0 ; t1 < _targets->size1() ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < _targets->size2() ; ++t2 ) {
+            _eigenrays(t1,t2).clear() ;
+        }
+    }
+    _num_eigenrays = 0 ;
+
+    const unsigned num_targets = size1() * size2() ;
+    _phasor.assign( num_targets * _frequencies->size(),
+                    std::complex<double>( 0.0, 0.0 ) ) ;
+    running_sum zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 } ;
+    _running.assign( num_targets, zero ) ;
+    for ( unsigned t1=0 ; t1 < _targets->size1() ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < _targets->size2() ; ++t2 ) {
+            _loss(t1,t2).surface = -1 ;
+            _loss(t1,t2).bottom = -1 ;
+            _loss(t1,t2).caustic = -1 ;
+        }
+    }
+}
+
+/**
+ * Add a single eigenray to the running sums of its target.
+ */
+void proploss::accumulate( unsigned t1, unsigned t2, const eigenray& ray ) {
+    const unsigned num_freq = _frequencies->size() ;
+    const unsigned target = t1 * size2() + t2 ;
+    std::complex<double>* phasor = &_phasor[ target * num_freq ] ;
+    running_sum& sum = _running[ target ] ;
+    eigenray& loss = _loss(t1,t2) ;
+
+    for ( unsigned f=0 ; f < num_freq ; ++f ) {
+
+        // complex pressure
+
+        const double a = pow( 10.0, ray.intensity(f) / -20.0 ) ;
+        double p = 0.0 ;
+        if  ( _coherent ) {
+            p = TWO_PI * (*_frequencies)(f) * ray.time + ray.phase(f) ;
+            p = fmod( p, TWO_PI ) ; // large phases bad for cos,sin
+        }
+        phasor[f] += std::complex<double>( a * cos(p), a * sin(p) ) ;
+
+        // other eigenray terms
+
+        sum.wgt += a ;
+        sum.time += a * ray.time ;
+        sum.source_de += a * ray.source_de ;
+        sum.source_az += a * ray.source_az ;
+        sum.target_de += a * ray.target_de ;
+        sum.target_az += a * ray.target_az ;
+        if ( a > sum.max_a ) {
+            sum.max_a = a ;
+            loss.surface = ray.surface ;
+            loss.bottom = ray.bottom ;
+            loss.caustic = ray.caustic ;
+        }
+    }
+}
+
 /**
  * Compute propagation loss summed over all eigenrays.
  */
 void proploss::sum_eigenrays( bool coherent ) {
+
+    // convert running sums into intensity (dB) and phase (radians) values
+
+    if ( _streaming ) {
+        const unsigned num_freq = _frequencies->size() ;
+        for ( unsigned t1=0 ; t1 < _targets->size1() ; ++t1 ) {
+            for ( unsigned t2=0 ; t2 < _targets->size2() ; ++t2 ) {
+                const unsigned target = t1 * size2() + t2 ;
+                const std::complex<double>* phasor =
+                    &_phasor[ target * num_freq ] ;
+                const running_sum& sum = _running[ target ] ;
+                eigenray* loss = &( _loss(t1,t2) ) ;
+                for ( unsigned f=0 ; f < num_freq ; ++f ) {
+                    loss->intensity(f) =
+                        -20.0*log10( max(1e-15,abs(phasor[f])) ) ;
+                    loss->phase(f) = arg(phasor[f]) ;
+                }
+                loss->time = sum.time / sum.wgt ;
+                loss->source_de = sum.source_de / sum.wgt ;
+                loss->source_az = sum.source_az / sum.wgt ;
+                loss->target_de = sum.target_de / sum.wgt ;
+                loss->target_az = sum.target_az / sum.wgt ;
+            }
+        }
+        return ;
+    }
+
     for ( unsigned t1=0 ; t1 < _targets->size1() ; ++t1 ) {
         for ( unsigned t2=0 ; t2 < _targets->size2() ; ++t2 ) {
             
@@ -135,11 +231,33 @@ void proploss::sum_eigenrays( bool coherent ) {
  */
 bool proploss::addEigenray( unsigned targetRow, unsigned targetCol, eigenray pRay ) {
 
+	 if ( _streaming ) {
+	     accumulate( targetRow, targetCol, pRay ) ;
+	     return true ;
+	 }
+
 	 _eigenrays(targetRow, targetCol).push_back( pRay ) ;
 	 ++_num_eigenrays ;
 	 return true;
 }
 
+/**
+ * Add a batch of eigenrays via proplossListener
+ */
+bool proploss::addEigenrays( const target_eigenray* rays, unsigned count ) {
+    if ( _streaming ) {
+        for ( unsigned n=0 ; n < count ; ++n ) {
+            accumulate( rays[n].row, rays[n].col, rays[n].ray ) ;
+        }
+        return true ;
+    }
+    for ( unsigned n=0 ; n < count ; ++n ) {
+        _eigenrays( rays[n].row, rays[n].col ).push_back( rays[n].ray ) ;
+    }
+    _num_eigenrays += count ;
+    return true ;
+}
+
 /**
  * Write proploss data to to netCDF file.
  */
@@ -175,9 +293,9 @@ void proploss::write_netcdf( const char* filename, const char* long_name )
     NcVar *longitude_var = nc_file->add_var("longitude", ncDouble, row_dim, col_dim);
     NcVar *altitude_var = nc_file->add_var("altitude", ncDouble, row_dim, col_dim);
 
-    NcVar *proploss_index_var = nc_file->add_var("proploss_index", ncShort, row_dim, col_dim);
-    NcVar *eigenray_index_var = nc_file->add_var("eigenray_index", ncShort, row_dim, col_dim);
-    NcVar *eigenray_num_var = nc_file->add_var("eigenray_num", ncShort, row_dim, col_dim);
+    NcVar *proploss_index_var = nc_file->add_var("proploss_index", ncInt, row_dim, col_dim);
+    NcVar *eigenray_index_var = nc_file->add_var("eigenray_index", ncInt, row_dim, col_dim);
+    NcVar *eigenray_num_var = nc_file->add_var("eigenray_num", ncInt, row_dim, col_dim);
 
     NcVar *intensity_var = nc_file->add_var("intensity", ncDouble, eigenray_dim, freq_dim);
     NcVar *phase_var = nc_file->add_var("phase", ncDouble, eigenray_dim, freq_dim);
@@ -237,14 +355,10 @@ void proploss::write_netcdf( const char* filename, const char* long_name )
     src_lat_var->put(&v);
     v = _source_pos.longitude();   src_lng_var->put(&v);
     v = _source_pos.altitude();    src_alt_var->put(&v);
-    for (unsigned d = 0; d < _source_de->size(); ++d) {
-        launch_de_var->set_cur(d);
-        v = (*_source_de)(d);       launch_de_var->put(&v, 1);
-    }
-    for (unsigned a = 0; a < _source_az->size(); ++a) {
-        launch_az_var->set_cur(a);
-        v = (*_source_az)(a);       launch_az_var->put(&v, 1);
-    }
+    launch_de_var->put(vector<double>(*_source_de).data().begin(),
+            _source_de->size());
+    launch_az_var->put(vector<double>(*_source_az).data().begin(),
+            _source_az->size());
     v = _time_step;
     time_step_var->put(&v);
     freq_var->put(vector<double>(*_frequencies).data().begin(),_frequencies->size());
@@ -258,80 +372,88 @@ void proploss::write_netcdf( const char* filename, const char* long_name )
     altitude_var->put(_targets->altitude().data().begin(),
             _targets->size1(), _targets->size2());
 
-    // write propagation loss and eigenrays to disk
+    // gather propagation loss and eigenrays into contiguous buffers
+    // so that each variable can be written with a single put()
+
+    const unsigned num_targets = _targets->size1() * _targets->size2();
+    const unsigned num_records = _num_eigenrays + num_targets;
+    const unsigned num_freqs = _frequencies->size();
+
+    std::vector<int> proploss_index(num_targets);
+    std::vector<int> eigenray_index(num_targets);
+    std::vector<int> eigenray_num(num_targets);
+    std::vector<double> intensity(num_records * num_freqs);
+    std::vector<double> phase(num_records * num_freqs);
+    std::vector<double> time(num_records);
+    std::vector<double> source_de(num_records);
+    std::vector<double> source_az(num_records);
+    std::vector<double> target_de(num_records);
+    std::vector<double> target_az(num_records);
+    std::vector<short> surface(num_records);
+    std::vector<short> bottom(num_records);
+    std::vector<short> caustic(num_records);
 
     int record = 0; // current record number
     for (unsigned t1 = 0; t1 < _targets->size1(); ++t1) {
         for (unsigned t2 = 0; t2 < _targets->size2(); ++t2) {
+            const unsigned t = t1 * _targets->size2() + t2;
             int num = _eigenrays(t1, t2).size();
-
-            proploss_index_var->set_cur(t1, t2);
-            eigenray_index_var->set_cur(t1, t2);
-            eigenray_num_var->set_cur(t1, t2);
-
-            proploss_index_var->put(&record, 1, 1);  // 1st rec = summed PL
-            int next_rec = record+1 ;
-            eigenray_index_var->put(&next_rec, 1, 1); // followed by list of rays
-            eigenray_num_var->put(&num, 1, 1);
+            proploss_index[t] = record;         // 1st rec = summed PL
+            eigenray_index[t] = record + 1;     // followed by list of rays
+            eigenray_num[t] = num;
 
             eigenray_list::const_iterator iter = _eigenrays(t1, t2).begin();
-
             for (int n = -1; n < num; ++n) {
 
-                // set record number for each eigenray data element
-
-                intensity_var->set_cur(record, 0);
-                phase_var->set_cur(record, 0);
-                time_var->set_cur(record);
-                source_de_var->set_cur(record);
-                source_az_var->set_cur(record);
-                target_de_var->set_cur(record);
-                target_az_var->set_cur(record);
-                surface_var->set_cur(record);
-                bottom_var->set_cur(record);
-                caustic_var->set_cur(record);
-                ++record ;
-
-                // case 1 : write propagation loss summed over all eigenrays
-
-                if (n < 0) {
-                    const eigenray& loss = _loss(t1, t2);
-                    intensity_var->put(loss.intensity.data().begin(),
-                            1, 1, _frequencies->size());
-                    phase_var->put(loss.phase.data().begin(),
-                            1, 1, _frequencies->size());
-                    time_var->put(&loss.time, 1, 1);
-                    source_de_var->put(&loss.source_de, 1, 1);
-                    source_az_var->put(&loss.source_az, 1, 1);
-                    target_de_var->put(&loss.target_de, 1, 1);
-                    target_az_var->put(&loss.target_az, 1, 1);
-                    surface_var->put(&loss.surface, 1, 1);
-                    bottom_var->put(&loss.bottom, 1, 1);
-                    caustic_var->put(&loss.caustic, 1, 1);
-
-                // case 2 : write individual eigenray
-
-                } else {
-                    const eigenray& loss = *iter++;
-                    intensity_var->put(loss.intensity.data().begin(),
-                            1, 1, _frequencies->size());
-                    phase_var->put(loss.phase.data().begin(),
-                            1, 1, _frequencies->size());
-                    time_var->put(&loss.time, 1, 1);
-                    source_de_var->put(&loss.source_de, 1, 1);
-                    source_az_var->put(&loss.source_az, 1, 1);
-                    target_de_var->put(&loss.target_de, 1, 1);
-                    target_az_var->put(&loss.target_az, 1, 1);
-                    surface_var->put(&loss.surface, 1, 1);
-                    bottom_var->put(&loss.bottom, 1, 1);
-                    caustic_var->put(&loss.caustic, 1, 1);
-
-                } // if sum or individual
+                // case 1 : propagation loss summed over all eigenrays
+                // case 2 : individual eigenray
+
+                const eigenray& loss = (n < 0) ? _loss(t1, t2) : *iter++;
+                std::copy(loss.intensity.begin(), loss.intensity.end(),
+                        intensity.begin() + record * num_freqs);
+                std::copy(loss.phase.begin(), loss.phase.end(),
+                        phase.begin() + record * num_freqs);
+                time[record] = loss.time;
+                source_de[record] = loss.source_de;
+                source_az[record] = loss.source_az;
+                target_de[record] = loss.target_de;
+                target_az[record] = loss.target_az;
+                surface[record] = loss.surface;
+                bottom[record] = loss.bottom;
+                caustic[record] = loss.caustic;
+                ++record;
             }   // loop over # of eigenrays
         } // loop over target# t2
     } // loop over target# t1
 
+    // write propagation loss and eigenrays to disk
+
+    proploss_index_var->put(&proploss_index[0],
+            _targets->size1(), _targets->size2());
+    eigenray_index_var->put(&eigenray_index[0],
+            _targets->size1(), _targets->size2());
+    eigenray_num_var->put(&eigenray_num[0],
+            _targets->size1(), _targets->size2());
+    intensity_var->put(&intensity[0], num_records, num_freqs);
+    phase_var->put(&phase[0], num_records, num_freqs);
+    time_var->put(&time[0], num_records);
+    source_de_var->put(&source_de[0], num_records);
+    source_az_var->put(&source_az[0], num_records);
+    target_de_var->put(&target_de[0], num_records);
+    target_az_var->put(&target_az[0], num_records);
+    surface_var->put(&surface[0], num_records);
+    bottom_var->put(&bottom[0], num_records);
+    caustic_var->put(&caustic[0], num_records);
+
     // close file
 
     delete nc_file; // destructor frees all netCDF temp variables
 }
+
+/**
+ * Write proploss data to a compact binary archive.
+ */
+void proploss::write_archive( const char* filename, bool single )
+{
+    eigenray_archive::write( filename, *this, single ) ;
+}
@@ -8,6 +8,8 @@
 #include <usml/ocean/ocean.h>
 #include <usml/waveq3d/proplossListener.h>
 #include <usml/waveq3d/wave_queue.h>
+#include <complex>
+#include <vector>
 
 namespace usml {
 namespace waveq3d {
@@ -23,6 +25,14 @@ using namespace usml::ocean;
  * accumulates acoustic eigenrays at each location.  After propagation is
  * complete, the sum_eigenrays() method is used to collect the results
  * into a phasor-summed propagation loss and phase at each target point.
+ *
+ * Transmission loss maps only need the summed propagation loss at each
+ * target, not the individual eigenrays.  In this case, stream_eigenrays()
+ * can be called before propagation starts, to add each eigenray into
+ * a running phasor sum as it arrives.  Memory use is then proportional to
+ * the number of targets times the number of frequencies, no matter how
+ * many eigenrays are produced, and sum_eigenrays() just converts the
+ * running sums into propagation loss.
  */
 class USML_DECLSPEC proploss : public proplossListener {
 
@@ -86,6 +96,36 @@ private:
      */
     matrix< eigenray > _loss;
 
+    /**
+     * Amplitude weighted sums of eigenray terms for a single target.
+     * Used to accumulate eigenrays in streaming mode.
+     */
+    struct running_sum {
+        double wgt ;
+        double time ;
+        double source_de ;
+        double source_az ;
+        double target_de ;
+        double target_az ;
+        double max_a ;
+    } ;
+
+    /** Accumulate eigenrays as they arrive, instead of storing them. */
+    bool _streaming ;
+
+    /** Sum phases coherently when accumulating eigenrays. */
+    bool _coherent ;
+
+    /**
+     * Running sum of complex amplitudes for each target and frequency,
+     * in streaming mode.  Targets are stored in row major order, with
+     * all of the frequencies for each target stored together.
+     */
+    std::vector< std::complex<double> > _phasor ;
+
+    /** Running sums of other eigenray terms for each target. */
+    std::vector< running_sum > _running ;
+
 public:
 
     /**
@@ -129,6 +169,16 @@ private:
      */
     void initialize();
 
+    /**
+     * Add a single eigenray to the running sums of its target.
+     * Uses the same summation rules as sum_eigenrays().
+     *
+     * @param   t1          Row number of the current target.
+     * @param   t2          Column number of the current target.
+     * @param   ray         The eigenray to add.
+     */
+    void accumulate( unsigned t1, unsigned t2, const eigenray& ray ) ;
+
 public:
 
     /**
@@ -199,9 +249,39 @@ public:
 	 */
 	bool addEigenray(unsigned targetRow, unsigned targetCol, eigenray pRay );
 
+	/**
+	 * addEigenrays - Adds a batch of eigenrays to the eigenray_lists
+	 * of their targets.
+	 * @param   rays               Pointer to the first eigenray in the batch.
+	 * @param   count              Number of eigenrays in the batch.
+	 * @return                     True on success, false on failure.
+	 */
+	bool addEigenrays(const target_eigenray* rays, unsigned count);
+
+
+    /**
+     * Accumulate propagation loss as eigenrays arrive, instead of storing
+     * them in the eigenray list for each target.  Must be called before
+     * propagation starts.  Discards any eigenrays that have already been
+     * stored.  The eigenray lists remain empty in this mode, so
+     * write_netcdf() and write_archive() only record the summed
+     * propagation loss for each target.
+     *
+     * @param   coherent    Compute coherent propagation loss if true,
+     *                      and incoherent if false.
+     */
+    void stream_eigenrays(bool coherent = true);
+
+    /** True if eigenrays are accumulated as they arrive. */
+    inline bool streaming() const {
+        return _streaming;
+    }
 
     /**
      * Compute propagation loss summed over all eigenrays.
+     * In streaming mode, converts the running sums into propagation
+     * loss, and the summation type selected by stream_eigenrays()
+     * is used instead of the coherent argument.
      *
      * @param   coherent    Compute coherent propagation loss if true,
      *                      and incoherent if false.
@@ -262,11 +342,11 @@ public:
      *     	double altitude(rows, cols) ;
      *     		altitude:units = "meters" ;
      *     		altitude:positive = "up" ;
-     *     	short proploss_index(rows, cols) ;
+     *     	int proploss_index(rows, cols) ;
      *     		proploss_index:units = "count" ;
-     *     	short eigenray_index(rows, cols) ;
+     *     	int eigenray_index(rows, cols) ;
      *     		eigenray_index:units = "count" ;
-     *     	short eigenray_num(rows, cols) ;
+     *     	int eigenray_num(rows, cols) ;
      *     		eigenray_num:units = "count" ;
      *     	double intensity(eigenrays, frequency) ;
      *     		intensity:units = "dB" ;
@@ -333,6 +413,20 @@ public:
     void write_netcdf(
             const char* filename, const char* long_name = NULL);
 
+    /**
+     * Write proploss data to a compact binary archive.  Much faster to
+     * write and read than write_netcdf() for large numbers of eigenrays,
+     * and supports reading the eigenrays for a single target without
+     * loading the whole file.  See eigenray_archive for the file layout.
+     *
+     * The user is responsible for ensuring that sum_eigenrays() has been
+     * called prior to this routine.
+     *
+     * @param   filename    Name of the file to write to disk.
+     * @param   single      Store real values in single precision, if true.
+     */
+    void write_archive( const char* filename, bool single = false );
+
 };
 
 /// @}
@@ -12,6 +12,22 @@
 namespace usml {
 namespace waveq3d {
 
+/**
+ * An eigenray and the target that it belongs to.
+ * Used to deliver batches of eigenrays to a proplossListener.
+ */
+struct target_eigenray {
+
+	/** Row number of the target. */
+	unsigned row ;
+
+	/** Column number of the target. */
+	unsigned col ;
+
+	/** Acoustic path to this target. */
+	eigenray ray ;
+};
+
 /**
  * @class proplossListener
  * @brief This class is part of a Observer/Subject pattern for the wave_queue class
@@ -37,6 +53,25 @@ public:
 	 */
 	virtual bool addEigenray(unsigned targetRow, unsigned targetCol, eigenray pRay ) = 0;
 
+	/**
+	 * addEigenrays
+	 * Adds a batch of eigenrays, for any number of targets, in a single call.
+	 * The wave_queue delivers all of the eigenrays found in a time step
+	 * this way.  The default implementation calls addEigenray() for each
+	 * eigenray in the batch.  Listeners should override this method to
+	 * avoid the virtual call, and the copy of the eigenray, for each path.
+	 *  @param   rays      Pointer to the first eigenray in the batch.
+	 *  @param   count     Number of eigenrays in the batch.
+	 *  @return            True if all of the eigenrays were added.
+	 */
+	virtual bool addEigenrays(const target_eigenray* rays, unsigned count) {
+		bool result = true;
+		for (unsigned n = 0; n < count; ++n) {
+			result = addEigenray(rays[n].row, rays[n].col, rays[n].ray) && result;
+		}
+		return result;
+	}
+
 
 protected:
 
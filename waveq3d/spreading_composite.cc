@@ -0,0 +1,72 @@
+/**
+ * @file spreading_composite.cc
+ * Spreading loss that selects a model for each eigenray.
+ */
+#include <usml/waveq3d/spreading_composite.h>
+
+using namespace usml::waveq3d;
+
+/**
+ * Initializes both spreading models, and computes the range from
+ * the source to each target.
+ */
+spreading_composite::spreading_composite(wave_queue& wave) :
+    spreading_model( wave, wave._frequencies->size() ),
+    _ray( wave ),
+    _gaussian( wave ),
+    _range( wave._targets->size1(), wave._targets->size2() ),
+    _near_range( 0.0 ),
+    _max_caustics( 0 ),
+    _width_ratio( 1.0 )
+{
+    for (unsigned t1 = 0; t1 < _range.size1(); ++t1) {
+        for (unsigned t2 = 0; t2 < _range.size2(); ++t2) {
+            wposition1 target( *wave._targets, t1, t2 ) ;
+            _range(t1, t2) = target.distance( wave._source_pos ) ;
+        }
+    }
+
+    // the lowest frequency has the widest evanescent spreading
+
+    double fmin = (*wave._frequencies)(0) ;
+    for (unsigned f = 1; f < wave._frequencies->size(); ++f) {
+        fmin = min( fmin, (*wave._frequencies)(f) ) ;
+    }
+    _spread_scale = spreading_hybrid_gaussian::SPREADING_WIDTH / fmin ;
+}
+
+/**
+ * Decide if hybrid Gaussian beams are needed for this eigenray.
+ */
+bool spreading_composite::use_gaussian(
+    unsigned t1, unsigned t2, unsigned de, unsigned az )
+{
+    if ( _range(t1, t2) < _near_range ) return true ;
+    if ( _wave._curr->caustic(de, az) > _max_caustics ) return true ;
+    if ( _width_ratio <= 0.0 ) return false ;
+
+    // compare cell widths to spreading width at target
+
+    const double limit = _width_ratio * _spread_scale
+                       * _wave._targets_sound_speed(t1, t2) ;
+    const wposition& pos = _wave._curr->position ;
+    const wvector1 center( pos, de, az ) ;
+    if ( de + 1 < _wave.num_de() &&
+         center.distance( wvector1(pos, de + 1, az) ) < limit ) return true ;
+    if ( az + 1 < _wave.num_az() &&
+         center.distance( wvector1(pos, de, az + 1) ) < limit ) return true ;
+    return false ;
+}
+
+/**
+ * Estimate intensity using the model selected for this eigenray.
+ */
+const vector<double>& spreading_composite::intensity(
+    unsigned t1, unsigned t2, unsigned de, unsigned az,
+    const c_vector<double,3>& offset, const c_vector<double,3>& distance )
+{
+    if ( use_gaussian(t1, t2, de, az) ) {
+        return _gaussian.intensity( t1, t2, de, az, offset, distance ) ;
+    }
+    return _ray.intensity( t1, t2, de, az, offset, distance ) ;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file spreading_composite.h
+ * Spreading loss that selects a model for each eigenray.
+ */
+#ifndef USML_WAVEQ3D_SPREADING_COMPOSITE_H
+#define USML_WAVEQ3D_SPREADING_COMPOSITE_H
+
+#include <usml/waveq3d/spreading_ray.h>
+#include <usml/waveq3d/spreading_hybrid_gaussian.h>
+
+namespace usml {
+namespace waveq3d {
+
+using namespace usml::ocean ;
+
+/**
+ * @internal
+ * Spreading loss that selects either classic ray theory or hybrid
+ * Gaussian beams for each eigenray.  The hybrid Gaussian model sums
+ * contributions from many neighboring cells, which makes it several times
+ * more expensive than classic ray theory.  But the accuracy of the
+ * Gaussian beams is only needed near the source, near caustics, and
+ * where the ray cells are narrow compared to the frequency dependent
+ * evanescent spreading width.  Elsewhere, classic ray theory gives
+ * nearly the same answer at a fraction of the cost.
+ *
+ * Hybrid Gaussian beams are used if any of these conditions are true:
+ *
+ * - The straight line range from source to target is less
+ *   than the near range.
+ * - The number of caustics along the path is greater than the
+ *   maximum number of caustics.
+ * - The width of the wavefront cell at the point of collision,
+ *   in either the D/E or AZ direction, is less than the width ratio
+ *   times the evanescent spreading width \f$ 2 \pi \lambda \f$ at the
+ *   lowest frequency.
+ *
+ * Classic ray theory is used for all other eigenrays.  Each condition
+ * can be disabled by setting its parameter to zero, or to a very large
+ * number of caustics.
+ */
+class USML_DECLSPEC spreading_composite : public spreading_model {
+
+    friend class wave_queue ;
+
+  private:
+
+    /** Classic ray theory, used for most eigenrays. */
+    spreading_ray _ray ;
+
+    /** Hybrid Gaussian beams, used where accuracy matters. */
+    spreading_hybrid_gaussian _gaussian ;
+
+    /** Straight line range from source to each target (meters). */
+    matrix<double> _range ;
+
+    /** Evanescent spreading width per unit sound speed at the lowest frequency. */
+    double _spread_scale ;
+
+    /** Use Gaussian beams for targets closer than this range (meters). */
+    double _near_range ;
+
+    /** Use Gaussian beams for paths with more caustics than this. */
+    int _max_caustics ;
+
+    /** Use Gaussian beams when cells are narrower than this many spreading widths. */
+    double _width_ratio ;
+
+  protected:
+
+    /**
+     * Initializes both spreading models, and computes the range from
+     * the source to each target.  Defaults to a near range of zero,
+     * zero caustics, and a width ratio of one.
+     *
+     * @param wave          Wavefront object associated with this model.
+     */
+    spreading_composite( wave_queue& wave ) ;
+
+    /**
+     * Virtual destructor
+     */
+    virtual ~spreading_composite() {}
+
+    /**
+     * Define the conditions under which hybrid Gaussian beams are used.
+     *
+     * @param  near_range   Use Gaussian beams for targets closer than
+     *                      this range (meters).
+     * @param  max_caustics Use Gaussian beams for paths with more
+     *                      caustics than this.
+     * @param  width_ratio  Use Gaussian beams when the wavefront cell is
+     *                      narrower than this many spreading widths.
+     */
+    void criteria( double near_range, int max_caustics, double width_ratio ) {
+        _near_range = near_range ;
+        _max_caustics = max_caustics ;
+        _width_ratio = width_ratio ;
+    }
+
+    /**
+     * Estimate intensity using the model selected for this eigenray.
+     *
+     * @param  t1           Row index of the target.
+     * @param  t2           Column index of the target.
+     * @param  de           DE index of closest point of approach.
+     * @param  az           AZ index of closest point of approach.
+     * @param  offset       Offsets in time, DE, and AZ at collision.
+     * @param  distance     Offsets in distance units.
+     * @return              Intensity of ray at this point.
+     */
+    virtual const vector<double>& intensity(
+        unsigned t1, unsigned t2, unsigned de, unsigned az,
+        const c_vector<double,3>& offset,
+        const c_vector<double,3>& distance ) ;
+
+  private:
+
+    /**
+     * Decide if hybrid Gaussian beams are needed for this eigenray.
+     *
+     * @param  t1           Row index of the target.
+     * @param  t2           Column index of the target.
+     * @param  de           DE index of closest point of approach.
+     * @param  az           AZ index of closest point of approach.
+     * @return              True if hybrid Gaussian beams should be used.
+     */
+    bool use_gaussian( unsigned t1, unsigned t2, unsigned de, unsigned az ) ;
+} ;
+
+}  // end of namespace waveq3d
+}  // end of namespace usml
+
+#endif
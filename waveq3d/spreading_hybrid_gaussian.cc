@@ -25,6 +25,7 @@ spreading_hybrid_gaussian::spreading_hybrid_gaussian(wave_queue& wave) :
     _beam_width(wave._frequencies->size()),
     _intensity_de(wave._frequencies->size()),
     _intensity_az(wave._frequencies->size()),
+    _gaussian(wave._frequencies->size()),
     _duplicate(wave.num_az(), 1)
 {
     for (unsigned d = 0; d < wave.num_de() - 1 ; ++d) {
@@ -55,25 +56,18 @@ spreading_hybrid_gaussian::spreading_hybrid_gaussian(wave_queue& wave) :
  * in the D/E and AZ directions.
  */
 const vector<double>& spreading_hybrid_gaussian::intensity(
-    const wposition1& location, unsigned de, unsigned az,
-    const vector<double>& offset, const vector<double>& distance )
+    unsigned t1, unsigned t2, unsigned de, unsigned az,
+    const c_vector<double,3>& offset, const c_vector<double,3>& distance )
 {
-    // get sound speed at target
-
-    matrix<double> sound_speed(1, 1);
-    wposition loc(1, 1);
-    loc.rho(0, 0, location.rho());
-    loc.theta(0, 0, location.theta());
-    loc.phi(0, 0, location.phi());
-    _wave._ocean.profile().sound_speed(loc, &sound_speed);
-
-    // convert frequency into spreading distance
+    // convert frequency into spreading distance squared
+    // using the cached sound speed at target
 
+    const double sound_speed = _wave._targets_sound_speed(t1, t2) ;
     for (unsigned f = 0; f < _wave._frequencies->size(); ++f) {
-        _spread(f) = SPREADING_WIDTH
-                   * sound_speed(0, 0) / (*_wave._frequencies)(f) ;
+        const double spread = SPREADING_WIDTH
+                   * sound_speed / (*_wave._frequencies)(f) ;
+        _spread(f) = spread * spread ;
     }
-    _spread = element_prod(_spread,_spread) ;
 
     // compute Gaussian beam components in DE and AZ directions
 
@@ -86,7 +80,7 @@ const vector<double>& spreading_hybrid_gaussian::intensity(
     intensity_de(de, a, offset, distance);
     unsigned d = (offset(2) < 0.0) ? de - 1 : de ;
     intensity_az(d, az, offset, distance);
-    _intensity_de = element_prod(_intensity_de, _intensity_az);
+    noalias(_intensity_de) = element_prod(_intensity_de, _intensity_az);
     return _intensity_de;
 }
 
@@ -94,7 +88,7 @@ const vector<double>& spreading_hybrid_gaussian::intensity(
  * Summation of Gaussian beam contributions from all cells in the D/E direction.
  */
 void spreading_hybrid_gaussian::intensity_de( unsigned de, unsigned az,
-    const vector<double>& offset, const vector<double>& distance )
+    const c_vector<double,3>& offset, const c_vector<double,3>& distance )
 {
     #ifdef USML_WAVEQ3D_DEBUG_DE
         cout << "spreading_hybrid_gaussian::intensity_de:"
@@ -118,7 +112,7 @@ void spreading_hybrid_gaussian::intensity_de( unsigned de, unsigned az,
     const double initial_width = cell_width;    // save width for upper angles
     const double L = distance(1) ;              // D/E dist from nearest ray
     double cell_dist = L - cell_width ;         // dist from center of this cell
-    _intensity_de = s*gaussian(cell_dist, cell_width, _norm_de(d));
+    noalias(_intensity_de) = s*gaussian(cell_dist, cell_width, _norm_de(d));
 
     #ifdef USML_WAVEQ3D_DEBUG_DE
         cout << "\t** center" << endl
@@ -137,7 +131,7 @@ void spreading_hybrid_gaussian::intensity_de( unsigned de, unsigned az,
     d = (int) de - 1;
     cell_width = width_de(d, az, offset);   // half width of this cell
     cell_dist = L + cell_width;             // dist from center of this cell
-    _intensity_de += gaussian(cell_dist, cell_width, _norm_de(d));
+    noalias(_intensity_de) += gaussian(cell_dist, cell_width, _norm_de(d));
 
     #ifdef USML_WAVEQ3D_DEBUG_DE
         cout << "\tde(" << d << ")=" << (*_wave._source_de)(d)
@@ -176,7 +170,7 @@ void spreading_hybrid_gaussian::intensity_de( unsigned de, unsigned az,
 
         const double old_tl = _intensity_de(0);
         if( _wave._curr->caustic(d,az) != 0 && s!=1.0 ) {s=0.25;}
-        _intensity_de += s*gaussian(cell_dist, cell_width, _norm_de(d));
+        noalias(_intensity_de) += s*gaussian(cell_dist, cell_width, _norm_de(d));
 
         #ifdef USML_WAVEQ3D_DEBUG_DE
             cout << "\tde(" << d << ")=" << (*_wave._source_de)(d)
@@ -221,7 +215,7 @@ void spreading_hybrid_gaussian::intensity_de( unsigned de, unsigned az,
         // compute propagation loss contribution of this cell
 
         const double old_tl = _intensity_de(0);
-        _intensity_de += s*gaussian(cell_dist, cell_width, _norm_de(d));
+        noalias(_intensity_de) += s*gaussian(cell_dist, cell_width, _norm_de(d));
 
         #ifdef USML_WAVEQ3D_DEBUG_DE
             cout << "\tde(" << d << ")=" << (*_wave._source_de)(d)
@@ -240,7 +234,7 @@ void spreading_hybrid_gaussian::intensity_de( unsigned de, unsigned az,
  * Summation of Gaussian beam contributions from all cells in the AZ direction.
  */
 void spreading_hybrid_gaussian::intensity_az( unsigned de, unsigned az,
-    const vector<double>& offset, const vector<double>& distance )
+    const c_vector<double,3>& offset, const c_vector<double,3>& distance )
 {
     #ifdef USML_WAVEQ3D_DEBUG_AZ
         cout << "spreading_hybrid_gaussian::intensity_az:"
@@ -277,7 +271,7 @@ void spreading_hybrid_gaussian::intensity_az( unsigned de, unsigned az,
     double _new_norm ;
     if ( de >= _wave._source_de->size() - 2 ) { _new_norm = _norm_az(1,a) ; }
     else { _new_norm = _norm_az(de,a) ; }
-    _intensity_az = gaussian(cell_dist, cell_width, _new_norm);
+    noalias(_intensity_az) = gaussian(cell_dist, cell_width, _new_norm);
 
     #ifdef USML_WAVEQ3D_DEBUG_AZ
         cout << "\t** center" << endl
@@ -303,7 +297,7 @@ void spreading_hybrid_gaussian::intensity_az( unsigned de, unsigned az,
 //    _intensity_az += gaussian(cell_dist, cell_width, _norm_az(de, a));
     if ( de >= _wave._source_de->size() - 2 ) { _new_norm = _norm_az(1,a) ; }
     else { _new_norm = _norm_az(de,a) ; }
-    _intensity_az += gaussian(cell_dist, cell_width, _new_norm);
+    noalias(_intensity_az) += gaussian(cell_dist, cell_width, _new_norm);
 
     #ifdef USML_WAVEQ3D_DEBUG_AZ
         cout << "\taz(" << a << ")=" << (*_wave._source_az)(a)
@@ -344,7 +338,7 @@ void spreading_hybrid_gaussian::intensity_az( unsigned de, unsigned az,
 //        _intensity_az += gaussian(cell_dist, cell_width, _norm_az(de, a));
         if ( de >= _wave._source_de->size() - 2 ) { _new_norm = _norm_az(1,a) ; }
         else { _new_norm = _norm_az(de,a) ; }
-        _intensity_az += gaussian(cell_dist, cell_width, _new_norm);
+        noalias(_intensity_az) += gaussian(cell_dist, cell_width, _new_norm);
 
         #ifdef USML_WAVEQ3D_DEBUG_AZ
             cout << "\taz(" << a << ")=" << (*_wave._source_az)(a)
@@ -393,7 +387,7 @@ void spreading_hybrid_gaussian::intensity_az( unsigned de, unsigned az,
 //        _intensity_az += gaussian(cell_dist, cell_width, _norm_az(de, a));
         if ( de >= _wave._source_de->size() - 2 ) { _new_norm = _norm_az(1,a) ; }
         else { _new_norm = _norm_az(de,a) ; }
-        _intensity_az += gaussian(cell_dist, cell_width, _new_norm);
+        noalias(_intensity_az) += gaussian(cell_dist, cell_width, _new_norm);
 
         #ifdef USML_WAVEQ3D_DEBUG_AZ
             cout << "\taz(" << a << ")=" << (*_wave._source_az)(a)
@@ -415,7 +409,7 @@ void spreading_hybrid_gaussian::intensity_az( unsigned de, unsigned az,
  * Interpolate the half-width of a cell in the D/E direction.
  */
 double spreading_hybrid_gaussian::width_de(
-    unsigned de, unsigned az, const vector<double>& offset )
+    unsigned de, unsigned az, const c_vector<double,3>& offset )
 {
     double L1, L2, length1, length2 ;
 
@@ -475,7 +469,7 @@ double spreading_hybrid_gaussian::width_de(
  * Interpolate the half-width of a cell in the AZ direction.
  */
 double spreading_hybrid_gaussian::width_az(
-    unsigned de, unsigned az, const vector<double>& offset )
+    unsigned de, unsigned az, const c_vector<double,3>& offset )
 {
     double L1, L2, length1, length2 ;
     // compute relative offsets in time (u) and D/E (v)
@@ -44,6 +44,7 @@ using namespace usml::ocean ;
 class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
 
     friend class wave_queue ;
+    friend class spreading_composite ;
 
   private:
 
@@ -62,6 +63,9 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
     /** Intensity contribution in azimuthal direction. (temp workspace) */
     vector<double> _intensity_az ;
 
+    /** Contribution from a single Gaussian beam. (temp workspace) */
+    vector<double> _gaussian ;
+
     matrix<bool> _duplicate ;
 
     /**
@@ -128,18 +132,26 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
      * is folded into the normalization calculation so that it can be
      * computed a single time, during initialization.
      *
+     * Results are written into the _gaussian workspace, so that
+     * this computation does not allocate memory.
+     *
      * @param   d           Distance from field point to center of profile.
      * @param   w           Half-width this cell in the wavefront.
      * @param   A           Normalization coefficient.
+     * @return              Reference to the _gaussian workspace.
      *
      * @xref Weisstein, Eric W. "Convolution." From MathWorld--A Wolfram Web
      * Resource. http://mathworld.wolfram.com/Convolution.html
      */
-    inline vector<double> gaussian(double d,double w,double A) {
-        _beam_width = _spread + OVERLAP * OVERLAP * w * w ; // sum of squares
-        return element_div(
-        	exp( (-0.5*d*d) / _beam_width ),
-        	sqrt(_beam_width) ) * A ;
+    inline const vector<double>& gaussian(double d,double w,double A) {
+        const double width2 = OVERLAP * OVERLAP * w * w ;
+        const double dist2 = -0.5*d*d ;
+        for ( unsigned f=0 ; f < _spread.size() ; ++f ) {
+            const double beam = _spread(f) + width2 ; // sum of squares
+            _beam_width(f) = beam ;
+            _gaussian(f) = exp( dist2 / beam ) / sqrt( beam ) * A ;
+        }
+        return _gaussian ;
     }
 
     /**
@@ -148,7 +160,8 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
      * characterized in terms of independent D/E and AZ terms and that
      * Gaussian beam cross terms are unimportant.
      *
-     * @param  location     Target location.
+     * @param  t1           Row index of the target.
+     * @param  t2           Column index of the target.
      * @param  de           DE index of closest point of approach.
      * @param  az           AZ index of closest point of approach.
      * @param  offset       Offsets in time, DE, and AZ at collision.
@@ -156,8 +169,9 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
      * @return              Intensity of ray at this point.
      */
     virtual const vector<double>& intensity(
-        const wposition1& location, unsigned de, unsigned az,
-        const vector<double>& offset, const vector<double>& distance ) ;
+        unsigned t1, unsigned t2, unsigned de, unsigned az,
+        const c_vector<double,3>& offset,
+        const c_vector<double,3>& distance ) ;
 
   private:
 
@@ -173,7 +187,7 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
      * @return              Intensity of ray at this point.
      */
     void intensity_de( unsigned de, unsigned az,
-        const vector<double>& offset, const vector<double>& distance ) ;
+        const c_vector<double,3>& offset, const c_vector<double,3>& distance ) ;
 
     /**
      * Summation of Gaussian beam contributions from all cells in
@@ -187,7 +201,7 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
      * @return              Intensity of ray at this point.
      */
     void intensity_az( unsigned de, unsigned az,
-        const vector<double>& offset, const vector<double>& distance ) ;
+        const c_vector<double,3>& offset, const c_vector<double,3>& distance ) ;
 
     /**
      * Interpolate the half-width of a cell in the D/E direction.
@@ -202,7 +216,7 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
      * @param   offset      Offsets in time, DE, and AZ at collision.
      * @return              Half-width of cell in the DE direction.
      */
-    double width_de( unsigned de, unsigned az, const vector<double>& offset ) ;
+    double width_de( unsigned de, unsigned az, const c_vector<double,3>& offset ) ;
 
     /**
      * Interpolate the half-width of a cell in the AZ direction.
@@ -217,7 +231,7 @@ class USML_DECLSPEC spreading_hybrid_gaussian : public spreading_model {
      * @param   offset      Offsets in time, DE, and AZ at collision.
      * @return              Half-width of cell in the AZ direction.
      */
-    double width_az( unsigned de, unsigned az, const vector<double>& offset ) ;
+    double width_az( unsigned de, unsigned az, const c_vector<double,3>& offset ) ;
 
 } ;
 
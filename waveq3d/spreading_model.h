@@ -47,8 +47,11 @@ class USML_DECLSPEC spreading_model {
 
     /**
      * Estimate intensity at a specific target location.
+     * Implementations must not allocate memory; results are returned
+     * in a workspace that is re-used by the next call.
      *
-     * @param  location     Target location.
+     * @param  t1           Row index of the target.
+     * @param  t2           Column index of the target.
      * @param  de           DE index of closest point of approach.
      * @param  az           AZ index of closest point of approach.
      * @param  offset       Offsets in time, DE, and AZ at collision.
@@ -56,8 +59,9 @@ class USML_DECLSPEC spreading_model {
      * @return              Intensity of ray at this point.
      */
     virtual const vector<double>& intensity(
-        const wposition1& location, unsigned de, unsigned az,
-        const vector<double>& offset, const vector<double>& distance ) = 0 ;
+        unsigned t1, unsigned t2, unsigned de, unsigned az,
+        const c_vector<double,3>& offset,
+        const c_vector<double,3>& distance ) = 0 ;
 } ;
 
 }  // end of namespace waveq3d
@@ -33,23 +33,14 @@ spreading_ray::spreading_ray(wave_queue& wave) :
  * Estimate intensity as the ratio of current area to initial area.
  */
 const vector<double>& spreading_ray::intensity(
-    const wposition1& location, unsigned de, unsigned az,
-    const vector<double>& offset, const vector<double>& distance )
+    unsigned t1, unsigned t2, unsigned de, unsigned az,
+    const c_vector<double,3>& offset, const c_vector<double,3>& distance )
 {
     // which box has target in it?
 
     if (offset(1) < 0.0) --de;
     if (offset(2) < 0.0) --az;
 
-    // get sound speed at target
-
-    matrix<double> sound_speed(1, 1);
-    wposition loc(1, 1);
-    loc.rho(0, 0, location.rho());
-    loc.theta(0, 0, location.theta());
-    loc.phi(0, 0, location.phi());
-    _wave._ocean.profile().sound_speed(loc, &sound_speed);
-
     // compare area of this box to original area
     // linear interpolation between two wavefronts
 
@@ -95,7 +86,8 @@ const vector<double>& spreading_ray::intensity(
     const double area = (1.0 - u) * area1 + u * area2;
 //    cout << " area1=" << area1 << " area2=" << area2 
 //         << " u=" << u << " area=" << area << endl ;
-    const double loss = _init_area(de, az) * sound_speed(0, 0) / area;
+    const double loss = _init_area(de, az)
+                      * _wave._targets_sound_speed(t1, t2) / area;
     for (unsigned f = 0; f < _wave._frequencies->size(); ++f) {
         _spread(f) = loss ;
     }
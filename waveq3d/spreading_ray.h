@@ -33,6 +33,7 @@ using namespace usml::ocean ;
 class USML_DECLSPEC spreading_ray : public spreading_model {
 
     friend class wave_queue ;
+    friend class spreading_composite ;
 
   private:
 
@@ -82,7 +83,8 @@ class USML_DECLSPEC spreading_ray : public spreading_model {
      * away from the actual edge.  A failure to properly take this into account
      * will show up as weak eignerays near the surface, bottom, or caustics.
      *
-     * @param  location     Target location.
+     * @param  t1           Row index of the target.
+     * @param  t2           Column index of the target.
      * @param  de           DE index of closest point of approach.
      * @param  az           AZ index of closest point of approach.
      * @param  offset       Offsets in time, DE, and AZ at collision.
@@ -90,8 +92,9 @@ class USML_DECLSPEC spreading_ray : public spreading_model {
      * @return              Intensity of ray at this point.
      */
     virtual const vector<double>& intensity(
-        const wposition1& location, unsigned de, unsigned az,
-        const vector<double>& offset, const vector<double>& distance ) ;
+        unsigned t1, unsigned t2, unsigned de, unsigned az,
+        const c_vector<double,3>& offset,
+        const c_vector<double,3>& distance ) ;
 } ;
 
 }  // end of namespace waveq3d
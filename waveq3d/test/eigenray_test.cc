@@ -3,6 +3,7 @@
  */
 #include <boost/test/unit_test.hpp>
 #include <usml/waveq3d/waveq3d.h>
+#include <boost/thread.hpp>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -69,12 +70,17 @@ static const double bot_depth = 1e5 ;
  * This test writes multi-path eigenrays in CSV format to eigenray_basic.csv
  * and in netCDF format to eigenray_basic.nc.  It also records the wavefronts
  * to eigenray_basic_wave.nc so that a ray trace can be plotted in Matlab.
+ * The eigenrays are also written to the binary archive eigenray_basic.ray,
+ * and read back to verify that they survive the round trip.  An
+ * eigenray_strongest listener, limited to two eigenrays, is used to verify
+ * that only the direct and surface paths are retained, strongest first.
  */
 BOOST_AUTO_TEST_CASE( eigenray_basic ) {
     cout << "=== eigenray_test: eigenray_basic ===" << endl;
     const char* csvname = USML_TEST_DIR "/waveq3d/test/eigenray_basic.csv";
     const char* ncname = USML_TEST_DIR "/waveq3d/test/eigenray_basic.nc";
     const char* ncname_wave = USML_TEST_DIR "/waveq3d/test/eigenray_basic_wave.nc";
+    const char* arcname = USML_TEST_DIR "/waveq3d/test/eigenray_basic.ray";
     const double src_alt = -1000.0;
     const double trg_lat = 45.02;
     const double time_max = 3.5;
@@ -99,8 +105,10 @@ BOOST_AUTO_TEST_CASE( eigenray_basic ) {
     wposition target( 1, 1, trg_lat, src_lng, src_alt );
 
     proploss loss(freq, pos, de, az, time_step, &target);
+    eigenray_strongest strongest(&target, 2);
     wave_queue wave( ocean, freq, pos, de, az, time_step, &target) ;
     wave.addProplossListener(&loss);
+    wave.addProplossListener(&strongest);
 
     // propagate rays and record wavefronts to disk.
 
@@ -193,6 +201,63 @@ BOOST_AUTO_TEST_CASE( eigenray_basic ) {
         BOOST_CHECK_SMALL( ray.source_az-0.0, 1e-6 );
         BOOST_CHECK_SMALL( ray.target_az-0.0, 1e-6 );
     }
+
+    // write eigenrays to binary archive and read them back
+
+    cout << "writing archive to " << arcname << endl;
+    loss.write_archive(arcname);
+    eigenray_archive archive(arcname);
+    BOOST_CHECK_EQUAL( archive.size1(), 1u ) ;
+    BOOST_CHECK_EQUAL( archive.size2(), 1u ) ;
+    BOOST_CHECK_EQUAL( archive.num_eigenrays(0,0), raylist->size() ) ;
+    BOOST_CHECK_SMALL( archive.position(0,0).latitude()-trg_lat, 1e-10 ) ;
+
+    eigenray_list archived ;
+    archive.eigenrays(0,0,archived) ;
+    eigenray_list::const_iterator saved = archived.begin() ;
+    for ( eigenray_list::const_iterator iter = raylist->begin();
+            iter != raylist->end(); ++iter, ++saved )
+    {
+        BOOST_CHECK_EQUAL( saved->time, iter->time ) ;
+        BOOST_CHECK_EQUAL( saved->intensity(0), iter->intensity(0) ) ;
+        BOOST_CHECK_EQUAL( saved->phase(0), iter->phase(0) ) ;
+        BOOST_CHECK_EQUAL( saved->source_de, iter->source_de ) ;
+        BOOST_CHECK_EQUAL( saved->target_de, iter->target_de ) ;
+        BOOST_CHECK_EQUAL( saved->surface, iter->surface ) ;
+        BOOST_CHECK_EQUAL( saved->bottom, iter->bottom ) ;
+        BOOST_CHECK_EQUAL( saved->caustic, iter->caustic ) ;
+    }
+
+    // truncated archives must be rejected instead of read past the end
+
+    {
+        std::ifstream is( arcname, std::ios::in | std::ios::binary ) ;
+        std::vector<char> contents( (std::istreambuf_iterator<char>(is)),
+                                    std::istreambuf_iterator<char>() ) ;
+        const char* cutname = USML_TEST_DIR "/waveq3d/test/eigenray_cut.ray" ;
+        const size_t lengths[] = { 120, contents.size() / 2, contents.size() - 4 } ;
+        for ( unsigned n=0 ; n < 3 ; ++n ) {
+            std::ofstream os( cutname, std::ios::out | std::ios::binary ) ;
+            os.write( &contents[0], lengths[n] ) ;
+            os.close() ;
+            BOOST_CHECK_THROW( eigenray_archive cut(cutname),
+                               std::invalid_argument ) ;
+        }
+    }
+
+    // compare strongest eigenrays to direct and surface paths
+
+    eigenray_list best ;
+    strongest.eigenrays(0,0,best) ;
+    BOOST_CHECK_EQUAL( strongest.size(0,0), 2u ) ;
+    BOOST_REQUIRE_EQUAL( best.size(), 2u ) ;
+    eigenray_list::const_iterator direct = raylist->begin() ;
+    eigenray_list::const_iterator bounce = direct ;
+    ++bounce ;
+    BOOST_CHECK_EQUAL( best.front().time, direct->time ) ;
+    BOOST_CHECK_EQUAL( best.front().intensity(0), direct->intensity(0) ) ;
+    BOOST_CHECK_EQUAL( best.back().time, bounce->time ) ;
+    BOOST_CHECK_EQUAL( best.back().surface, 1 ) ;
 }
 
 /**
@@ -330,6 +395,247 @@ BOOST_AUTO_TEST_CASE( eigenray_concave ) {
     }
 }
 
+/**
+ * Propagate the eigenray_basic scenario with a specific spreading model,
+ * and return the total propagation loss at the target.  The COMPOSITE
+ * model is configured with the criteria given by the caller.
+ */
+static double composite_loss( wave_queue::spreading_type type,
+    double near_range = 0.0, int max_caustics = 0, double width_ratio = 0.0 )
+{
+    wposition::compute_earth_radius( src_lat );
+    attenuation_model* attn = new attenuation_constant(0.0);
+    profile_model* profile = new profile_linear(c0,attn);
+    boundary_model* surface = new boundary_flat();
+    boundary_model* bottom = new boundary_flat(3000.0);
+    ocean_model ocean( surface, bottom, profile );
+
+    seq_log freq( 10e3, 1.0, 1 );
+    wposition1 pos( src_lat, src_lng, -1000.0 );
+    seq_linear de( -60.0, 1.0, 60.0 );
+    seq_linear az( -4.0, 1.0, 4.0 );
+    wposition target( 1, 1, 45.02, src_lng, -1000.0 );
+
+    proploss loss(freq, pos, de, az, time_step, &target);
+    wave_queue wave( ocean, freq, pos, de, az, time_step, &target, type ) ;
+    wave.addProplossListener(&loss);
+    if ( type == wave_queue::COMPOSITE ) {
+        wave.set_spreading_criteria( near_range, max_caustics, width_ratio ) ;
+    }
+    while ( wave.time() < 3.5 ) {
+        wave.step();
+    }
+    loss.sum_eigenrays();
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,0)->size(), 3 ) ;
+    return loss.total(0,0)->intensity(0) ;
+}
+
+/**
+ * Verifies that the COMPOSITE spreading model selects hybrid Gaussian
+ * beams and classic ray theory based on its criteria.  Uses the
+ * eigenray_basic scenario, where the target is 2.2 km from the source.
+ * A near range beyond the target forces the use of Gaussian beams
+ * for all eigenrays, and must reproduce the HYBRID_GAUSSIAN result.
+ * Disabling all three criteria must reproduce the CLASSIC_RAY result.
+ * Also verifies that the criteria can only be set on a COMPOSITE model.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_composite ) {
+    cout << "=== eigenray_test: eigenray_composite ===" << endl;
+
+    const double gaussian = composite_loss( wave_queue::HYBRID_GAUSSIAN ) ;
+    const double ray = composite_loss( wave_queue::CLASSIC_RAY ) ;
+    const double near_ray =
+        composite_loss( wave_queue::COMPOSITE, 1e4, 0, 0.0 ) ;
+    const double far_ray =
+        composite_loss( wave_queue::COMPOSITE, 0.0, 1000, 0.0 ) ;
+
+    cout << "gaussian=" << gaussian << " ray=" << ray
+         << " near=" << near_ray << " far=" << far_ray << endl ;
+    BOOST_CHECK_EQUAL( near_ray, gaussian ) ;
+    BOOST_CHECK_EQUAL( far_ray, ray ) ;
+
+    // criteria are rejected by other spreading models
+
+    ocean_model ocean( new boundary_flat(), new boundary_flat(3000.0),
+        new profile_linear(c0, new attenuation_constant(0.0)) );
+    seq_log freq( 10e3, 1.0, 1 );
+    wposition1 pos( src_lat, src_lng, -1000.0 );
+    seq_linear de( -60.0, 1.0, 60.0 );
+    seq_linear az( -4.0, 1.0, 4.0 );
+    wposition target( 1, 1, 45.02, src_lng, -1000.0 );
+    wave_queue wave( ocean, freq, pos, de, az, time_step, &target ) ;
+    BOOST_CHECK_THROW( wave.set_spreading_criteria( 0.0, 0, 1.0 ),
+                       std::invalid_argument ) ;
+}
+
+/**
+ * Fill an eigenray_list with broadband eigenrays, and then free them.
+ */
+static void fill_eigenrays( unsigned count ) {
+    seq_linear freq( 1000.0, 100.0, 16 );
+    eigenray ray ;
+    ray.frequencies = &freq ;
+    ray.intensity.resize( freq.size() ) ;
+    ray.phase.resize( freq.size() ) ;
+    ray.intensity.clear() ;
+    ray.phase.clear() ;
+    ray.source_de = ray.source_az = ray.target_de = ray.target_az = 0.0 ;
+    ray.surface = ray.bottom = ray.caustic = 0 ;
+
+    eigenray_list list ;
+    for ( unsigned n=0 ; n < count ; ++n ) {
+        ray.time = n * time_step ;
+        list.push_back( ray ) ;
+    }
+    BOOST_CHECK_EQUAL( list.size(), count ) ;
+}
+
+/**
+ * Verifies that the eigenray_arena re-uses the memory of list nodes and
+ * frequency vectors.  The pool is warmed up by another thread, whose
+ * blocks must be returned to the pool when that thread exits.  After
+ * that, filling and freeing the same number of eigenrays in this thread
+ * must not obtain any more memory from the heap.  Released blocks must
+ * be recycled by the next request of the same size.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_arena_test ) {
+    cout << "=== eigenray_test: eigenray_arena_test ===" << endl;
+    const unsigned count = 5000 ;
+
+    // blocks from another thread come back when that thread exits
+
+    boost::thread worker( &fill_eigenrays, count ) ;
+    worker.join() ;
+    const size_t warm = eigenray_arena::reserved() ;
+    BOOST_CHECK( warm > 0 ) ;
+    fill_eigenrays( count ) ;
+    BOOST_CHECK_EQUAL( eigenray_arena::reserved(), warm ) ;
+
+    // the warm pool does not grow when the same eigenrays are created again
+
+    fill_eigenrays( count ) ;
+    fill_eigenrays( count ) ;
+    BOOST_CHECK_EQUAL( eigenray_arena::reserved(), warm ) ;
+
+    // released blocks are recycled by the next request of the same size
+
+    void* first = eigenray_arena::allocate( 24 ) ;
+    eigenray_arena::deallocate( first, 24 ) ;
+    void* second = eigenray_arena::allocate( 24 ) ;
+    BOOST_CHECK_EQUAL( first, second ) ;
+    eigenray_arena::deallocate( second, 24 ) ;
+}
+
+/**
+ * Exposes the eigenray merging of wave_queue, so that duplicate eigenrays
+ * can be injected without relying on the geometry of a specific ray fan.
+ */
+class merge_queue : public wave_queue {
+public:
+    merge_queue( ocean_model& ocean, const seq_vector& freq,
+        const wposition1& pos, const seq_vector& de, const seq_vector& az,
+        const wposition* targets )
+        : wave_queue( ocean, freq, pos, de, az, time_step, targets ) {}
+
+    /** Merge one eigenray with the pending eigenrays for its target. */
+    void merge( unsigned t1, unsigned t2, const eigenray& ray ) {
+        merge_eigenray( t1, t2, ray ) ;
+    }
+
+    /** Deliver the pending eigenrays that arrive before a specific time. */
+    void release( double time ) {
+        release_eigenrays( time ) ;
+        deliver_eigenrays() ;
+    }
+} ;
+
+/**
+ * Verifies that set_eigenray_merge() collapses duplicate eigenrays to
+ * the strongest one, and that flush_eigenrays() releases the eigenrays
+ * that are still pending.  Three eigenrays for the same target, with
+ * the same number of surface, bottom, and caustic interactions, and
+ * within the merge tolerances, must be delivered as the strongest one.
+ * Eigenrays with different interaction counts, eigenrays for other
+ * targets, and eigenrays outside of the travel time tolerance must be
+ * delivered separately.  Nothing is delivered until the pending eigenrays
+ * are released.  Eigenrays given to notifyProplossListeners() must still
+ * be delivered immediately.
+ */
+BOOST_AUTO_TEST_CASE( eigenray_merge ) {
+    cout << "=== eigenray_test: eigenray_merge ===" << endl;
+
+    ocean_model ocean( new boundary_flat(), new boundary_flat(3000.0),
+        new profile_linear(c0, new attenuation_constant(0.0)) );
+    seq_log freq( 10e3, 1.0, 1 );
+    wposition1 pos( src_lat, src_lng, -1000.0 );
+    seq_linear de( -60.0, 1.0, 60.0 );
+    seq_linear az( -4.0, 1.0, 4.0 );
+    wposition target( 1, 2, 45.02, src_lng, -1000.0 );
+
+    proploss loss(freq, pos, de, az, time_step, &target);
+    merge_queue wave( ocean, freq, pos, de, az, &target ) ;
+    wave.addProplossListener(&loss);
+    wave.set_eigenray_merge( 0.01, 1.0, 1.0 ) ;
+
+    eigenray ray ;
+    ray.frequencies = &freq ;
+    ray.intensity.resize( 1 ) ;
+    ray.phase.resize( 1 ) ;
+    ray.phase(0) = 0.0 ;
+    ray.target_de = ray.target_az = 0.0 ;
+    ray.surface = ray.bottom = ray.caustic = 0 ;
+
+    // three duplicates of the same path, strongest in the middle
+
+    ray.time = 1.000 ; ray.source_de = 10.0 ; ray.source_az = 0.0 ;
+    ray.intensity(0) = 70.0 ;
+    wave.merge( 0, 0, ray ) ;
+    ray.time = 1.005 ; ray.source_de = 10.5 ; ray.source_az = 0.5 ;
+    ray.intensity(0) = 65.0 ;
+    wave.merge( 0, 0, ray ) ;
+    ray.time = 1.008 ; ray.source_de = 10.2 ; ray.source_az = 0.2 ;
+    ray.intensity(0) = 72.0 ;
+    wave.merge( 0, 0, ray ) ;
+
+    // paths that are not duplicates of the first one
+
+    ray.time = 1.000 ; ray.source_de = 10.0 ; ray.source_az = 0.0 ;
+    ray.surface = 1 ; ray.intensity(0) = 75.0 ;
+    wave.merge( 0, 0, ray ) ;           // different number of bounces
+    ray.surface = 0 ; ray.intensity(0) = 60.0 ;
+    wave.merge( 0, 1, ray ) ;           // different target
+    ray.time = 1.500 ; ray.intensity(0) = 80.0 ;
+    wave.merge( 0, 0, ray ) ;           // outside of time tolerance
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,0)->size(), 0 ) ;
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,1)->size(), 0 ) ;
+
+    // release the paths that can no longer be merged
+
+    wave.release( 1.2 ) ;
+    BOOST_REQUIRE_EQUAL( loss.eigenrays(0,0)->size(), 2 ) ;
+    BOOST_REQUIRE_EQUAL( loss.eigenrays(0,1)->size(), 1 ) ;
+    const eigenray& strongest = loss.eigenrays(0,0)->front() ;
+    BOOST_CHECK_EQUAL( strongest.intensity(0), 65.0 ) ;
+    BOOST_CHECK_EQUAL( strongest.time, 1.005 ) ;
+    BOOST_CHECK_EQUAL( strongest.source_de, 10.5 ) ;
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,0)->back().surface, 1 ) ;
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,1)->front().intensity(0), 60.0 ) ;
+
+    // flush the path that is still pending
+
+    wave.flush_eigenrays() ;
+    BOOST_REQUIRE_EQUAL( loss.eigenrays(0,0)->size(), 3 ) ;
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,0)->back().time, 1.5 ) ;
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,1)->size(), 1 ) ;
+    wave.flush_eigenrays() ;
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,0)->size(), 3 ) ;
+
+    // eigenrays sent directly to the listeners are not held back
+
+    BOOST_CHECK( wave.notifyProplossListeners( 0, 1, ray ) ) ;
+    BOOST_CHECK_EQUAL( loss.eigenrays(0,1)->size(), 2 ) ;
+}
+
 /**
  * Scenario is the exact same as eigenray_basic, except that the
  * number of targets is increased. This allows us to verify the
@@ -489,8 +795,11 @@ BOOST_AUTO_TEST_CASE( eigenray_tl_grid ) {
     }
 
     proploss loss(freq, pos, de, az, time_step, &target);
+    proploss stream(freq, pos, de, az, time_step, &target);
+    stream.stream_eigenrays();
     wave_queue wave( ocean, freq, pos, de, az, time_step, &target) ;
     wave.addProplossListener(&loss);
+    wave.addProplossListener(&stream);
 
     // propagate rays and record wavefronts to disk.
 
@@ -511,6 +820,23 @@ BOOST_AUTO_TEST_CASE( eigenray_tl_grid ) {
     cout << "writing proploss to " << ncname << endl;
     loss.write_netcdf(ncname,"eigenray_tl_az test");
 
+    // streaming mode must match the sum of the stored eigenrays
+
+    stream.sum_eigenrays();
+    for ( int n=0 ; n < num_targets ; ++n ) {
+        for ( int m=0 ; m < num_alts ; ++m ) {
+            BOOST_CHECK_EQUAL( stream.eigenrays(n,m)->size(), 0 ) ;
+            if ( loss.eigenrays(n,m)->empty() ) continue ;
+            const eigenray* expected = loss.total(n,m) ;
+            const eigenray* actual = stream.total(n,m) ;
+            BOOST_CHECK_CLOSE( actual->intensity(0), expected->intensity(0), 1e-8 ) ;
+            BOOST_CHECK_SMALL( actual->phase(0) - expected->phase(0), 1e-8 ) ;
+            BOOST_CHECK_CLOSE( actual->time, expected->time, 1e-8 ) ;
+            BOOST_CHECK_EQUAL( actual->surface, expected->surface ) ;
+            BOOST_CHECK_EQUAL( actual->bottom, expected->bottom ) ;
+        }
+    }
+
     // save results to spreadsheet and compare to analytic results
 
     cout << "writing tables to " << csvname << endl;
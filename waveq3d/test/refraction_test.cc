@@ -1171,6 +1171,100 @@ BOOST_AUTO_TEST_CASE( surface_duct_test ) {
 //    wave.close_netcdf();
 //}
 
+/**
+ * Records a short isovelocity propagation to a decimated wavefront log,
+ * and reads it back to check the background converter thread.  Every 3rd
+ * wavefront, every 2nd D/E ray, and every 3rd AZ ray is recorded.
+ * The run saves more wavefronts than there are snapshots in the
+ * logger's ring, so that save() must wait for the converter to catch up.
+ * Closing the log must flush every pending snapshot before the file
+ * is read back.  A BOOST error is thrown if the dimensions, coordinates,
+ * or recorded positions do not match the wavefronts that were saved.
+ * Decimation factors of zero must be rejected.
+ */
+BOOST_AUTO_TEST_CASE(wavefront_logger_test) {
+    cout << "=== refraction_test: wavefront_logger_test ===" << endl;
+    const char* ncname_wave = USML_TEST_DIR "/waveq3d/test/wavefront_logger.nc";
+
+    // initialize propagation model
+
+    profile_model* profile = new profile_linear(1500.0);
+    boundary_model* surface = new boundary_flat();
+    boundary_model* bottom = new boundary_flat(5000.0);
+    ocean_model ocean(surface, bottom, profile);
+
+    wposition1 pos(45.0, -45.0, -1000.0);
+    seq_linear de(-20.0, 10.0, 20.0);   // 5 rays, 3 recorded
+    seq_linear az(0.0, 30.0, 90.0);     // 4 rays, 2 recorded
+    wave_queue wave(ocean, freq, pos, de, az, time_step);
+
+    BOOST_CHECK_THROW( wave.init_netcdf(ncname_wave, NULL, 0),
+                       std::invalid_argument );
+    BOOST_CHECK_THROW( wave.init_netcdf(ncname_wave, NULL, 1, 0),
+                       std::invalid_argument );
+    BOOST_CHECK_THROW( wave.init_netcdf(ncname_wave, NULL, 1, 1, 0),
+                       std::invalid_argument );
+
+    // record 31 wavefronts, and keep a copy of every 3rd one
+
+    const unsigned every_time = 3, every_de = 2, every_az = 3;
+    const unsigned num_de = 3, num_az = 2, num_time = 11;
+    vector<double> times(num_time);
+    matrix<double> latitude(num_time, num_de * num_az);
+    matrix<double> altitude(num_time, num_de * num_az);
+
+    cout << "writing wavefronts to " << ncname_wave << endl;
+    wave.init_netcdf(ncname_wave, NULL, every_time, every_de, every_az);
+    for (unsigned n = 0; n < every_time * (num_time - 1) + 1; ++n) {
+        if (n > 0) wave.step();
+        wave.save_netcdf();
+        if (n % every_time) continue;
+        const unsigned t = n / every_time;
+        times(t) = wave.time();
+        for (unsigned d = 0; d < num_de; ++d) {
+            for (unsigned a = 0; a < num_az; ++a) {
+                latitude(t, d * num_az + a) = wave.curr()->position.latitude(
+                    d * every_de, a * every_az);
+                altitude(t, d * num_az + a) = wave.curr()->position.altitude(
+                    d * every_de, a * every_az);
+            }
+        }
+    }
+    wave.close_netcdf();        // writes all of the pending records
+
+    // read the log back, and compare it to the saved wavefronts
+
+    NcFile file(ncname_wave);
+    BOOST_REQUIRE(file.is_valid());
+    BOOST_CHECK_EQUAL(file.get_dim("source_de")->size(), (long) num_de);
+    BOOST_CHECK_EQUAL(file.get_dim("source_az")->size(), (long) num_az);
+    BOOST_CHECK_EQUAL(file.get_dim("travel_time")->size(), (long) num_time);
+
+    double source_de[num_de], source_az[num_az];
+    file.get_var("source_de")->get(source_de, num_de);
+    file.get_var("source_az")->get(source_az, num_az);
+    for (unsigned d = 0; d < num_de; ++d) {
+        BOOST_CHECK_CLOSE(source_de[d], de(d * every_de), 1e-10);
+    }
+    for (unsigned a = 0; a < num_az; ++a) {
+        BOOST_CHECK_CLOSE(source_az[a], az(a * every_az), 1e-10);
+    }
+
+    double travel_time[num_time];
+    double lat[num_time][num_de * num_az];
+    double alt[num_time][num_de * num_az];
+    file.get_var("travel_time")->get(travel_time, num_time);
+    file.get_var("latitude")->get(&lat[0][0], num_time, num_de, num_az);
+    file.get_var("altitude")->get(&alt[0][0], num_time, num_de, num_az);
+    for (unsigned t = 0; t < num_time; ++t) {
+        BOOST_CHECK_CLOSE(travel_time[t] + 1.0, times(t) + 1.0, 1e-10);
+        for (unsigned n = 0; n < num_de * num_az; ++n) {
+            BOOST_CHECK_CLOSE(lat[t][n], latitude(t, n), 1e-10);
+            BOOST_CHECK_CLOSE(alt[t][n], altitude(t, n), 1e-10);
+        }
+    }
+}
+
 /// @}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -173,32 +173,43 @@ void wave_front::update() {
  */
 void wave_front::find_edges() {
     on_edge.clear() ;
+    const unsigned n_az = num_az() ;
     const unsigned max_de = num_de() - 1 ;
 
     // mark the perimeter of the ray fan
     // also treat the case where num_de()=1 or num_az()=1
 
-    for ( unsigned az=0 ; az < num_az() ; ++az ) {
-        on_edge(0,az) = on_edge(max_de,az) = true ;
+    bool* edge = &on_edge.data()[0] ;
+    for ( unsigned az=0 ; az < n_az ; ++az ) {
+        edge[az] = edge[max_de*n_az+az] = true ;
     }
 
     // search for changes around each (de,az)
-    // skip by 2 to avoid counting each change twice
-
-    for ( unsigned az=0 ; az < num_az() ; az += 1 ) {
-        for ( unsigned de=1 ; de < max_de ; de += 1 ) {
-            if ( (position.rho(de,az) < position.rho(de+1,az) &&
-                  position.rho(de,az) < position.rho(de-1,az)) ||
-                 (position.rho(de,az) > position.rho(de+1,az) &&
-                  position.rho(de,az) > position.rho(de-1,az)) ) {
-                    on_edge(de,az) = true;
-                    if( abs(ndirection.rho(de,az)-ndirection.rho(de-1,az)) >
-                        abs(ndirection.rho(de,az)-ndirection.rho(de+1,az)) ) {
-                            on_edge(de-1,az) = true;
-                    } else {
-                            on_edge(de+1,az) = true;
-                    }
-            }
+    // works on contiguous rows of constant D/E so that the inner loop
+    // is branch-free and can be vectorized across the AZ dimension
+    // on_edge values are only ever set, so row order does not matter
+
+    const double* rho = &position.rho().data()[0] ;
+    const double* ndir = &ndirection.rho().data()[0] ;
+    for ( unsigned de=1 ; de < max_de ; ++de ) {
+        const unsigned row = de * n_az ;
+        const double* r = rho + row ;
+        const double* r_lo = r - n_az ;
+        const double* r_hi = r + n_az ;
+        const double* n = ndir + row ;
+        const double* n_lo = n - n_az ;
+        const double* n_hi = n + n_az ;
+        bool* e = edge + row ;
+        bool* e_lo = e - n_az ;
+        bool* e_hi = e + n_az ;
+        for ( unsigned az=0 ; az < n_az ; ++az ) {
+            const bool turn = ( (r[az] < r_hi[az]) & (r[az] < r_lo[az]) )
+                            | ( (r[az] > r_hi[az]) & (r[az] > r_lo[az]) ) ;
+            const bool lower = abs( n[az] - n_lo[az] )
+                             > abs( n[az] - n_hi[az] ) ;
+            e[az] = e[az] | turn ;
+            e_lo[az] = e_lo[az] | ( turn & lower ) ;
+            e_hi[az] = e_hi[az] | ( turn & !lower ) ;
         }
     }
 }
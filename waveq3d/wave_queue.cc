@@ -7,6 +7,7 @@
 #include <usml/waveq3d/reflection_model.h>
 #include <usml/waveq3d/spreading_ray.h>
 #include <usml/waveq3d/spreading_hybrid_gaussian.h>
+#include <usml/waveq3d/spreading_composite.h>
 
 
 #include <boost/numeric/ublas/vector_proxy.hpp>
@@ -14,6 +15,7 @@
 #include <boost/numeric/ublas/lu.hpp>
 
 #include <iomanip>
+#include <stdexcept>
 
 //#define DEBUG_OUTPUT_EIGENRAYS
 //#define DEBUG_EIGENRAYS
@@ -43,7 +45,11 @@ wave_queue::wave_queue(
     _time_step( time_step ),
     _time( 0.0 ),
     _targets(targets),
-    _nc_file( NULL )
+    _batch_size( 0 ),
+    _merge_time( 0.0 ),
+    _merge_de( 0.0 ),
+    _merge_az( 0.0 ),
+    _nc_log( NULL )
 {
 
 	// create references between targets and wavefront objects.
@@ -59,10 +65,12 @@ wave_queue::wave_queue(
         _az_boundary = false ;
     }
     _intensity_threshold = 300.00; // -300 db Store internally as positive value
+    _caustic_fold.resize( az.size() ) ;
 
     if ( _targets ) {
     	_targets_sin_theta = sin( _targets->theta() ) ;
     	pTargets_sin_theta = &_targets_sin_theta;
+        init_targets() ;
     }
 
     // create storage space for all wavefront elements
@@ -84,6 +92,9 @@ wave_queue::wave_queue(
             case HYBRID_GAUSSIAN :
                 _spreading_model = new spreading_hybrid_gaussian( *this ) ;
                 break ;
+            case COMPOSITE :
+                _spreading_model = new spreading_composite( *this ) ;
+                break ;
             default :
                 _spreading_model = new spreading_ray( *this ) ;
                 break ;
@@ -91,8 +102,30 @@ wave_queue::wave_queue(
     }
 }
 
+/**
+ * Build the per-target tables used during eigenray detection.
+ */
+void wave_queue::init_targets() {
+    const unsigned n1 = _targets->size1() ;
+    const unsigned n2 = _targets->size2() ;
+    _targets_sound_speed.resize( n1, n2 ) ;
+    _ocean.profile().sound_speed( *_targets, &_targets_sound_speed ) ;
+
+    _targets_on_source.resize( n1, n2 ) ;
+    const double lat = _source_pos.latitude() ;
+    const double lng = _source_pos.longitude() ;
+    for ( unsigned t1=0 ; t1 < n1 ; ++t1 ) {
+        for ( unsigned t2=0 ; t2 < n2 ; ++t2 ) {
+            _targets_on_source(t1,t2) =
+                abs( lat - _targets->latitude(t1,t2) ) < 1e-4 &&
+                abs( lng - _targets->longitude(t1,t2) ) < 1e-4 ;
+        }
+    }
+}
+
 /** Destroy all temporary memory. */
 wave_queue::~wave_queue() {
+    close_netcdf() ;
     delete _frequencies ;
     if ( _spreading_model ) delete _spreading_model ;
     delete _reflection_model ;
@@ -196,8 +229,14 @@ void wave_queue::step() {
     _next->caustic = _curr->caustic ;
 
     // search for eigenray collisions with acoustic targets
+    // eigenray times are limited to one time step around _curr,
+    // so older eigenrays can no longer be merged with new ones
 
     detect_eigenrays() ;
+    if ( ! _pending_eigenrays.empty() ) {
+        release_eigenrays( _time - _merge_time ) ;
+    }
+    deliver_eigenrays() ;
 }
 
 /**
@@ -284,21 +323,44 @@ bool wave_queue::detect_reflections_bottom( unsigned de, unsigned az ) {
  *  Detects and processes the caustics along the next wavefront
  */
 void wave_queue::detect_caustics() {
+    const unsigned n_az = num_az() ;
     const unsigned max_de = num_de() - 1 ;
+    const double* curr_rho = &_curr->position.rho().data()[0] ;
+    const double* next_rho = &_next->position.rho().data()[0] ;
+    const int* surface = &_next->surface.data()[0] ;
+    const int* bottom = &_next->bottom.data()[0] ;
+    int* caustic = &_next->caustic.data()[0] ;
+    unsigned char* fold = &_caustic_fold[0] ;
+
+    for ( unsigned d=1 ; d < max_de ; ++d ) {
+
+        // branch-free search along a contiguous row of constant D/E
+        // a caustic exists where the rho ordering of adjacent rays flips,
+        // and both rays have the same surface and bottom counts
+
+        const unsigned row = d * n_az ;
+        const unsigned up = row + n_az ;
+        unsigned char found = 0 ;
+        for ( unsigned a=0 ; a < n_az ; ++a ) {
+            const double A = curr_rho[up+a] ;
+            const double B = curr_rho[row+a] ;
+            const double C = next_rho[up+a] ;
+            const double D = next_rho[row+a] ;
+            fold[a] = ( (C-D)*(A-B) < 0.0 )
+                    & ( surface[up+a] == surface[row+a] )
+                    & ( bottom[up+a] == bottom[row+a] ) ;
+            caustic[up+a] += fold[a] ;
+            found |= fold[a] ;
+        }
+
+        // apply the phase change in a second pass
 
-    for ( unsigned a=0 ; a < num_az() ; a++ ) {
-        for ( unsigned d=1 ; d < max_de ; d++ ) {
-            double A = _curr->position.rho(d+1,a) ;
-            double B = _curr->position.rho(d,a) ;
-            double C = _next->position.rho(d+1,a) ;
-            double D = _next->position.rho(d,a) ;
-            bool fold = false ;
-            if ( (_next->surface(d+1,a) == _next->surface(d,a)) &&
-                 (_next->bottom(d+1,a) == _next->bottom(d,a)) ) { fold = true; }
-            if ( (C-D)*(A-B) < 0 && fold ) {
-                _next->caustic(d+1,a)++;
+        if ( found ) {
+            for ( unsigned a=0 ; a < n_az ; ++a ) {
+                if ( !fold[a] ) continue ;
+                vector<double>& phase = _next->phase(d+1,a) ;
                 for (unsigned f = 0; f < _frequencies->size(); ++f) {
-                    _next->phase(d+1,a)(f) -= M_PI_2;
+                    phase(f) -= M_PI_2;
                 }
             }
         }
@@ -322,11 +384,7 @@ void wave_queue::detect_eigenrays() {
     // loop over all targets
     for ( unsigned t1=0 ; t1 < _targets->size1() ; ++t1 ) {
         for ( unsigned t2=0 ; t2 < _targets->size2() ; ++t2 ) {
-            _de_branch = false ;
-            if ( abs(_source_pos.latitude() - _targets->latitude(t1,t2)) < 1e-4 &&
-                 abs(_source_pos.longitude() - _targets->longitude(t1,t2)) < 1e-4 ) {
-                _de_branch = true ;
-            }
+            _de_branch = _targets_on_source(t1,t2) ;
 
             // Loop over all rays
             for ( unsigned de=1 ; de < num_de() - 1 ; ++de ) {
@@ -678,9 +736,8 @@ void wave_queue::build_eigenray(
 
     // compute spreading components of intensity
 
-    const vector<double> spread_intensity =
-        _spreading_model->intensity(
-            wposition1( *(_curr->targets), t1, t2 ), de, az, offset, distance );
+    const vector<double>& spread_intensity =
+        _spreading_model->intensity( t1, t2, de, az, offset, distance );
     if ( isnan(spread_intensity(0)) ) {
         #ifdef DEBUG_EIGENRAYS
             std::cerr << "warning: wave_queue::build_eigenray()"  << endl
@@ -863,7 +920,11 @@ void wave_queue::build_eigenray(
     #endif
 
     // Add eigenray to those objects which requested them
-    notifyProplossListeners(t1,t2,ray);
+    if ( _merge_time > 0.0 ) {
+        merge_eigenray(t1,t2,ray);
+    } else {
+        queue_eigenray(t1,t2,ray);
+    }
 
 }
 
@@ -1051,12 +1112,145 @@ bool wave_queue::removeProplossListener(proplossListener* pListener){
  * call the addEigenray method to provide eigenrays.
  */
 bool wave_queue::notifyProplossListeners(unsigned targetRow, unsigned targetCol, eigenray pEigenray){
-
-	for (std::vector<proplossListener*>::iterator iter = _proplossListenerVec.begin();
-												iter != _proplossListenerVec.end(); ++iter){
-		proplossListener* proploss = *iter;
-		proploss->addEigenray(targetRow, targetCol, pEigenray);
+	if ( ! queue_eigenray( targetRow, targetCol, pEigenray ) ) {
+		return false;
 	}
+	deliver_eigenrays();
+	return true;
+}
+
+/**
+ * Queue an eigenray for delivery to all proplossListener(s).
+ */
+bool wave_queue::queue_eigenray( unsigned t1, unsigned t2, const eigenray& ray ) {
+    if ( _proplossListenerVec.empty() ) {
+        return false ;
+    }
+    if ( _batch_size == _batch.size() ) {
+        _batch.push_back( target_eigenray() ) ;
+    }
+    target_eigenray& entry = _batch[_batch_size++] ;
+    entry.row = t1 ;
+    entry.col = t2 ;
+    entry.ray = ray ;
+    return true ;
+}
+
+/**
+ * Deliver the current batch of eigenrays to all proplossListener(s).
+ */
+void wave_queue::deliver_eigenrays() {
+    if ( _batch_size == 0 ) return ;
+    for ( std::vector<proplossListener*>::iterator iter = _proplossListenerVec.begin() ;
+          iter != _proplossListenerVec.end() ; ++iter )
+    {
+        (*iter)->addEigenrays( &_batch[0], _batch_size ) ;
+    }
+    _batch_size = 0 ;
+}
+
+/**
+ * Merge nearly identical eigenrays before they are sent to the
+ * proplossListener(s).
+ */
+void wave_queue::set_eigenray_merge( double time, double de, double az ) {
+    flush_eigenrays() ;
+    _merge_time = abs(time) ;
+    _merge_de = abs(de) ;
+    _merge_az = abs(az) ;
+}
+
+/**
+ * Define the conditions under which the COMPOSITE spreading model
+ * uses hybrid Gaussian beams.
+ */
+void wave_queue::set_spreading_criteria(
+    double near_range, int max_caustics, double width_ratio )
+{
+    spreading_composite* model =
+        dynamic_cast<spreading_composite*>( _spreading_model ) ;
+    if ( model == NULL ) {
+        throw std::invalid_argument(
+            "spreading criteria require the COMPOSITE spreading model" ) ;
+    }
+    model->criteria( near_range, max_caustics, width_ratio ) ;
+}
+
+/**
+ * Send all eigenrays that are waiting to be merged to the
+ * proplossListener(s).
+ */
+void wave_queue::flush_eigenrays() {
+    for ( pending_map::const_iterator target = _pending_eigenrays.begin() ;
+          target != _pending_eigenrays.end() ; ++target )
+    {
+        for ( eigenray_list::const_iterator iter = target->second.begin() ;
+              iter != target->second.end() ; ++iter )
+        {
+            queue_eigenray( target->first.first,
+                            target->first.second, *iter ) ;
+        }
+    }
+    _pending_eigenrays.clear() ;
+    deliver_eigenrays() ;
+}
 
-	return (_proplossListenerVec.size() > 0);
+/**
+ * Combine a new eigenray with any duplicates that are waiting
+ * to be sent to the proplossListener(s).
+ */
+void wave_queue::merge_eigenray(
+    unsigned t1, unsigned t2, const eigenray& ray )
+{
+    eigenray_list& pending = _pending_eigenrays[ std::make_pair(t1,t2) ] ;
+    for ( eigenray_list::iterator iter = pending.begin() ;
+          iter != pending.end() ; ++iter )
+    {
+        eigenray& other = *iter ;
+        if ( other.surface == ray.surface
+             && other.bottom == ray.bottom
+             && other.caustic == ray.caustic
+             && abs( other.time - ray.time ) <= _merge_time
+             && abs( other.source_de - ray.source_de ) <= _merge_de
+             && abs( other.source_az - ray.source_az ) <= _merge_az )
+        {
+            #ifdef DEBUG_EIGENRAYS
+                cout << "*** wave_queue::merge_eigenray: target("
+                     << t1 << "," << t2 << ") t=" << ray.time
+                     << " de=" << ray.source_de
+                     << " az=" << ray.source_az << endl ;
+            #endif
+            if ( ray.intensity(0) < other.intensity(0) ) {
+                other = ray ;   // keep the strongest path
+            }
+            return ;
+        }
+    }
+    pending.push_back( ray ) ;
+}
+
+/**
+ * Send eigenrays that arrive before a specific time to the
+ * proplossListener(s).
+ */
+void wave_queue::release_eigenrays( double time ) {
+    pending_map::iterator target = _pending_eigenrays.begin() ;
+    while ( target != _pending_eigenrays.end() ) {
+        eigenray_list& pending = target->second ;
+        eigenray_list::iterator iter = pending.begin() ;
+        while ( iter != pending.end() ) {
+            if ( iter->time < time ) {
+                queue_eigenray( target->first.first,
+                                target->first.second, *iter ) ;
+                iter = pending.erase( iter ) ;
+            } else {
+                ++iter ;
+            }
+        }
+        if ( pending.empty() ) {
+            _pending_eigenrays.erase( target++ ) ;
+        } else {
+            ++target ;
+        }
+    }
 }
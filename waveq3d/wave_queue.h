@@ -10,6 +10,7 @@
 #include <usml/waveq3d/wave_front.h>
 #include <usml/waveq3d/proplossListener.h>
 #include <netcdfcpp.h>
+#include <map>
 
 namespace usml {
 namespace waveq3d {
@@ -20,7 +21,9 @@ class reflection_model ;
 class spreading_model ;
 class spreading_ray ;
 class spreading_hybrid_gaussian ;
+class spreading_composite ;
 class proplossListener ;
+class wavefront_logger ;
 
 /// @ingroup waveq3d
 /// @{
@@ -65,6 +68,7 @@ class USML_DECLSPEC wave_queue {
     friend class reflection_model ;
     friend class spreading_ray ;
     friend class spreading_hybrid_gaussian ;
+    friend class spreading_composite ;
 
   private:
 
@@ -119,6 +123,20 @@ class USML_DECLSPEC wave_queue {
 	 */
 	matrix<double> _targets_sin_theta ;
 
+    /**
+     * Speed of sound at each target location.  Targets are fixed for
+     * the life of the wave_queue, so this is computed once,
+     * in the constructor, and shared by the spreading models.
+     */
+    matrix<double> _targets_sound_speed ;
+
+    /**
+     * True for targets that are directly above or below the source.
+     * Used by detect_eigenrays() to enable D/E branch detection without
+     * re-computing the target latitude and longitude on each time step.
+     */
+    matrix<bool> _targets_on_source ;
+
     /** Reference to the reflection loss model component. */
     reflection_model* _reflection_model ;
 
@@ -169,12 +187,47 @@ class USML_DECLSPEC wave_queue {
      */
     bool _de_branch ;
 
+    /**
+     * Flags the rays in one row of constant D/E that have passed through
+     * a caustic on this time step. (temp workspace for detect_caustics)
+     */
+    vector<unsigned char> _caustic_fold ;
+
+    /** Eigenrays waiting to be merged, keyed by target row and column. */
+    typedef std::map< std::pair<unsigned,unsigned>, eigenray_list > pending_map ;
+
+    /**
+     * Eigenrays waiting to be merged with duplicates from later
+     * time steps or neighboring rays. (see merge_eigenray)
+     * Keyed by target, so that each new eigenray is only compared to
+     * the pending eigenrays for its own target.  Targets are removed
+     * when they have no pending eigenrays left.
+     */
+    pending_map _pending_eigenrays ;
+
+    /**
+     * Eigenrays waiting to be delivered to the proplossListener(s) at
+     * the end of the current time step.  Entries are re-used from one
+     * time step to the next, so that their storage is only allocated once.
+     */
+    std::vector< target_eigenray > _batch ;
+
+    /** Number of entries in _batch that are in use. */
+    unsigned _batch_size ;
+
+    /**
+     * Tolerances used to decide that two eigenrays are duplicates:
+     * travel time (sec), source D/E (deg), and source AZ (deg).
+     * Merging is disabled when _merge_time is zero.
+     */
+    double _merge_time, _merge_de, _merge_az ;
+
   public:
 
     /**
      * Type of spreading model to be used.
      */
-    typedef enum { CLASSIC_RAY, HYBRID_GAUSSIAN } spreading_type ;
+    typedef enum { CLASSIC_RAY, HYBRID_GAUSSIAN, COMPOSITE } spreading_type ;
 
     //**************************************************
     // methods
@@ -198,8 +251,10 @@ class USML_DECLSPEC wave_queue {
      *                      include rays for both 0 and 360 degrees.
      * @param  time_step    Propagation step size (seconds).
      * @param  targets      List of acoustic targets.
-     * @param  type         Type of spreading model to use: CLASSIC_RAY
-     *                      or HYBRID_GAUSSIAN.
+     * @param  type         Type of spreading model to use: CLASSIC_RAY,
+     *                      HYBRID_GAUSSIAN, or COMPOSITE.  The COMPOSITE
+     *                      model selects one of the other two for each
+     *                      eigenray (see set_spreading_criteria).
      */
     wave_queue(
         ocean_model& ocean,
@@ -333,11 +388,69 @@ class USML_DECLSPEC wave_queue {
     bool removeProplossListener(proplossListener* pListener);
 
     /**
-     * For each proplossListener in the _proplossListenerVec vector
-     * call the addEigenray method to provide eigenrays.
+     * Send an eigenray to each proplossListener in the
+     * _proplossListenerVec vector right away.  Any eigenrays that are
+     * already queued for the current time step are delivered first,
+     * so that each listener sees the eigenrays in order.  The eigenrays
+     * found by step() are queued by queue_eigenray() instead.
+     *
+     * @return  True if there are any listeners.
      */
     bool notifyProplossListeners(unsigned targetRow, unsigned targetCol, eigenray pEigenray);
 
+    /**
+     * Merge nearly identical eigenrays before they are sent to the
+     * proplossListener(s).  Near branch points and the edges of the ray fan,
+     * detect_eigenrays() often finds the same path several times, in
+     * consecutive time steps, or in neighboring D/E and AZ cells.
+     * Two eigenrays for the same target are considered to be duplicates if
+     * they have the same number of surface, bottom, and caustic
+     * interactions, and if their travel time, source D/E, and source AZ
+     * are all within the tolerances given here.  Only the strongest
+     * eigenray in each group, based on the intensity at the first
+     * frequency, is sent to the listeners.
+     *
+     * Eigenrays are held back until no later time step can produce a
+     * duplicate.  The user is responsible for calling flush_eigenrays()
+     * after the last call to step(), and before the listeners use
+     * their results (ex: proploss::sum_eigenrays()).
+     *
+     * @param   time        Travel time tolerance (sec).
+     *                      Merging is disabled if this is zero (default).
+     * @param   de          Source D/E tolerance (degrees).
+     * @param   az          Source AZ tolerance (degrees).
+     */
+    void set_eigenray_merge( double time, double de, double az ) ;
+
+    /**
+     * Define the conditions under which the COMPOSITE spreading model
+     * uses hybrid Gaussian beams instead of classic ray theory.
+     * Hybrid Gaussian beams are used if the target is closer than the
+     * near range, if the path has more caustics than max_caustics, or
+     * if the wavefront cell at the point of collision is narrower than
+     * width_ratio times the evanescent spreading width (2 pi lambda) at
+     * the lowest frequency.  Classic ray theory is used for all other
+     * eigenrays, which is much faster for long range targets.
+     *
+     * @param   near_range      Use Gaussian beams for targets closer
+     *                          than this range (meters). Default is zero.
+     * @param   max_caustics    Use Gaussian beams for paths with more
+     *                          caustics than this. Default is zero.
+     * @param   width_ratio     Use Gaussian beams when cells are narrower
+     *                          than this many spreading widths.
+     *                          Default is one.
+     * @throws  std::invalid_argument if the spreading model
+     *          is not COMPOSITE.
+     */
+    void set_spreading_criteria(
+        double near_range, int max_caustics, double width_ratio ) ;
+
+    /**
+     * Send all eigenrays that are waiting to be merged, or waiting
+     * for the end of the time step, to the proplossListener(s).
+     */
+    void flush_eigenrays() ;
+
   private:
 
     /**
@@ -357,6 +470,15 @@ class USML_DECLSPEC wave_queue {
      */
     void init_wavefronts() ;
 
+    /**
+     * Build the tables of target properties that do not change during
+     * propagation: the speed of sound at each target, and a flag for
+     * targets that are co-located with the source.  Computing these once,
+     * at construction, avoids repeating profile and coordinate
+     * conversions for every eigenray.
+     */
+    void init_targets() ;
+
   public:
 
     /**
@@ -544,6 +666,53 @@ class USML_DECLSPEC wave_queue {
         unsigned de, unsigned az,
         double distance2[3][3][3] ) ;
 
+  protected:
+
+    // eigenray merging is protected so that sub-classes, and the unit
+    // tests, can inject eigenrays without relying on ray fan geometry
+
+    /**
+     * Used by build_eigenray() to combine a new eigenray with any duplicates
+     * that are waiting to be sent to the proplossListener(s).
+     * (see set_eigenray_merge)
+     *
+     * @param   t1          Row number of the current target.
+     * @param   t2          Column number of the current target.
+     * @param   ray         Eigenray to be merged.
+     */
+    void merge_eigenray( unsigned t1, unsigned t2, const eigenray& ray ) ;
+
+    /**
+     * Send eigenrays that arrive before a specific time to the
+     * proplossListener(s).
+     *
+     * @param   time        Travel time before which eigenrays can no
+     *                      longer be merged with new eigenrays (sec).
+     */
+    void release_eigenrays( double time ) ;
+
+    /**
+     * Queue an eigenray for delivery to each proplossListener in the
+     * _proplossListenerVec vector.  Eigenrays are delivered in batches,
+     * through the addEigenrays() method of each listener, at the end of
+     * each time step, or when flush_eigenrays() is called.  This replaces
+     * a virtual call, and a copy of the eigenray, for each listener and
+     * path, with one call per listener and time step.
+     *
+     * @param   t1          Row number of the current target.
+     * @param   t2          Column number of the current target.
+     * @param   ray         Eigenray to be delivered.
+     * @return              True if there are any listeners.
+     */
+    bool queue_eigenray( unsigned t1, unsigned t2, const eigenray& ray ) ;
+
+    /**
+     * Deliver the current batch of eigenrays to all proplossListener(s).
+     */
+    void deliver_eigenrays() ;
+
+  private:
+
     /**
      * Find relative offsets and true distances in time, D/E, and AZ.
      * Uses the analytic solution for the inverse of a symmetric 3x3 matrix
@@ -623,17 +792,10 @@ class USML_DECLSPEC wave_queue {
   private:
 
     /**
-     * The netCDF file used to record the wavefront log.
+     * Logger used to record the wavefront log.
      * Reset to NULL when not initialized.
      */
-    NcFile* _nc_file ;
-
-    /** The netCDF variables used to record the wavefront log. */
-    NcVar *_nc_time, *_nc_latitude, *_nc_longitude, *_nc_altitude,
-          *_nc_surface, *_nc_bottom, *_nc_caustic, *_nc_on_edge;
-
-    /** Current record number in netDCF file. */
-    int _nc_rec ;
+    wavefront_logger* _nc_log ;
 
   public:
 
@@ -686,20 +848,44 @@ class USML_DECLSPEC wave_queue {
      *      altitude = -75, -75, -75, ...
      *   }
      * </pre>
+     *
+     * Records are converted to geodetic coordinates by a background
+     * thread, so that propagation can continue while the previous
+     * wavefronts are being converted (see wavefront_logger).  Converted
+     * records are written to disk by the propagation thread, during later
+     * calls to save_netcdf() and close_netcdf(), because the netCDF
+     * library is not thread safe.  The log can also be
+     * decimated in time and launch angle to reduce its size.  Setting
+     * the single flag stores latitude, longitude, and altitude as float
+     * instead of double, which halves the size of the log.  The float
+     * values are accurate to about 1 meter horizontally, and to about
+     * 1 millimeter in altitude, which is adequate for visualization.
+     *
      * @param   filename    Name of the file to write to disk.
      * @param   long_name   Optional global attribute for identifying data-set.
+     * @param   every_time  Record one out of every N calls to save_netcdf().
+     * @param   every_de    Record one out of every N rays in D/E direction.
+     * @param   every_az    Record one out of every N rays in AZ direction.
+     * @param   single      Store positions as float, if true.
+     * @throws  std::invalid_argument if any decimation factor is zero.
      */
-    void init_netcdf( const char* filename, const char* long_name=NULL ) ;
+    void init_netcdf( const char* filename, const char* long_name=NULL,
+        unsigned every_time=1, unsigned every_de=1, unsigned every_az=1,
+        bool single=false ) ;
 
     /**
      * Write current record to netCDF wavefront log.
      * Records travel time, latitude, longtiude, altitude for
-     * the current wavefront.
+     * the current wavefront.  Copies the current wavefront, writes any
+     * records that have already been converted, and returns without
+     * waiting for the conversion to finish, unless the converter thread
+     * has fallen too far behind.
      */
     void save_netcdf() ;
 
     /**
-     * Close netCDF wavefront log.
+     * Close netCDF wavefront log.  Waits for all pending records to be
+     * written.  Must be called before any other netCDF files are accessed.
      */
     void close_netcdf() ;
 
@@ -0,0 +1,297 @@
+/**
+ * @file wavefront_logger.cc
+ * Records wavefronts to a netCDF log, with the help of a background thread.
+ */
+#include <usml/waveq3d/wavefront_logger.h>
+#include <boost/numeric/ublas/matrix_proxy.hpp>
+#include <boost/bind.hpp>
+#include <stdexcept>
+
+using namespace usml::waveq3d ;
+
+/**
+ * Check that a decimation factor or buffer count is positive.
+ */
+static unsigned positive( unsigned value ) {
+    if ( value == 0 ) {
+        throw std::invalid_argument(
+            "wavefront log decimation and buffers must be positive") ;
+    }
+    return value ;
+}
+
+/**
+ * Number of rays left after recording one out of every N rays.
+ */
+static unsigned decimate( unsigned size, unsigned every ) {
+    return ( size + positive( every ) - 1 ) / every ;
+}
+
+/**
+ * Opens the file, records initial conditions, and starts the converter thread.
+ */
+wavefront_logger::wavefront_logger(
+    const char* filename, const char* long_name,
+    const seq_vector& freq, const seq_vector& de, const seq_vector& az,
+    unsigned every_time, unsigned every_de, unsigned every_az,
+    bool single, unsigned num_buffers
+) :
+    _num_de( decimate( de.size(), every_de ) ),
+    _num_az( decimate( az.size(), every_az ) ),
+    _every_time( positive( every_time ) ),
+    _every_de( every_de ),
+    _every_az( every_az ),
+    _single( single ),
+    _calls( 0 ),
+    _ring( positive( num_buffers ) ),
+    _head( 0 ),
+    _next( 0 ),
+    _tail( 0 ),
+    _pending( 0 ),
+    _converted( 0 ),
+    _done( false ),
+    _nc_rec( 0 )
+{
+    for ( unsigned n=0 ; n < _ring.size() ; ++n ) {
+        snapshot& snap = _ring[n] ;
+        snap.rho.resize( _num_de, _num_az ) ;
+        snap.theta.resize( _num_de, _num_az ) ;
+        snap.phi.resize( _num_de, _num_az ) ;
+        if ( single ) {
+            snap.altitude.resize( _num_de, _num_az ) ;
+            snap.latitude.resize( _num_de, _num_az ) ;
+            snap.longitude.resize( _num_de, _num_az ) ;
+        }
+        snap.surface.resize( _num_de, _num_az ) ;
+        snap.bottom.resize( _num_de, _num_az ) ;
+        snap.caustic.resize( _num_de, _num_az ) ;
+        snap.on_edge.resize( _num_de, _num_az ) ;
+    }
+
+    _nc_file = new NcFile( filename, NcFile::Replace );
+    if ( long_name ) {
+        _nc_file->add_att("long_name", long_name ) ;
+    }
+    _nc_file->add_att("Conventions", "COARDS" ) ;
+
+    // dimensions
+
+    NcDim *freq_dim = _nc_file->add_dim( "frequency", freq.size() ) ;
+    NcDim *de_dim   = _nc_file->add_dim( "source_de", _num_de ) ;
+    NcDim *az_dim   = _nc_file->add_dim( "source_az", _num_az ) ;
+    NcDim *time_dim = _nc_file->add_dim( "travel_time" ) ; // unlimited
+
+    // coordinates
+
+    NcVar *freq_var = _nc_file->add_var( "frequency", ncDouble, freq_dim ) ;
+    NcVar *de_var   = _nc_file->add_var( "source_de", ncDouble, de_dim ) ;
+    NcVar *az_var   = _nc_file->add_var( "source_az", ncDouble, az_dim ) ;
+    _nc_time        = _nc_file->add_var( "travel_time", ncDouble, time_dim ) ;
+    const NcType position_type = single ? ncFloat : ncDouble ;
+    _nc_latitude    = _nc_file->add_var( "latitude", position_type,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_longitude   = _nc_file->add_var( "longitude", position_type,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_altitude    = _nc_file->add_var( "altitude", position_type,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_surface     = _nc_file->add_var( "surface", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_bottom      = _nc_file->add_var( "bottom", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_caustic     = _nc_file->add_var( "caustic", ncShort,
+                      time_dim, de_dim, az_dim ) ;
+    _nc_on_edge     = _nc_file->add_var( "on_edge", ncByte,
+                      time_dim, de_dim, az_dim ) ;
+
+    // units
+
+    freq_var->add_att("units", "hertz") ;
+    de_var->add_att("units", "degrees") ;
+    de_var->add_att("positive", "up") ;
+    az_var->add_att("units", "degrees_true") ;
+    az_var->add_att("positive", "clockwise") ;
+    _nc_time->add_att("units", "seconds") ;
+    _nc_latitude->add_att("units", "degrees_north") ;
+    _nc_longitude->add_att("units", "degrees_east") ;
+    _nc_altitude->add_att("units", "meters") ;
+    _nc_altitude->add_att("positive", "up") ;
+    _nc_surface->add_att("units", "count") ;
+    _nc_bottom->add_att("units", "count") ;
+    _nc_caustic->add_att("units", "count") ;
+    _nc_on_edge->add_att("units", "bool") ;
+
+    // coordinate data
+
+    freq_var->put( vector<double>(freq).data().begin(), freq.size() ) ;
+    vector<double> angles( _num_de ) ;
+    for ( unsigned d=0 ; d < _num_de ; ++d ) {
+        angles(d) = de( d * _every_de ) ;
+    }
+    de_var->put( angles.data().begin(), _num_de ) ;
+    angles.resize( _num_az ) ;
+    for ( unsigned a=0 ; a < _num_az ; ++a ) {
+        angles(a) = az( a * _every_az ) ;
+    }
+    az_var->put( angles.data().begin(), _num_az ) ;
+
+    // start converter thread after all of the netCDF setup is complete
+
+    boost::thread converter( boost::bind( &wavefront_logger::run, this ) ) ;
+    _converter.swap( converter ) ;
+}
+
+/**
+ * Writes all pending snapshots, stops the converter thread,
+ * and closes the netCDF file.
+ */
+wavefront_logger::~wavefront_logger() {
+    flush() ;
+    {
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        _done = true ;
+    }
+    _ready.notify_one() ;
+    _converter.join() ;
+    delete _nc_file ; // destructor frees all netCDF temp variables
+}
+
+/**
+ * Queue a wavefront for recording.
+ */
+void wavefront_logger::save( double time, const wave_front& wave ) {
+    if ( _calls++ % _every_time ) return ;
+
+    // write converted snapshots until there is a free snapshot
+
+    snapshot* snap ;
+    while ( true ) {
+        write_converted() ;
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        if ( _pending < _ring.size() ) {
+            snap = &_ring[_head] ;
+            break ;
+        }
+        while ( _converted == 0 ) {
+            _finished.wait( lock ) ;
+        }
+    }
+
+    // copy raw fields without holding the lock
+    // the converter thread only touches snapshots that were handed to it
+
+    const slice de( 0, _every_de, _num_de ) ;
+    const slice az( 0, _every_az, _num_az ) ;
+    snap->time = time ;
+    noalias(snap->rho) = project( wave.position.rho(), de, az ) ;
+    noalias(snap->theta) = project( wave.position.theta(), de, az ) ;
+    noalias(snap->phi) = project( wave.position.phi(), de, az ) ;
+    noalias(snap->surface) = project( wave.surface, de, az ) ;
+    noalias(snap->bottom) = project( wave.bottom, de, az ) ;
+    noalias(snap->caustic) = project( wave.caustic, de, az ) ;
+    noalias(snap->on_edge) = project( wave.on_edge, de, az ) ;
+
+    // hand snapshot to the converter thread
+
+    {
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        _head = ( _head + 1 ) % _ring.size() ;
+        ++_pending ;
+    }
+    _ready.notify_one() ;
+}
+
+/**
+ * Waits for all pending snapshots to be converted, and writes them.
+ */
+void wavefront_logger::flush() {
+    {
+        boost::mutex::scoped_lock lock( _mutex ) ;
+        while ( _converted < _pending ) {
+            _finished.wait( lock ) ;
+        }
+    }
+    write_converted() ;
+    _nc_file->sync() ;
+}
+
+/**
+ * Main loop for the converter thread.
+ */
+void wavefront_logger::run() {
+    while ( true ) {
+        snapshot* snap ;
+        {
+            boost::mutex::scoped_lock lock( _mutex ) ;
+            while ( _converted == _pending && !_done ) {
+                _ready.wait( lock ) ;
+            }
+            if ( _converted == _pending ) return ;  // done, nothing to convert
+            snap = &_ring[_next] ;
+        }
+        convert( *snap ) ;
+        {
+            boost::mutex::scoped_lock lock( _mutex ) ;
+            _next = ( _next + 1 ) % _ring.size() ;
+            ++_converted ;
+        }
+        _finished.notify_one() ;
+    }
+}
+
+/**
+ * Convert a single snapshot to latitude, longitude, and altitude.
+ */
+void wavefront_logger::convert( snapshot& snap ) const {
+    noalias(snap.theta) = to_latitude( snap.theta ) ;
+    noalias(snap.phi) = to_degrees( snap.phi ) ;
+    noalias(snap.rho) = snap.rho - wposition::earth_radius ;
+    if ( _single ) {
+        noalias(snap.latitude) = snap.theta ;
+        noalias(snap.longitude) = snap.phi ;
+        noalias(snap.altitude) = snap.rho ;
+    }
+}
+
+/**
+ * Append all of the converted snapshots to the netCDF file.
+ */
+void wavefront_logger::write_converted() {
+    NcError nc_error( NcError::verbose_nonfatal ) ;
+    while ( true ) {
+        const snapshot* snap ;
+        {
+            boost::mutex::scoped_lock lock( _mutex ) ;
+            if ( _converted == 0 ) return ;
+            snap = &_ring[_tail] ;
+        }
+        write( *snap ) ;
+        {
+            boost::mutex::scoped_lock lock( _mutex ) ;
+            _tail = ( _tail + 1 ) % _ring.size() ;
+            --_converted ;
+            --_pending ;
+        }
+    }
+}
+
+/**
+ * Append a single converted snapshot to the netCDF file.
+ */
+void wavefront_logger::write( const snapshot& snap ) {
+    _nc_time->put_rec( &snap.time, _nc_rec ) ;
+    if ( _single ) {
+        _nc_latitude->put_rec( snap.latitude.data().begin(), _nc_rec ) ;
+        _nc_longitude->put_rec( snap.longitude.data().begin(), _nc_rec ) ;
+        _nc_altitude->put_rec( snap.altitude.data().begin(), _nc_rec ) ;
+    } else {
+        _nc_latitude->put_rec( snap.theta.data().begin(), _nc_rec ) ;
+        _nc_longitude->put_rec( snap.phi.data().begin(), _nc_rec ) ;
+        _nc_altitude->put_rec( snap.rho.data().begin(), _nc_rec ) ;
+    }
+    _nc_surface->put_rec( snap.surface.data().begin(), _nc_rec ) ;
+    _nc_bottom->put_rec( snap.bottom.data().begin(), _nc_rec ) ;
+    _nc_caustic->put_rec( snap.caustic.data().begin(), _nc_rec ) ;
+    _nc_on_edge->put_rec( (const ncbyte*) snap.on_edge.data().begin(),
+                          _nc_rec ) ;
+    ++_nc_rec ;
+}
@@ -0,0 +1,208 @@
+/**
+ * @file wavefront_logger.h
+ * Records wavefronts to a netCDF log, with the help of a background thread.
+ */
+#ifndef USML_WAVEQ3D_WAVEFRONT_LOGGER_H
+#define USML_WAVEQ3D_WAVEFRONT_LOGGER_H
+
+#include <usml/waveq3d/wave_front.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <netcdfcpp.h>
+#include <vector>
+
+namespace usml {
+namespace waveq3d {
+
+using namespace usml::ocean ;
+
+/// @ingroup waveq3d
+/// @{
+
+/**
+ * Records wavefronts to a netCDF log, with the help of a background thread.
+ * The propagation loop only copies the raw position and path count
+ * fields of each wavefront into a ring of pre-allocated snapshots.
+ * A converter thread converts these snapshots to latitude, longitude,
+ * and altitude.  Converted snapshots are appended to the netCDF file by
+ * the thread that owns this logger, during later calls to save(),
+ * flush(), and the destructor.  If the converter falls behind, and all
+ * of the snapshots in the ring are full, save() blocks until the oldest
+ * snapshot has been converted.
+ *
+ * The log can be decimated in time, by only recording every Nth call
+ * to save(), and in launch angle, by only recording every Nth D/E
+ * or AZ ray.  The source_de and source_az coordinates of the log
+ * are decimated to match.  Latitude, longitude, and altitude can be
+ * stored as float to halve the size of the log.  The conversion to
+ * geodetic coordinates is always computed in double precision.
+ *
+ * The netCDF library is not thread safe.  Only the thread that owns
+ * this logger makes netCDF calls, so that thread can use other netCDF
+ * files between calls to save().  Other threads must not use the netCDF
+ * library while this logger is open.
+ */
+class USML_DECLSPEC wavefront_logger {
+
+public:
+
+    /**
+     * Opens the file, records initial conditions, and starts the
+     * converter thread.  See wave_queue::init_netcdf() for file structure.
+     *
+     * @param   filename    Name of the file to write to disk.
+     * @param   long_name   Optional global attribute for identifying data-set.
+     * @param   freq        Frequencies over which propagation is computed (Hz).
+     * @param   de          Launch D/E angles (degrees).
+     * @param   az          Launch AZ angles (degrees).
+     * @param   every_time  Record one out of every N calls to save().
+     * @param   every_de    Record one out of every N rays in D/E direction.
+     * @param   every_az    Record one out of every N rays in AZ direction.
+     * @param   single      Store positions as float, if true.
+     * @param   num_buffers Number of snapshots in the ring.
+     * @throws  std::invalid_argument if any decimation factor,
+     *          or the number of buffers, is zero.
+     */
+    wavefront_logger( const char* filename, const char* long_name,
+        const seq_vector& freq, const seq_vector& de, const seq_vector& az,
+        unsigned every_time = 1, unsigned every_de = 1, unsigned every_az = 1,
+        bool single = false, unsigned num_buffers = 4 ) ;
+
+    /**
+     * Writes all pending snapshots, stops the converter thread,
+     * and closes the netCDF file.
+     */
+    ~wavefront_logger() ;
+
+    /**
+     * Queue a wavefront for recording.  Writes any snapshots that
+     * have already been converted.  Blocks if the ring of snapshots
+     * is full, until the oldest snapshot has been converted.
+     *
+     * @param   time        Travel time of this wavefront (seconds).
+     * @param   wave        Wavefront to record.
+     */
+    void save( double time, const wave_front& wave ) ;
+
+    /**
+     * Waits for all pending snapshots to be converted, writes them
+     * to the netCDF file, and flushes the file to disk.
+     */
+    void flush() ;
+
+private:
+
+    /**
+     * Copy of the wavefront fields that are needed for a log record.
+     * The converter thread replaces rho, theta, and phi with altitude,
+     * latitude, and longitude.  Single precision copies of the
+     * converted positions are only allocated if _single is true.
+     */
+    struct snapshot {
+        double time ;
+        matrix<double> rho ;
+        matrix<double> theta ;
+        matrix<double> phi ;
+        matrix<float> altitude ;
+        matrix<float> latitude ;
+        matrix<float> longitude ;
+        matrix<int> surface ;
+        matrix<int> bottom ;
+        matrix<int> caustic ;
+        matrix<bool> on_edge ;
+    } ;
+
+    /** Number of D/E rays in each snapshot. */
+    const unsigned _num_de ;
+
+    /** Number of AZ rays in each snapshot. */
+    const unsigned _num_az ;
+
+    /** Decimation factors in time, D/E, and AZ. */
+    const unsigned _every_time, _every_de, _every_az ;
+
+    /** Store positions as float, if true. */
+    const bool _single ;
+
+    /** Number of calls to save() so far. */
+    unsigned _calls ;
+
+    /** Ring of pre-allocated snapshots. */
+    std::vector< snapshot > _ring ;
+
+    /** Index of the next snapshot to fill. */
+    unsigned _head ;
+
+    /** Index of the next snapshot to convert. */
+    unsigned _next ;
+
+    /** Index of the next snapshot to write. */
+    unsigned _tail ;
+
+    /** Number of snapshots that have been filled, but not written. */
+    unsigned _pending ;
+
+    /** Number of snapshots that have been converted, but not written. */
+    unsigned _converted ;
+
+    /** Set to true to tell the converter thread to exit. */
+    bool _done ;
+
+    /** Protects the ring indices, the counts, and _done. */
+    boost::mutex _mutex ;
+
+    /** Signals the converter thread that a snapshot is ready. */
+    boost::condition_variable _ready ;
+
+    /** Signals the owning thread that a snapshot has been converted. */
+    boost::condition_variable _finished ;
+
+    /** The netCDF file used to record the wavefront log. */
+    NcFile* _nc_file ;
+
+    /** The netCDF variables used to record the wavefront log. */
+    NcVar *_nc_time, *_nc_latitude, *_nc_longitude, *_nc_altitude,
+          *_nc_surface, *_nc_bottom, *_nc_caustic, *_nc_on_edge ;
+
+    /** Current record number in netCDF file. */
+    int _nc_rec ;
+
+    /** Background thread that converts snapshots to geodetic coordinates. */
+    boost::thread _converter ;
+
+    /** Main loop for the converter thread. */
+    void run() ;
+
+    /**
+     * Convert a single snapshot to latitude, longitude, and altitude.
+     * Only called from the converter thread.
+     *
+     * @param   snap        Snapshot to convert.
+     */
+    void convert( snapshot& snap ) const ;
+
+    /**
+     * Append all of the converted snapshots to the netCDF file.
+     * Only called from the thread that owns this logger.
+     */
+    void write_converted() ;
+
+    /**
+     * Append a single converted snapshot to the netCDF file.
+     *
+     * @param   snap        Snapshot to write.
+     */
+    void write( const snapshot& snap ) ;
+
+    // prevent copies of the converter thread
+
+    wavefront_logger( const wavefront_logger& ) ;
+    wavefront_logger& operator=( const wavefront_logger& ) ;
+} ;
+
+/// @}
+}  // end of namespace waveq3d
+}  // end of namespace usml
+
+#endif
@@ -118,5 +118,7 @@
 #include <usml/waveq3d/wave_front.h>
 #include <usml/waveq3d/eigenray.h>
 #include <usml/waveq3d/proploss.h>
+#include <usml/waveq3d/eigenray_archive.h>
+#include <usml/waveq3d/eigenray_strongest.h>
 
 #endif